@@ -0,0 +1,292 @@
+#include <benchmark/benchmark.h>
+
+#include <dsk/task.hpp>
+#include <dsk/generator.hpp>
+#include <dsk/until.hpp>
+#include <dsk/sync_wait.hpp>
+#include <dsk/start_on.hpp>
+#include <dsk/resume_on.hpp>
+#include <dsk/res_pool.hpp>
+#include <dsk/res_queue.hpp>
+#include <dsk/inline_scheduler.hpp>
+#include <dsk/tbb/thread_pool.hpp>
+#include <dsk/asio/thread_pool.hpp>
+#include <dsk/simple_thread_pool.hpp>
+
+
+// Each benchmark iteration runs a batch of ops in one sync_wait(), so its cost is amortized,
+// and items_per_second is ops per second. For ping-pong, an item is one hop, so latency = 1 / rate.
+//
+// Results are written as json with:
+//      bench_basic --benchmark_out=result.json --benchmark_out_format=json
+// or the run_bench target. Compare two results with compare.py of google benchmark.
+
+
+using namespace dsk;
+
+
+namespace{
+
+
+constexpr int64_t batch_size = 1000;
+
+
+void check(auto const& r, benchmark::State& state)
+{
+    if(has_err(r))
+    {
+        state.SkipWithError("op failed");
+    }
+}
+
+
+// task create/await/destroy
+
+void bm_task_await(benchmark::State& state)
+{
+    for(auto _ : state)
+    {
+        auto r = sync_wait([]() -> task<int64_t>
+        {
+            int64_t sum = 0;
+
+            for(int64_t i = 0; i < batch_size; ++i)
+            {
+                sum += DSK_TRY [](int64_t i) -> task<int64_t>
+                {
+                    DSK_RETURN(i);
+                }(i);
+            }
+
+            DSK_RETURN(sum);
+        }());
+
+        check(r, state);
+    }
+
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+BENCHMARK(bm_task_await);
+
+
+// generator yield throughput
+
+void bm_generator_yield(benchmark::State& state)
+{
+    for(auto _ : state)
+    {
+        auto r = sync_wait([]() -> task<int64_t>
+        {
+            auto gen = []() -> generator<int64_t>
+            {
+                for(int64_t i = 0; i < batch_size; ++i)
+                {
+                    DSK_YIELD i;
+                }
+
+                DSK_RETURN();
+            }();
+
+            int64_t sum = 0;
+
+            while(auto v = DSK_TRY gen.next())
+            {
+                sum += *v;
+            }
+
+            DSK_RETURN(sum);
+        }());
+
+        check(r, state);
+    }
+
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+BENCHMARK(bm_generator_yield);
+
+
+// res_queue single producer/consumer throughput, arg: capacity
+
+void bm_res_queue(benchmark::State& state)
+{
+    simple_thread_pool pool(2, start_now);
+
+    for(auto _ : state)
+    {
+        res_queue<int64_t> queue(static_cast<size_t>(state.range(0)));
+
+        auto r = sync_wait(until_all_done
+        (
+            start_on(pool, [&]() -> task<>
+            {
+                for(int64_t i = 0; i < batch_size; ++i)
+                {
+                    DSK_TRY queue.enqueue(i);
+                }
+
+                queue.mark_end();
+                DSK_RETURN();
+            }()),
+            start_on(pool, [&]() -> task<int64_t>
+            {
+                int64_t sum = 0;
+
+                for(;;)
+                {
+                    auto v = DSK_WAIT queue.dequeue();
+
+                    if(has_err(v))
+                    {
+                        break;
+                    }
+
+                    sum += get_val(v);
+                }
+
+                DSK_RETURN(sum);
+            }())
+        ));
+
+        check(r, state);
+    }
+
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+BENCHMARK(bm_res_queue)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+
+// res_pool acquire/release by 8 tasks on 4 threads, arg: pool capacity
+
+void bm_res_pool(benchmark::State& state)
+{
+    constexpr int64_t n_tasks = 8;
+
+    simple_thread_pool pool(4, start_now);
+
+    for(auto _ : state)
+    {
+        res_pool<> resPool(static_cast<size_t>(state.range(0)));
+
+        auto r = sync_wait(until_all_done(n_tasks, [&]()
+        {
+            return start_on(pool, [&]() -> task<>
+            {
+                for(int64_t i = 0; i < batch_size / n_tasks; ++i)
+                {
+                    auto v = DSK_TRY resPool.acquire();
+                    v.recycle();
+                }
+
+                DSK_RETURN();
+            }());
+        }));
+
+        check(r, state);
+    }
+
+    state.SetItemsProcessed(state.iterations() * (batch_size / n_tasks) * n_tasks);
+}
+
+BENCHMARK(bm_res_pool)->Arg(1)->Arg(4)->Arg(8)->UseRealTime();
+
+
+// until_all_done fan-out of trivial tasks, arg: number of tasks
+
+void bm_until_all_done_inline(benchmark::State& state)
+{
+    for(auto _ : state)
+    {
+        auto r = sync_wait(until_all_done(static_cast<size_t>(state.range(0)), []()
+        {
+            return []() -> task<>
+            {
+                DSK_RETURN();
+            }();
+        }));
+
+        check(r, state);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(bm_until_all_done_inline)->Arg(10)->Arg(100)->Arg(1000);
+
+
+void bm_until_all_done_pool(benchmark::State& state)
+{
+    simple_thread_pool pool(start_now);
+
+    for(auto _ : state)
+    {
+        auto r = sync_wait(until_all_done(static_cast<size_t>(state.range(0)), [&]()
+        {
+            return start_on(pool, []() -> task<>
+            {
+                DSK_RETURN();
+            }());
+        }));
+
+        check(r, state);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(bm_until_all_done_pool)->Arg(10)->Arg(100)->Arg(1000)->UseRealTime();
+
+
+// ping-pong resume latency: a coroutine hops between two single threaded schedulers.
+
+template<class Sch>
+struct sch_pair
+{
+    Sch a{1, start_now};
+    Sch b{1, start_now};
+};
+
+template<>
+struct sch_pair<inline_scheduler>
+{
+    inline_scheduler a;
+    inline_scheduler b;
+};
+
+template<class Sch>
+void bm_ping_pong(benchmark::State& state)
+{
+    sch_pair<Sch> sp;
+
+    for(auto _ : state)
+    {
+        auto r = sync_wait([&]() -> task<>
+        {
+            for(int64_t i = 0; i < batch_size / 2; ++i)
+            {
+                DSK_TRY resume_on(sp.a);
+                DSK_TRY resume_on(sp.b);
+            }
+
+            DSK_RETURN();
+        }());
+
+        check(r, state);
+    }
+
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+BENCHMARK(bm_ping_pong<inline_scheduler>);
+BENCHMARK(bm_ping_pong<simple_thread_pool>)->UseRealTime();
+BENCHMARK(bm_ping_pong<asio_thread_pool>)->UseRealTime();
+BENCHMARK(bm_ping_pong<asio_io_thread_pool>)->UseRealTime();
+BENCHMARK(bm_ping_pong<tbb_thread_pool>)->UseRealTime();
+
+
+} // namespace
+
+
+BENCHMARK_MAIN();
@@ -1,5 +1,6 @@
 #include <dsk/sync_wait.hpp>
 #include <dsk/util/debug.hpp>
+#include <dsk/async_op_group.hpp>
 #include <dsk/http/file_handler.hpp>
 
 
@@ -21,7 +22,8 @@ int main(int argc, char* argv[])
 
             //fileHandler.set_cache_control(std::chrono::seconds(10), "public");
 
-            auto opGrp = DSK_WAIT make_async_op_group();
+            // one op per connection, node of finished op is recycled by later ones.
+            auto opGrp = DSK_WAIT make_pooled_async_op_group();
 
             for(;;)
             {
@@ -17,6 +17,7 @@
 #include <dsk/compr/auto_decompressor.hpp>
 #include <dsk/asio/file.hpp>
 #include <dsk/res_queue.hpp>
+#include <dsk/lf_res_queue.hpp>
 #include <dsk/sync_wait.hpp>
 #include <dsk/start_on.hpp>
 #include <dsk/until.hpp>
@@ -420,9 +421,9 @@ public:
 
 
 constexpr size_t fileReadBatchSize = 1*1024*1024;
-res_queue<string    > decompressQueue{3};
-res_queue<wiki_lines>      parseQueue{26};
-res_queue<wiki_item >    writeDbQueue{126};
+res_queue_spsc<string    > decompressQueue{4};
+res_queue_mpmc<wiki_lines>      parseQueue{32};
+res_queue     <wiki_item >    writeDbQueue{126};
 
 auto gen_queue_report(char const* name, auto& q)
 {
@@ -2,6 +2,8 @@
 
 #include <dsk/resumer.hpp>
 #include <dsk/inline_scheduler.hpp>
+#include <dsk/trace.hpp>
+#include <dsk/util/vector.hpp>
 
 
 namespace dsk{
@@ -11,6 +13,7 @@ class any_resumer
 {
     void* _sch = nullptr;
     void (*_post)(void*, continuation&&) = nullptr;
+    void (*_postBulk)(void*, std::span<continuation>) = nullptr;
 
     static continuation&& to_cont(continuation&& cont) noexcept { return mut_move(cont); }
     static continuation to_cont(auto&& cont) { return DSK_FORWARD(cont); }
@@ -29,6 +32,10 @@ public:
           {
               static_cast<DSK_NO_REF_T(sch)*>(s)->post(mut_move(c));
           })
+        , _postBulk([](void* s, std::span<continuation> cs)
+          {
+              dsk::post_bulk(*static_cast<DSK_NO_REF_T(sch)*>(s), cs);
+          })
     {}
 
     any_resumer(_resumer_ auto&& r) noexcept requires(! _no_cvref_same_as_<decltype(r), any_resumer>)
@@ -51,9 +58,42 @@ public:
         else
         {
             DSK_ASSERT(_post);
+            trace(trace_post, _sch);
             _post(_sch, to_cont(DSK_FORWARD(cont)));
         }
     }
+
+    // Elements of conts are moved from.
+    // If underlying scheduler is not a _bulk_scheduler_, each one is posted separately.
+    void post_bulk(std::ranges::range auto&& conts)
+    {
+        if(is_inline())
+        {
+            for(auto&& c : conts)
+            {
+                c();
+            }
+        }
+        else if constexpr(std::ranges::contiguous_range<decltype(conts)>
+                          && _same_as_<std::ranges::range_value_t<decltype(conts)>, continuation>)
+        {
+            DSK_ASSERT(_postBulk);
+            _postBulk(_sch, std::span<continuation>(conts));
+        }
+        else
+        {
+            DSK_ASSERT(_postBulk);
+
+            vector<continuation> cs;
+
+            for(auto&& c : conts)
+            {
+                cs.emplace_back(mut_move(c));
+            }
+
+            _postBulk(_sch, cs);
+        }
+    }
 };
 
 
@@ -39,4 +39,15 @@ auto asio_invoke_and_return_expected(auto* p, auto m, auto&&... args)
 }
 
 
+// io_context run by calling thread and the scheduler owning the thread, set by io thread pools,
+// so completions on that io_context are resumed inline for that scheduler, see resume(cont, sr, exc).
+struct io_thread_binding
+{
+    void const* ctx = nullptr;
+    void const* sch = nullptr;
+};
+
+inline thread_local io_thread_binding tl_io_thread;
+
+
 } // namespace dsk
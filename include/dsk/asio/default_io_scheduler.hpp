@@ -9,7 +9,11 @@
     {
         inline auto& get_default_io_scheduler()
         {
+        #if defined(DSK_DEFAULT_IO_SCHEDULER_USE_SHARDED)
+            static asio_sharded_io_thread_pool ioSch;
+        #else
             static asio_io_thread_pool ioSch;
+        #endif
             return ioSch;
         }
     }
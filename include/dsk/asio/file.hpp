@@ -195,4 +195,14 @@ public:
 };
 
 
+// A socket whose file descriptor can be used by sendfile()/splice() directly, e.g. tcp_socket, but not ssl streams.
+template<class S>
+concept _fd_socket_ = requires(S& s)
+{
+    { s.native_handle() } -> std::same_as<int>;
+    { s.native_non_blocking(true) } -> std::same_as<error_code>;
+    s.wait(S::wait_write);
+};
+
+
 } // namespace dsk
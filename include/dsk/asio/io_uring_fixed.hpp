@@ -0,0 +1,908 @@
+#pragma once
+
+#include <dsk/res_pool.hpp>
+#include <dsk/res_queue.hpp>
+#include <dsk/async_event.hpp>
+#include <dsk/optional.hpp>
+#include <dsk/util/mutex.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/vector.hpp>
+#include <dsk/util/function.hpp>
+#include <dsk/util/unordered.hpp>
+#include <dsk/util/small_vector.hpp>
+#include <dsk/asio/config.hpp>
+#include <dsk/asio/use_async_op.hpp>
+#include <dsk/asio/default_io_scheduler.hpp>
+#include <dsk/asio/file.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/associated_cancellation_slot.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <liburing.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include <bit>
+
+
+// Requires ENABLE_IO_URING, see README.md
+
+
+namespace dsk{
+
+
+struct io_uring_fixed_options
+{
+    unsigned entries      = 256;     // submission queue size of the ring.
+    size_t   bufCount     = 64;      // number of registered buffers, 0 to not register.
+    size_t   bufSize      = 64*1024; // bytes of each buffer, rounded up to page size.
+    unsigned fileCount    = 64;      // slots of fixed file table, 0 to not register.
+    size_t   recvBufCount = 0;       // provided buffers of multishot recv, rounded up to power of 2, 0 to not provide.
+    size_t   recvBufSize  = 16*1024; // bytes of each provided buffer.
+    unsigned submitBatch  = 32;      // queued sqes to submit right away, fewer are submitted by a flush posted to io_context.
+};
+
+
+// A registered buffer, leased from io_uring_fixed_service::acquire_buf().
+struct io_uring_fixed_buf
+{
+    std::byte* data  = nullptr;
+    size_t     size  = 0;
+    unsigned   index = 0; // buf_index of READ_FIXED/WRITE_FIXED
+};
+
+
+// A slot of fixed file table, see io_uring_fixed_service::register_file().
+struct io_uring_fixed_file
+{
+    unsigned slot = 0;
+};
+
+
+template<class T>
+concept _io_uring_fixed_target_ = _same_as_<T, int> || _same_as_<T, io_uring_fixed_file>;
+
+
+// A completion of multishot op.
+struct io_uring_cqe_result
+{
+    int      res   = 0;
+    unsigned flags = 0;
+
+    // false if it's the last one, and the op should be restarted to get more.
+    bool more() const noexcept { return flags & IORING_CQE_F_MORE; }
+
+    bool     has_buf() const noexcept { return flags & IORING_CQE_F_BUFFER; }
+    unsigned buf_id () const noexcept { return flags >> IORING_CQE_BUFFER_SHIFT; }
+};
+
+
+class io_uring_fixed_service;
+
+
+// Completions of a multishot op are queued here until consumed.
+// Shared by the service and io_uring_multishot, so it lives until the op is finished,
+// and resources of unconsumed completions, e.g. accepted fd, are released by 'release'.
+struct io_uring_multishot_state
+{
+    using release_fn = void(*)(io_uring_fixed_service&, io_uring_cqe_result const&);
+
+    io_uring_fixed_service&         svc;
+    release_fn                      release = nullptr;
+    res_queue<io_uring_cqe_result>  cqes{SIZE_MAX};
+
+    io_uring_multishot_state(io_uring_fixed_service& s, release_fn r) noexcept
+        : svc(s), release(r)
+    {}
+
+    ~io_uring_multishot_state()
+    {
+        for(;;)
+        {
+            auto c = cqes.try_dequeue();
+
+            if(has_err(c))
+            {
+                break;
+            }
+
+            if(release)
+            {
+                release(svc, get_val(c));
+            }
+        }
+    }
+};
+
+
+// Handle of a multishot op, see io_uring_fixed_service::start_multishot().
+// The op is canceled on destruction.
+class io_uring_multishot
+{
+    friend class io_uring_fixed_service;
+
+    uint64_t                                  _id = 0;
+    std::shared_ptr<io_uring_multishot_state> _st;
+
+    io_uring_multishot(uint64_t id, std::shared_ptr<io_uring_multishot_state> st) noexcept
+        : _id(id), _st(mut_move(st))
+    {}
+
+public:
+    io_uring_multishot() = default;
+
+    io_uring_multishot(io_uring_multishot&& r) noexcept
+        : _id(r._id), _st(mut_move(r._st))
+    {}
+
+    io_uring_multishot& operator=(io_uring_multishot&& r) noexcept
+    {
+        if(this != &r)
+        {
+            stop();
+            _id = r._id;
+            _st = mut_move(r._st);
+        }
+
+        return *this;
+    }
+
+    ~io_uring_multishot()
+    {
+        stop();
+    }
+
+    explicit operator bool() const noexcept { return static_cast<bool>(_st); }
+
+    // Next completion, waits if none.
+    // Result type: expected<io_uring_cqe_result, errc>
+    auto next()
+    {
+        DSK_ASSERT(_st);
+        return _st->cqes.dequeue();
+    }
+
+    // Cancel the op if not finished, unconsumed completions are released once it's finished.
+    void stop();
+};
+
+
+// Registered buffers and fixed files of one io_context, so hot I/O can use READ_FIXED/WRITE_FIXED
+// without page pinning and fd lookup of each op.
+//
+// asio doesn't expose its ring, so the service owns another one, of which completions are
+// signaled by an eventfd read on the io_context, and handlers are invoked there.
+// It's opt-in, nothing is created until init() is called:
+//
+//      auto& svc = get_io_uring_fixed_service(ioc);
+//      DSK_TRY_SYNC svc.init({.bufCount = 256, .bufSize = 64*1024});
+//
+//      auto b = DSK_TRY svc.acquire_buf();  // waits if all leased, returned to pool on destruction.
+//      size_t n = DSK_TRY read_some_fixed_at(file, offset, *b);
+//
+// It also runs multishot ops, e.g. accept and recv into provided buffers, see io_uring_stream.hpp.
+//
+// All ops should be finished before the io_context is destroyed.
+class io_uring_fixed_service : public asio::execution_context::service
+{
+    friend class io_uring_multishot;
+
+    struct buf_creator
+    {
+        io_uring_fixed_service* svc = nullptr;
+        unsigned                next = 0;
+
+        void operator()(auto emplace)
+        {
+            emplace(svc->_bufMem + static_cast<size_t>(next) * svc->_bufSize, svc->_bufSize, next);
+            ++next;
+        }
+    };
+
+    using buf_pool     = res_pool<io_uring_fixed_buf, buf_creator>;
+    using handler_type = unique_function<void(error_code const&, size_t), DSK_DEFAULT_ALLOCATOR<void>, 64>;
+
+public:
+    inline static asio::execution_context::id id;
+
+    using buf_ref = std::remove_cvref_t<decltype(get_val(std::declval<buf_pool&>().try_acquire()))>;
+
+private:
+    asio::io_context&              _ioc;
+    mutex                          _mtx; // guards submission queue, _inflight and _freeFileSlots.
+    io_uring                       _ring{};
+    bool                           _inited = false;
+    asio::posix::stream_descriptor _efd;
+    uint64_t                       _efdVal = 0;
+    std::byte*                     _bufMem = nullptr;
+    size_t                         _bufSize = 0;
+    optional<buf_pool>             _bufs;
+    vector<unsigned>               _freeFileSlots;
+    atomic<uint64_t>               _nextId{1}; // 0 is for cancel requests.
+    unsigned                       _submitBatch = 32;
+    bool                           _flushPosted = false;
+
+    // provided buffers of multishot recv.
+    io_uring_buf_ring*             _recvBr = nullptr;
+    std::byte*                     _recvMem = nullptr;
+    size_t                         _recvBufSize = 0;
+    unsigned                       _recvBufCount = 0;
+    unsigned                       _recvBufFree = 0; // in ring, not taken by kernel.
+    async_event                    _recvBufEv;       // set when _recvBufFree turns non-zero.
+
+    static constexpr unsigned recv_buf_group = 0;
+
+    // ms is set for multishot op, of which completions are queued into it instead of calling h.
+    struct inflight_op
+    {
+        handler_type                              h;
+        std::shared_ptr<io_uring_multishot_state> ms;
+    };
+
+    // ops are identified by id rather than address, so a late cancel can't hit a reused one.
+    unstable_unordered_map<uint64_t, inflight_op> _inflight;
+
+    static error_code sys_err(int e) noexcept
+    {
+        return error_code(e, system_category());
+    }
+
+    void arm_reaper()
+    {
+        _efd.async_read_some(asio::buffer(&_efdVal, sizeof(_efdVal)), [this](error_code const& ec, size_t)
+        {
+            if(ec == asio::error::operation_aborted)
+            {
+                return;
+            }
+
+            reap();
+            arm_reaper();
+        });
+    }
+
+    void reap()
+    {
+        small_vector<std::pair<inflight_op, io_uring_cqe_result>, 16> done;
+
+        {
+            lock_guard lg(_mtx);
+
+            io_uring_cqe* cqe = nullptr;
+            unsigned      head = 0;
+            unsigned      n = 0;
+
+            io_uring_for_each_cqe(&_ring, head, cqe)
+            {
+                ++n;
+
+                if(cqe->flags & IORING_CQE_F_BUFFER)
+                {
+                    --_recvBufFree;
+                }
+
+                if(uint64_t id = io_uring_cqe_get_data64(cqe))
+                {
+                    if(auto it = _inflight.find(id); it != _inflight.end())
+                    {
+                        io_uring_cqe_result c{cqe->res, cqe->flags};
+
+                        if(c.more())
+                        {
+                            done.emplace_back(inflight_op{{}, it->second.ms}, c);
+                        }
+                        else
+                        {
+                            done.emplace_back(mut_move(it->second), c);
+                            _inflight.erase(it);
+                        }
+                    }
+                }
+            }
+
+            io_uring_cq_advance(&_ring, n);
+        }
+
+        for(auto& [op, c] : done)
+        {
+            if(op.ms)
+            {
+                op.ms->cqes.try_enqueue(c);
+            }
+            else if(c.res < 0)
+            {
+                op.h(sys_err(-c.res), 0);
+            }
+            else
+            {
+                op.h(error_code(), static_cast<size_t>(c.res));
+            }
+        }
+    }
+
+    // with _mtx locked
+    io_uring_sqe* get_sqe_no_lock()
+    {
+        io_uring_sqe* sqe = io_uring_get_sqe(&_ring);
+
+        if(! sqe) // queue full, flush it.
+        {
+            io_uring_submit(&_ring);
+            sqe = io_uring_get_sqe(&_ring);
+        }
+
+        return sqe;
+    }
+
+    // with _mtx locked, after an sqe is queued.
+    // Rather than a syscall per op, sqes are submitted in batches: all queued ones are submitted
+    // by a flush posted to io_context, or right away once _submitBatch are queued.
+    // If submission failed, sqes are left in queue and submitted with next batch.
+    // Return true if caller should post the flush, which is done out of lock.
+    bool on_sqe_queued_no_lock()
+    {
+        if(io_uring_sq_ready(&_ring) >= _submitBatch)
+        {
+            io_uring_submit(&_ring);
+            return false;
+        }
+
+        return ! std::exchange(_flushPosted, true);
+    }
+
+    void post_flush()
+    {
+        asio::post(_ioc, [this]()
+        {
+            lock_guard lg(_mtx);
+
+            _flushPosted = false;
+            io_uring_submit(&_ring);
+        });
+    }
+
+    void submit(uint64_t id, auto&& prep, inflight_op&& op)
+    {
+        {
+            unique_lock lk(_mtx);
+
+            if(io_uring_sqe* sqe = get_sqe_no_lock())
+            {
+                prep(sqe);
+                io_uring_sqe_set_data64(sqe, id);
+
+                _inflight.emplace(id, mut_move(op));
+
+                if(on_sqe_queued_no_lock())
+                {
+                    lk.unlock();
+                    post_flush();
+                }
+
+                return;
+            }
+        }
+
+        asio::post(_ioc, [op = mut_move(op)]() mutable
+        {
+            if(op.ms) op.ms->cqes.try_enqueue(io_uring_cqe_result{-EBUSY, 0});
+            else      op.h(errc::out_of_capacity, 0);
+        });
+    }
+
+    void cancel(uint64_t id)
+    {
+        {
+            lock_guard lg(_mtx);
+
+            if(! _inflight.contains(id))
+            {
+                return;
+            }
+
+            io_uring_sqe* sqe = get_sqe_no_lock();
+
+            if(! sqe)
+            {
+                return;
+            }
+
+            io_uring_prep_cancel64(sqe, id, 0);
+            io_uring_sqe_set_data64(sqe, 0);
+
+            if(! on_sqe_queued_no_lock())
+            {
+                return;
+            }
+        }
+
+        post_flush();
+    }
+
+    // with _mtx locked
+    error_code init_recv_bufs_no_lock(size_t count, size_t size)
+    {
+        DSK_ASSERT(count <= 32768); // limit of buf ring entries
+
+        _recvBufCount = static_cast<unsigned>(std::bit_ceil(count));
+        _recvBufSize  = size;
+        _recvMem      = static_cast<std::byte*>(std::malloc(_recvBufSize * _recvBufCount));
+
+        if(! _recvMem)
+        {
+            return sys_err(ENOMEM);
+        }
+
+        int r = 0;
+        _recvBr = io_uring_setup_buf_ring(&_ring, _recvBufCount, recv_buf_group, 0, &r);
+
+        if(! _recvBr)
+        {
+            return sys_err(-r);
+        }
+
+        for(unsigned i = 0; i < _recvBufCount; ++i)
+        {
+            io_uring_buf_ring_add(_recvBr, _recvMem + i * _recvBufSize, static_cast<unsigned>(_recvBufSize),
+                                  static_cast<unsigned short>(i), io_uring_buf_ring_mask(_recvBufCount),
+                                  static_cast<int>(i));
+        }
+
+        io_uring_buf_ring_advance(_recvBr, static_cast<int>(_recvBufCount));
+        _recvBufFree = _recvBufCount;
+        return {};
+    }
+
+    static void release_accepted(io_uring_fixed_service&, io_uring_cqe_result const& c)
+    {
+        if(c.res >= 0)
+        {
+            ::close(c.res);
+        }
+    }
+
+    static void release_recv_buf(io_uring_fixed_service& svc, io_uring_cqe_result const& c)
+    {
+        if(c.has_buf())
+        {
+            svc.recycle_recv_buf(c.buf_id());
+        }
+    }
+
+    struct initiate_rw
+    {
+        io_uring_fixed_service* _svc;
+        int                     _fd;
+        bool                    _fixedFile;
+        bool                    _write;
+        uint64_t                _offset;
+        std::byte*              _data;
+        unsigned                _n;
+        unsigned                _bufIndex;
+
+        using executor_type = async_op_io_ctx_executor;
+
+        executor_type get_executor() const noexcept { return _svc->_ioc.get_executor(); }
+
+        void operator()(auto&& h) const
+        {
+            auto prep = [this](io_uring_sqe* sqe)
+            {
+                if(_write) io_uring_prep_write_fixed(sqe, _fd, _data, _n, _offset, static_cast<int>(_bufIndex));
+                else       io_uring_prep_read_fixed (sqe, _fd, _data, _n, _offset, static_cast<int>(_bufIndex));
+
+                if(_fixedFile)
+                {
+                    sqe->flags |= IOSQE_FIXED_FILE;
+                }
+            };
+
+            uint64_t id = _svc->_nextId.fetch_add(1, memory_order_relaxed);
+            auto slot = asio::get_associated_cancellation_slot(h);
+
+            if(slot.is_connected())
+            {
+                slot.assign([svc = _svc, id](asio::cancellation_type){ svc->cancel(id); });
+
+                _svc->submit(id, prep, {[h = DSK_FORWARD(h), slot](error_code const& ec, size_t n) mutable
+                {
+                    slot.clear();
+                    mut_move(h)(ec, n);
+                }});
+            }
+            else
+            {
+                _svc->submit(id, prep, {DSK_FORWARD(h)});
+            }
+        }
+    };
+
+    template<class Token>
+    auto async_rw(bool write, _io_uring_fixed_target_ auto target, uint64_t offset,
+                  io_uring_fixed_buf const& b, size_t n, Token&& token)
+    {
+        DSK_ASSERT(_inited);
+
+        int  fd = 0;
+        bool fixedFile = false;
+
+        if constexpr(_same_as_<decltype(target), io_uring_fixed_file>)
+        {
+            fd        = static_cast<int>(target.slot);
+            fixedFile = true;
+        }
+        else
+        {
+            fd = target;
+        }
+
+        return asio::async_initiate<Token, void(error_code, size_t)>(
+            initiate_rw{this, fd, fixedFile, write, offset, b.data,
+                        static_cast<unsigned>(std::min(n, b.size)), b.index},
+            token);
+    }
+
+    void shutdown() override
+    {
+        decltype(_inflight) inflight;
+
+        {
+            lock_guard lg(_mtx);
+
+            // like asio, pending handlers are destroyed without invocation.
+            // they are destroyed out of lock, as multishot states may recycle provided buffers.
+            inflight = mut_move(_inflight);
+            _inflight.clear();
+        }
+
+        inflight.clear();
+
+        error_code ec;
+        _efd.close(ec);
+    }
+
+public:
+    explicit io_uring_fixed_service(asio::io_context& ioc)
+        : asio::execution_context::service(ioc), _ioc(ioc), _efd(ioc)
+    {}
+
+    ~io_uring_fixed_service()
+    {
+        if(_inited)
+        {
+            if(_recvBr)
+            {
+                io_uring_free_buf_ring(&_ring, _recvBr, _recvBufCount, recv_buf_group);
+            }
+
+            io_uring_queue_exit(&_ring);
+        }
+
+        _bufs.reset();
+        std::free(_bufMem);
+        std::free(_recvMem);
+    }
+
+    asio::io_context& context() noexcept { return _ioc; }
+
+    bool initialized() const noexcept { return _inited; }
+
+    // Create the ring, register buffers and fixed file table.
+    // Should be called once before any other use.
+    error_code init(io_uring_fixed_options const& opts = {})
+    {
+        lock_guard lg(_mtx);
+
+        DSK_ASSERT(! _inited);
+
+        if(int r = io_uring_queue_init(opts.entries, &_ring, 0); r < 0)
+        {
+            return sys_err(-r);
+        }
+
+        _inited = true; // so the ring is released in destructor, even if failed below.
+        _submitBatch = std::max(opts.submitBatch, 1u);
+
+        if(opts.bufCount)
+        {
+            size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+
+            _bufSize = (opts.bufSize + page - 1) / page * page;
+            _bufMem  = static_cast<std::byte*>(std::aligned_alloc(page, _bufSize * opts.bufCount));
+
+            if(! _bufMem)
+            {
+                return sys_err(ENOMEM);
+            }
+
+            vector<iovec> iovs(opts.bufCount);
+
+            for(size_t i = 0; i < opts.bufCount; ++i)
+            {
+                iovs[i].iov_base = _bufMem + i * _bufSize;
+                iovs[i].iov_len  = _bufSize;
+            }
+
+            if(int r = io_uring_register_buffers(&_ring, iovs.data(), static_cast<unsigned>(iovs.size())); r < 0)
+            {
+                return sys_err(-r);
+            }
+
+            _bufs.emplace(opts.bufCount, buf_creator{this});
+        }
+
+        if(opts.recvBufCount)
+        {
+            if(auto ec = init_recv_bufs_no_lock(opts.recvBufCount, opts.recvBufSize))
+            {
+                return ec;
+            }
+        }
+
+        if(opts.fileCount)
+        {
+            if(int r = io_uring_register_files_sparse(&_ring, opts.fileCount); r < 0)
+            {
+                return sys_err(-r);
+            }
+
+            for(unsigned i = opts.fileCount; i-- > 0;)
+            {
+                _freeFileSlots.emplace_back(i);
+            }
+        }
+
+        int efd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+        if(efd < 0)
+        {
+            return sys_err(errno);
+        }
+
+        error_code ec;
+        _efd.assign(efd, ec);
+
+        if(ec)
+        {
+            ::close(efd);
+            return ec;
+        }
+
+        if(int r = io_uring_register_eventfd(&_ring, efd); r < 0)
+        {
+            return sys_err(-r);
+        }
+
+        arm_reaper();
+        return {};
+    }
+
+    // Provide buffers for multishot recv, if not by recvBufCount of init().
+    error_code init_recv_bufs(size_t count, size_t size)
+    {
+        lock_guard lg(_mtx);
+
+        DSK_ASSERT(_inited && ! _recvBr);
+        return init_recv_bufs_no_lock(count, size);
+    }
+
+    size_t buf_size () const noexcept { return _bufSize; }
+    size_t buf_count() const noexcept { return _bufs ? _bufs->capacity() : 0; }
+
+    // Lease a registered buffer, wait if all are leased.
+    // Result type: expected<buf_ref>, buf_ref refers to io_uring_fixed_buf and returns it to pool on destruction.
+    auto acquire_buf()
+    {
+        DSK_ASSERT(_bufs);
+        return _bufs->acquire();
+    }
+
+    // errc::resource_unavailable if all are leased.
+    auto try_acquire_buf()
+    {
+        DSK_ASSERT(_bufs);
+        return _bufs->try_acquire();
+    }
+
+    // Put fd into a free slot of fixed file table.
+    // fd should be kept open until unregister_file().
+    expected<io_uring_fixed_file> register_file(int fd)
+    {
+        lock_guard lg(_mtx);
+
+        DSK_ASSERT(_inited);
+
+        if(_freeFileSlots.empty())
+        {
+            return errc::out_of_capacity;
+        }
+
+        unsigned slot = _freeFileSlots.back();
+
+        if(int r = io_uring_register_files_update(&_ring, slot, &fd, 1); r < 0)
+        {
+            return sys_err(-r);
+        }
+
+        _freeFileSlots.pop_back();
+        return io_uring_fixed_file{slot};
+    }
+
+    // Should not be used by any pending op.
+    error_code unregister_file(io_uring_fixed_file f)
+    {
+        lock_guard lg(_mtx);
+
+        int fd = -1;
+
+        if(int r = io_uring_register_files_update(&_ring, f.slot, &fd, 1); r < 0)
+        {
+            return sys_err(-r);
+        }
+
+        _freeFileSlots.emplace_back(f.slot);
+        return {};
+    }
+
+    // Submit a multishot op prepared by prep(io_uring_sqe*), of which completions are got by next() of the result.
+    // release(svc, cqe) is called for completions not consumed when the op is stopped.
+    io_uring_multishot start_multishot(auto&& prep, io_uring_multishot_state::release_fn release = nullptr)
+    {
+        DSK_ASSERT(_inited);
+
+        uint64_t id = _nextId.fetch_add(1, memory_order_relaxed);
+        auto     st = std::make_shared<io_uring_multishot_state>(*this, release);
+
+        submit(id, prep, {{}, st});
+        return {id, mut_move(st)};
+    }
+
+    // Multishot accept on listening socket fd, each completion is an accepted fd or error.
+    io_uring_multishot accept_multishot(int fd)
+    {
+        return start_multishot([fd](io_uring_sqe* sqe)
+        {
+            io_uring_prep_multishot_accept(sqe, fd, nullptr, nullptr, SOCK_CLOEXEC);
+        },
+        release_accepted);
+    }
+
+    // Multishot recv on socket fd into provided buffers, which requires recvBufCount of init().
+    // A completion with res > 0 has a buffer taken from the ring, which should be recycled by recycle_recv_buf(),
+    // res == 0 means eof, -ENOBUFS means all buffers are taken, see wait_recv_buf().
+    io_uring_multishot recv_multishot(int fd)
+    {
+        DSK_ASSERT(_recvBr);
+
+        return start_multishot([fd](io_uring_sqe* sqe)
+        {
+            io_uring_prep_recv_multishot(sqe, fd, nullptr, 0, 0);
+            sqe->flags     |= IOSQE_BUFFER_SELECT;
+            sqe->buf_group  = recv_buf_group;
+        },
+        release_recv_buf);
+    }
+
+    size_t recv_buf_size () const noexcept { return _recvBufSize; }
+    size_t recv_buf_count() const noexcept { return _recvBufCount; }
+
+    std::byte* recv_buf_data(unsigned id) const noexcept
+    {
+        DSK_ASSERT(id < _recvBufCount);
+        return _recvMem + id * _recvBufSize;
+    }
+
+    // Give provided buffer back to the ring.
+    void recycle_recv_buf(unsigned id)
+    {
+        DSK_ASSERT(id < _recvBufCount);
+
+        bool wasEmpty = false;
+
+        {
+            lock_guard lg(_mtx);
+
+            io_uring_buf_ring_add(_recvBr, recv_buf_data(id), static_cast<unsigned>(_recvBufSize),
+                                  static_cast<unsigned short>(id), io_uring_buf_ring_mask(_recvBufCount), 0);
+            io_uring_buf_ring_advance(_recvBr, 1);
+
+            wasEmpty = (_recvBufFree++ == 0);
+        }
+
+        if(wasEmpty)
+        {
+            _recvBufEv.set();
+        }
+    }
+
+    // Wait until the ring has any provided buffer, e.g. after -ENOBUFS.
+    // Result type: expected<void, errc>
+    auto wait_recv_buf()
+    {
+        {
+            lock_guard lg(_mtx);
+
+            if(_recvBufFree == 0)
+            {
+                _recvBufEv.reset();
+            }
+        }
+
+        return _recvBufEv.wait();
+    }
+
+    // READ_FIXED of at most n bytes into b from target, which is a fd or a registered file.
+    // offset is ignored by sockets, and -1 means current position of the fd, which is not
+    // the position asio tracks for stream_file, so don't use -1 on fd of a stream_file.
+    // Handler signature: void(error_code, size_t)
+    template<class Token = use_async_op_t>
+    auto read_fixed(_io_uring_fixed_target_ auto target, uint64_t offset,
+                    io_uring_fixed_buf const& b, size_t n = -1, Token&& token = {})
+    {
+        return async_rw(false, target, offset, b, n, DSK_FORWARD(token));
+    }
+
+    // WRITE_FIXED of first n bytes of b to target.
+    template<class Token = use_async_op_t>
+    auto write_fixed(_io_uring_fixed_target_ auto target, uint64_t offset,
+                     io_uring_fixed_buf const& b, size_t n, Token&& token = {})
+    {
+        return async_rw(true, target, offset, b, n, DSK_FORWARD(token));
+    }
+};
+
+
+inline auto& get_io_uring_fixed_service(asio::io_context& ioc = DSK_DEFAULT_IO_CONTEXT)
+{
+    return asio::use_service<io_uring_fixed_service>(ioc);
+}
+
+
+inline void io_uring_multishot::stop()
+{
+    if(_st)
+    {
+        _st->svc.cancel(_id); // no-op if finished.
+        _st.reset();
+    }
+}
+
+
+// A file accessed at explicit offsets, e.g. random_access_file.
+// stream_file is excluded, as asio tracks its position, which fixed ops would bypass.
+// For it, register its fd and pass explicit offsets to svc.read_fixed()/write_fixed() instead.
+template<class F>
+concept _io_uring_fixed_file_ = std::derived_from<F, asio::basic_random_access_file<typename F::executor_type>>;
+
+
+// Fixed buffer I/O on random_access_file and sockets,
+// using the io_uring_fixed_service of their io_context, which should be initialized.
+
+auto read_some_fixed_at(_io_uring_fixed_file_ auto& f, uint64_t offset, io_uring_fixed_buf const& b, size_t n = -1)
+{
+    return get_io_uring_fixed_service(f.get_executor().context()).read_fixed(f.native_handle(), offset, b, n);
+}
+
+auto write_some_fixed_at(_io_uring_fixed_file_ auto& f, uint64_t offset, io_uring_fixed_buf const& b, size_t n)
+{
+    return get_io_uring_fixed_service(f.get_executor().context()).write_fixed(f.native_handle(), offset, b, n);
+}
+
+auto read_some_fixed(_fd_socket_ auto& s, io_uring_fixed_buf const& b, size_t n = -1)
+{
+    return get_io_uring_fixed_service(s.get_executor().context()).read_fixed(s.native_handle(), uint64_t(-1), b, n);
+}
+
+auto write_some_fixed(_fd_socket_ auto& s, io_uring_fixed_buf const& b, size_t n)
+{
+    return get_io_uring_fixed_service(s.get_executor().context()).write_fixed(s.native_handle(), uint64_t(-1), b, n);
+}
+
+
+} // namespace dsk
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <dsk/generator.hpp>
+#include <dsk/asio/tcp.hpp>
+#include <dsk/asio/timer.hpp>
+#include <dsk/asio/io_uring_fixed.hpp>
+#include <utility>
+
+
+// Requires ENABLE_IO_URING, see README.md
+
+
+namespace dsk{
+
+
+// A provided buffer filled by multishot recv, given back to the ring on destruction.
+class io_uring_recv_buf
+{
+    io_uring_fixed_service* _svc = nullptr;
+    unsigned                _id = 0;
+    size_t                  _size = 0;
+
+public:
+    io_uring_recv_buf() = default;
+
+    io_uring_recv_buf(io_uring_fixed_service& svc, unsigned id, size_t n) noexcept
+        : _svc(&svc), _id(id), _size(n)
+    {}
+
+    io_uring_recv_buf(io_uring_recv_buf&& r) noexcept
+        : _svc(std::exchange(r._svc, nullptr)), _id(r._id), _size(std::exchange(r._size, 0))
+    {}
+
+    io_uring_recv_buf& operator=(io_uring_recv_buf&& r) noexcept
+    {
+        if(this != &r)
+        {
+            recycle();
+            _svc  = std::exchange(r._svc, nullptr);
+            _id   = r._id;
+            _size = std::exchange(r._size, 0);
+        }
+
+        return *this;
+    }
+
+    ~io_uring_recv_buf()
+    {
+        recycle();
+    }
+
+    std::byte const* data () const noexcept { return _svc ? _svc->recv_buf_data(_id) : nullptr; }
+    size_t           size () const noexcept { return _size; }
+    bool             empty() const noexcept { return ! _size; }
+
+    // Give it back to the ring early.
+    void recycle()
+    {
+        if(_svc)
+        {
+            std::exchange(_svc, nullptr)->recycle_recv_buf(_id);
+            _size = 0;
+        }
+    }
+};
+
+
+// Accept errors of running out of resources, retrying at once would likely fail again.
+inline bool is_accept_resource_error(int e) noexcept
+{
+    switch(e)
+    {
+        case EMFILE: case ENFILE: case ENOBUFS: case ENOMEM:
+        case EBUSY: // submission queue of io_uring_fixed_service is full.
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Accept errors of a single connection or of running out of resources,
+// after which the listening socket is still fine.
+inline bool is_transient_accept_error(int e) noexcept
+{
+    return e == ECONNABORTED || e == EPROTO || e == EPERM || e == EINTR
+        || is_accept_resource_error(e);
+}
+
+
+// Sockets accepted by multishot accept, one submission for many connections.
+// The op is restarted if the kernel ends it, and canceled when the generator is destroyed.
+// Transient errors, see is_transient_accept_error(), are skipped, and if the op is ended by
+// running out of resources, it's restarted after a short delay.
+// Only errors of the listening socket end the stream.
+//
+//      auto as = accept_stream(acceptor);
+//
+//      while(auto s = DSK_TRY as.next())
+//      {
+//          ... *s is a tcp_socket
+//      }
+//
+// The io_uring_fixed_service of acceptor's io_context should be initialized.
+template<class Socket = tcp_socket>
+generator<Socket> accept_stream(auto& acceptor)
+{
+    auto& ioc = acceptor.get_executor().context();
+    auto& svc = get_io_uring_fixed_service(ioc);
+
+    constexpr auto retryDelay = std::chrono::milliseconds(10);
+
+    io_uring_multishot ms;
+
+    for(;;)
+    {
+        if(! ms)
+        {
+            ms = svc.accept_multishot(acceptor.native_handle());
+        }
+
+        io_uring_cqe_result c = DSK_TRY ms.next();
+
+        if(! c.more())
+        {
+            ms = {};
+        }
+
+        if(c.res < 0)
+        {
+            if(! is_transient_accept_error(-c.res))
+            {
+                DSK_THROW(error_code(-c.res, system_category()));
+            }
+
+            if(! ms && is_accept_resource_error(-c.res))
+            {
+                DSK_TRY wait_for(retryDelay, ioc);
+            }
+
+            continue;
+        }
+
+        Socket s(ioc);
+
+        if(s.assign(c.res)) // only this connection is affected
+        {
+            ::close(c.res);
+            continue;
+        }
+
+        DSK_YIELD mut_move(s);
+    }
+}
+
+
+// Data received by multishot recv into provided buffers of io_uring_fixed_service.
+// A buffer is taken from the shared ring only when data arrives, so idle sockets pin no memory.
+// If all buffers are taken, it waits until some are recycled, then restarts the op.
+// Ends on eof.
+//
+//      auto rs = recv_stream(socket);
+//
+//      while(auto b = DSK_TRY rs.next())
+//      {
+//          ... consume b->data() and b->size(), b is recycled on destruction.
+//      }
+//
+// The service should be initialized with recvBufCount.
+generator<io_uring_recv_buf> recv_stream(auto& socket)
+{
+    auto& svc = get_io_uring_fixed_service(socket.get_executor().context());
+
+    io_uring_multishot ms;
+
+    for(;;)
+    {
+        if(! ms)
+        {
+            ms = svc.recv_multishot(socket.native_handle());
+        }
+
+        io_uring_cqe_result c = DSK_TRY ms.next();
+
+        if(! c.more())
+        {
+            ms = {};
+        }
+
+        if(c.res > 0)
+        {
+            DSK_ASSERT(c.has_buf());
+            DSK_YIELD io_uring_recv_buf(svc, c.buf_id(), static_cast<size_t>(c.res));
+        }
+        else if(c.res == 0)
+        {
+            if(c.has_buf())
+            {
+                svc.recycle_recv_buf(c.buf_id());
+            }
+
+            DSK_RETURN();
+        }
+        else if(c.res == -ENOBUFS)
+        {
+            DSK_TRY svc.wait_recv_buf();
+        }
+        else
+        {
+            DSK_THROW(error_code(-c.res, system_category()));
+        }
+    }
+}
+
+
+} // namespace dsk
@@ -4,6 +4,12 @@
 #include <dsk/asio/file.hpp>
 #include <dsk/asio/transfer.hpp>
 
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
 
 namespace dsk{
 
@@ -16,6 +22,132 @@ struct recv_file_options
 };
 
 
+template<buf_size_t BufSize = buf_size_t(0)>
+task<size_t> general_recv_file(auto& skt, stream_file& file, size_t count)
+{
+    DSK_TRY_RETURN(pipelined_transfer<BufSize ? BufSize : buf_size_t(256*1024)>(skt, file, count));
+}
+
+
+#if defined(__linux__)
+
+
+class linux_pipe
+{
+    int _fds[2] = {-1, -1};
+
+public:
+    linux_pipe() = default;
+    linux_pipe(linux_pipe const&) = delete;
+    linux_pipe& operator=(linux_pipe const&) = delete;
+
+    ~linux_pipe()
+    {
+        if(_fds[0] >= 0) ::close(_fds[0]);
+        if(_fds[1] >= 0) ::close(_fds[1]);
+    }
+
+    // sz: capacity to request, the default one is used if failed.
+    error_code open(size_t sz = 0)
+    {
+        DSK_ASSERT(_fds[0] < 0);
+
+        if(::pipe2(_fds, O_CLOEXEC | O_NONBLOCK))
+        {
+            return error_code(errno, system_category());
+        }
+
+        if(sz)
+        {
+            ::fcntl(_fds[1], F_SETPIPE_SZ, static_cast<int>(sz));
+        }
+
+        return {};
+    }
+
+    int read_end () const noexcept { return _fds[0]; }
+    int write_end() const noexcept { return _fds[1]; }
+};
+
+
+// Zero copy receiving via splice() from socket to a pipe, then from the pipe to file,
+// waiting for socket to be readable when it would block.
+// File is written at its current position.
+//
+// NOTE: the pipe to file splice() is a blocking disk write done on the calling thread,
+//       usually an io thread. It is normally absorbed by page cache, but may stall under
+//       writeback pressure or on slow storage, so each splice is bounded to chunkSize
+//       to limit how long other handlers of the thread can be held up by a single one.
+//       For large transfers to slow storage, consider running it on a dedicated io context.
+task<size_t> linux_recv_file(_fd_socket_ auto& skt, stream_file& file, size_t count = -1)
+{
+    constexpr size_t chunkSize = 64*1024;
+
+    if(! skt.native_non_blocking())
+    {
+        DSK_TRY_SYNC skt.native_non_blocking(true);
+    }
+
+    linux_pipe pipe;
+    DSK_TRY_SYNC pipe.open(chunkSize);
+
+    size_t total = 0;
+
+    while(total < count)
+    {
+        if(DSK_WAIT stop_requested())
+        {
+            DSK_THROW(errc::canceled);
+        }
+
+        ssize_t n = ::splice(skt.native_handle(), nullptr, pipe.write_end(), nullptr,
+                             std::min(count - total, chunkSize), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+        if(n == 0) // eof
+        {
+            if(count == size_t(-1)) break;
+            else                    DSK_THROW(asio::error::eof);
+        }
+
+        if(n < 0)
+        {
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                DSK_TRY skt.wait(DSK_NO_CVREF_T(skt)::wait_read);
+            }
+            else if(errno != EINTR)
+            {
+                DSK_THROW(error_code(errno, system_category()));
+            }
+
+            continue;
+        }
+
+        // drain the pipe, so it never blocks the splice above.
+        for(size_t left = static_cast<size_t>(n); left > 0;)
+        {
+            ssize_t m = ::splice(pipe.read_end(), nullptr, file.native_handle(), nullptr, left, SPLICE_F_MOVE);
+
+            if(m > 0)
+            {
+                left -= static_cast<size_t>(m);
+            }
+            else if(m == 0 || errno != EINTR)
+            {
+                DSK_THROW(error_code(m == 0 ? EIO : errno, system_category()));
+            }
+        }
+
+        total += static_cast<size_t>(n);
+    }
+
+    DSK_RETURN(total);
+}
+
+
+#endif
+
+
 template<buf_size_t BufSize = buf_size_t(0)>
 task<size_t> recv_file(auto& skt, stream_file& file, recv_file_options opts = {})
 {    
@@ -24,7 +156,18 @@ task<size_t> recv_file(auto& skt, stream_file& file, recv_file_options opts = {}
         DSK_TRY_SYNC file.seek(opts.offset, file_base::seek_set);
     }
 
-    DSK_TRY_RETURN(transfer<BufSize ? BufSize : buf_size_t(8*1024)>(skt, file, buf, opts.count));
+#if defined(__linux__)
+    // splice() doesn't support files opened in append mode.
+    if constexpr(_fd_socket_<DSK_NO_CVREF_T(skt)>)
+    {
+        if(! (::fcntl(file.native_handle(), F_GETFL) & O_APPEND))
+        {
+            DSK_TRY_RETURN(linux_recv_file(skt, file, opts.count));
+        }
+    }
+#endif
+
+    DSK_TRY_RETURN(general_recv_file<BufSize>(skt, file, opts.count));
 }
 
 
@@ -32,6 +175,21 @@ template<buf_size_t BufSize = buf_size_t(0)>
 task<size_t> recv_file(auto& skt, _borrowed_byte_str_ auto path, recv_file_options opts = {})
 {
     stream_file file(skt.get_executor());
+
+#if defined(__linux__)
+    // Open without append mode and seek to end, which is same for a file only written by us,
+    // so linux_recv_file() can be used.
+    if constexpr(_fd_socket_<DSK_NO_CVREF_T(skt)>)
+    {
+        if((opts.flags & file_base::append) && opts.offset == size_t(-1))
+        {
+            DSK_TRY_SYNC file.open(path, file_base::write_only | (opts.flags & ~file_base::append));
+            DSK_TRY_SYNC file.seek(0, file_base::seek_end);
+            DSK_TRY_RETURN(recv_file<BufSize>(skt, file, opts));
+        }
+    }
+#endif
+
     DSK_TRY_SYNC file.open(path, file_base::write_only | opts.flags);
     DSK_TRY_RETURN(recv_file<BufSize>(skt, file, opts));
 }
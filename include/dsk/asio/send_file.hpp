@@ -5,6 +5,11 @@
 #include <dsk/asio/transfer.hpp>
 #include <boost/asio/windows/overlapped_ptr.hpp>
 
+#if defined(__linux__)
+    #include <sys/sendfile.h>
+    #include <cerrno>
+#endif
+
 
 namespace dsk{
 
@@ -154,12 +159,75 @@ task<size_t> win32_send_file(auto& skt, auto& file, send_file_options opts = {})
 #endif
 
 
+#if defined(__linux__)
+
+
+// Zero copy sending via sendfile(), waiting for socket to be writable when it would block.
+// File position is not changed, as offset is passed explicitly.
+task<size_t> linux_send_file(_fd_socket_ auto& skt, stream_file& file, send_file_options opts = {})
+{
+    if(opts.count == size_t(-1))
+    {
+        size_t fs = DSK_TRY_SYNC file.size();
+
+        if(fs <= opts.offset)
+        {
+            DSK_RETURN(0);
+        }
+
+        opts.count = fs - opts.offset;
+    }
+
+    if(! skt.native_non_blocking())
+    {
+        DSK_TRY_SYNC skt.native_non_blocking(true);
+    }
+
+    size_t left   = opts.count;
+    off_t  offset = static_cast<off_t>(opts.offset);
+
+    while(left > 0)
+    {
+        if(DSK_WAIT stop_requested())
+        {
+            DSK_THROW(errc::canceled);
+        }
+
+        constexpr size_t maxCnt = 0x7ffff000; // max bytes transferred by a sendfile() call.
+
+        ssize_t n = ::sendfile(skt.native_handle(), file.native_handle(), &offset, std::min(left, maxCnt));
+
+        if(n > 0)
+        {
+            left -= static_cast<size_t>(n);
+        }
+        else if(n == 0) // file shrunk
+        {
+            DSK_THROW(asio::error::eof);
+        }
+        else if(errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            DSK_TRY skt.wait(DSK_NO_CVREF_T(skt)::wait_write);
+        }
+        else if(errno != EINTR)
+        {
+            DSK_THROW(error_code(errno, system_category()));
+        }
+    }
+
+    DSK_RETURN(opts.count);
+}
+
+
+#endif
+
+
 template<buf_size_t BufSize = buf_size_t(0)>
 task<size_t> general_send_file(auto& skt, stream_file& file, send_file_options opts = {})
 {
     DSK_TRY_SYNC file.seek(opts.offset, file_base::seek_set);
 
-    DSK_TRY_RETURN(transfer<BufSize ? BufSize : buf_size_t(8*1024)>(file, skt, opts.count));
+    DSK_TRY_RETURN(pipelined_transfer<BufSize ? BufSize : buf_size_t(256*1024)>(file, skt, opts.count));
 }
 
 
@@ -168,6 +236,9 @@ task<size_t> send_file(auto& skt, stream_file& file, send_file_options opts = {}
 {
 #if defined(ASIO_HAS_WINDOWS_OVERLAPPED_PTR) || defined(BOOST_ASIO_HAS_WINDOWS_OVERLAPPED_PTR)
     return win32_send_file(skt, file, opts);
+#elif defined(__linux__)
+    if constexpr(_fd_socket_<DSK_NO_CVREF_T(skt)>) return linux_send_file(skt, file, opts);
+    else                                           return general_send_file<BufSize>(skt, file, opts);
 #else
     return general_send_file<BufSize>(skt, file, opts);
 #endif
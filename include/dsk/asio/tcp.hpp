@@ -189,6 +189,13 @@ public:
         return base::async_accept(use_async_op_for<Socket>);
     }
 
+    // accepted socket is bound to ioc, e.g. asio_sharded_io_thread_pool::next_context().
+    template<class Socket = tcp_socket>
+    auto accept(asio::io_context& ioc)
+    {
+        return base::async_accept(ioc, use_async_op_for<Socket>);
+    }
+
     auto wait(wait_type w)
     {
         return base::async_wait(w);
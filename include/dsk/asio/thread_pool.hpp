@@ -1,8 +1,14 @@
 #pragma once
 
+#include <dsk/scheduler_stats.hpp>
 #include <dsk/util/debug.hpp>
 #include <dsk/util/deque.hpp>
+#include <dsk/util/vector.hpp>
 #include <dsk/util/thread.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/cpu_affinity.hpp>
+#include <dsk/util/cpu_topology.hpp>
+#include <dsk/numa_node_scheduler.hpp>
 #include <dsk/asio/config.hpp>
 #include <boost/asio/post.hpp>
 #include <boost/asio/io_context.hpp>
@@ -10,6 +16,7 @@
 #include <boost/asio/recycling_allocator.hpp>
 #include <boost/asio/bind_allocator.hpp>
 #include <optional>
+#include <functional>
 
 
 namespace dsk{
@@ -19,6 +26,7 @@ class asio_thread_pool
 {
     std::optional<asio::thread_pool> _pool;
     int _maxConcurrency = -1;
+    scheduler_stats_recorder _stats; // only used if scheduler_stats_enabled
 
 public:
     asio_thread_pool(asio_thread_pool const&) = delete;
@@ -56,6 +64,13 @@ public:
 
         if(_maxConcurrency > 0) _pool.emplace(static_cast<size_t>(_maxConcurrency));
         else                    _pool.emplace();
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            // asio::thread_pool's default size
+            _stats.reset(_maxConcurrency > 0 ? static_cast<size_t>(_maxConcurrency)
+                                             : std::max(thread::hardware_concurrency() * 2, 1u));
+        }
     }
 
     void restart()
@@ -68,8 +83,23 @@ public:
     {
         DSK_ASSERT(started());
 
-        asio::post(*_pool, DSK_FORWARD(f));
-        //asio::post(*_pool, asio::bind_allocator(allocator_type(), DSK_FORWARD(f)));
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.on_post();
+            _stats.on_pending_add();
+
+            asio::post(*_pool, [this, f = DSK_FORWARD(f), t = scheduler_stats_recorder::now()]() mutable
+            {
+                _stats.on_execute_any(_stats.bind_worker_lazily(), t);
+                _stats.on_pending_done();
+                f();
+            });
+        }
+        else
+        {
+            asio::post(*_pool, DSK_FORWARD(f));
+            //asio::post(*_pool, asio::bind_allocator(allocator_type(), DSK_FORWARD(f)));
+        }
     }
 
     // Signal underlying threads to stop. Pending jobs may be ignored.
@@ -97,6 +127,14 @@ public:
         stop();
         join();
     }
+
+    // Empty if DSK_ENABLE_SCHEDULER_STATS is not defined.
+    // Stats are reset on start(). Queue depth is tracked as total pending jobs.
+    scheduler_stats stats() const
+    {
+        if constexpr(scheduler_stats_enabled) return _stats.snapshot();
+        else                                  return {};
+    }
 };
 
 
@@ -110,6 +148,7 @@ class asio_io_thread_pool
     asio::io_context _ctx; // must be first, as resume(..., curSrId) uses executor's context as curSrId.
     deque<thread>    _threads;
     int              _maxConcurrency = default_max_concurrency();
+    scheduler_stats_recorder _stats; // only used if scheduler_stats_enabled
 
 public:
     asio_io_thread_pool(asio_io_thread_pool const&) = delete;
@@ -164,10 +203,20 @@ public:
 
         _ctx.get_executor().on_work_started(); // avoid run() from returning when there is no job
 
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.reset(static_cast<size_t>(_maxConcurrency));
+        }
+
         for(int i = 0; i < _maxConcurrency; ++i)
         {
-            _threads.emplace_back([this]()
+            _threads.emplace_back([this, i]()
             {
+                if constexpr(scheduler_stats_enabled)
+                {
+                    _stats.bind_worker(static_cast<size_t>(i));
+                }
+
                 try
                 {
                     _ctx.run();
@@ -193,8 +242,26 @@ public:
         // i.e., you should only post to started scheduler.
         DSK_ASSERT(started());
 
-        asio::post(_ctx, DSK_FORWARD(f));
-        //asio::post(_ctx, asio::bind_allocator(allocator_type(), DSK_FORWARD(f)));
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.on_post();
+            _stats.on_pending_add();
+
+            asio::post(_ctx, [this, f = DSK_FORWARD(f), t = scheduler_stats_recorder::now()]() mutable
+            {
+                // io_context may also be run by threads not belonging to the pool.
+                if(size_t w = _stats.current_worker(); w != scheduler_stats_recorder::npos)
+                    _stats.on_execute(w, t);
+
+                _stats.on_pending_done();
+                f();
+            });
+        }
+        else
+        {
+            asio::post(_ctx, DSK_FORWARD(f));
+            //asio::post(_ctx, asio::bind_allocator(allocator_type(), DSK_FORWARD(f)));
+        }
     }
 
     // Signal underlying threads to stop. Pending jobs may be ignored.
@@ -232,6 +299,375 @@ public:
         stop();
         join();
     }
+
+    // Empty if DSK_ENABLE_SCHEDULER_STATS is not defined.
+    // Stats are reset on start(). Only jobs posted via post() are recorded, not I/O completions.
+    // Queue depth is tracked as total pending jobs.
+    scheduler_stats stats() const
+    {
+        if constexpr(scheduler_stats_enabled) return _stats.snapshot();
+        else                                  return {};
+    }
+};
+
+
+// Sharded io_context thread pool.
+// Each shard is an io_context run by a single thread, which is pinned to a cpu by default,
+// so io objects on different shards don't contend on a shared reactor and scheduler queue.
+//
+// context() returns the io_context of calling shard, if called on one of the shard threads,
+// otherwise the next one in round-robin order. So io objects created with DSK_DEFAULT_IO_CONTEXT
+// on a shard stay on that shard. To place io objects explicitly:
+//      acceptor.accept(pool.next_context());   // round-robin on accept
+//      tcp_socket s(pool.context_for(key));    // hash by key
+//
+// post() from a shard thread goes to that shard, otherwise to the next one in round-robin order.
+// Use post_to() to post to a specific shard.
+//
+// Shards are pinned in order of cpu_topology::cpus_by_node(), so shards of a NUMA node are contiguous.
+// To keep a connection and its handlers on a node:
+//      tcp_socket s(pool.node_context(n));
+//      DSK_TRY run_on(pool.node_scheduler(n), handle(s));
+class asio_sharded_io_thread_pool
+{
+    struct shard_t
+    {
+        asio::io_context ctx{1}; // concurrency hint: run by only one thread
+        thread           thrd;
+        atomic<bool>     pinned = false; // set by the shard thread, see shard_pinned()
+    };
+
+    deque<shard_t>           _shards; // stable addresses, created on set_max_concurrency()
+    mutable atomic<uint32_t> _next = 0; // round-robin cursor, also advanced by const context()
+    int                      _maxConcurrency = 0;
+    bool                     _pin = true;
+    bool                     _started = false;
+    scheduler_stats_recorder _stats; // only used if scheduler_stats_enabled
+
+    // see set_cpu_topology()
+    cpu_topology const*                                       _topo = nullptr;
+    vector<uint32_t>                                          _shardNode;  // node of each shard
+    vector<vector<uint32_t>>                                  _nodeShards; // shards of each node
+    vector<numa_node_scheduler<asio_sharded_io_thread_pool>> _nodeSchs;
+
+    inline static thread_local asio_sharded_io_thread_pool const* tl_pool  = nullptr;
+    inline static thread_local size_t                             tl_shard = 0;
+
+    size_t next_shard() const noexcept
+    {
+        return _next.fetch_add(1, memory_order_relaxed) % _shards.size();
+    }
+
+    // cpu of shard i in cpus_by_node() order.
+    unsigned shard_cpu(size_t i) const noexcept
+    {
+        auto& cpus = _topo->cpus_by_node();
+        return cpus[i % cpus.size()];
+    }
+
+    void init_nodes()
+    {
+        _shardNode.resize(_shards.size());
+        _nodeShards.assign(_nodeSchs.size(), {});
+
+        for(uint32_t i = 0; i < _shards.size(); ++i)
+        {
+            uint32_t k = static_cast<uint32_t>(_topo->node_of_cpu(shard_cpu(i)));
+
+            _shardNode[i] = k;
+            _nodeShards[k].emplace_back(i);
+        }
+    }
+
+public:
+    asio_sharded_io_thread_pool(asio_sharded_io_thread_pool const&) = delete;
+    asio_sharded_io_thread_pool& operator=(asio_sharded_io_thread_pool const&) = delete;
+
+    explicit asio_sharded_io_thread_pool(int n = -1, start_scheduler_e startNow = dont_start_now)
+    {
+        set_cpu_topology();
+        set_max_concurrency(n);
+
+        if(startNow)
+        {
+            start();
+        }
+    }
+
+    explicit asio_sharded_io_thread_pool(start_scheduler_e startNow)
+        : asio_sharded_io_thread_pool(-1, startNow)
+    {}
+
+    ~asio_sharded_io_thread_pool() { join(); }
+
+    // one shard per core
+    template<class T = int>
+    static T default_max_concurrency() noexcept
+    {
+        auto n = thread::hardware_concurrency();
+
+        if(n < 1)
+            n = 1;
+
+        return static_cast<T>(n);
+    }
+
+    using is_io_scheduler = void;
+
+    auto& context()       noexcept { return _shards[current_or_next_shard()].ctx; }
+    auto& context() const noexcept { return _shards[current_or_next_shard()].ctx; }
+
+    auto& next_context() noexcept { return _shards[next_shard()].ctx; }
+
+    auto& context_for_hash(size_t h) noexcept { return _shards[h % _shards.size()].ctx; }
+    auto& context_for(auto const& key) noexcept { return context_for_hash(std::hash<DSK_NO_CVREF_T(key)>()(key)); }
+
+    auto& shard_context(size_t i) noexcept { DSK_ASSERT(i < _shards.size()); return _shards[i].ctx; }
+    auto& shard_context(size_t i) const noexcept { DSK_ASSERT(i < _shards.size()); return _shards[i].ctx; }
+
+    size_t shard_count() const noexcept { return _shards.size(); }
+
+    // If shard i is pinned to its cpu, see set_cpu_pinning().
+    // false if pinning is disabled or failed, e.g. the cpu is not allowed by cpuset/cgroup of the process,
+    // in which case the shard still runs, but unpinned. Only reliable after the shard thread started.
+    bool shard_pinned(size_t i) const noexcept
+    {
+        DSK_ASSERT(i < _shards.size());
+        return _shards[i].pinned.load(memory_order_acquire);
+    }
+
+    // index of calling shard, or -1 if not called on a shard thread.
+    ptrdiff_t current_shard() const noexcept
+    {
+        return tl_pool == this ? static_cast<ptrdiff_t>(tl_shard) : -1;
+    }
+
+    size_t current_or_next_shard() const noexcept
+    {
+        return tl_pool == this ? tl_shard : next_shard();
+    }
+
+    using is_scheduler = void;
+    using allocator_type = DSK_DEFAULT_ALLOCATOR<void>;
+
+    // Recreates shards if count changes,
+    // so io objects created on previous shards must be destroyed before that.
+    void set_max_concurrency(int n)
+    {
+        DSK_ASSERT(! started());
+
+        _maxConcurrency = n > 0 ? n : default_max_concurrency();
+
+        if(_shards.size() != static_cast<size_t>(_maxConcurrency))
+        {
+            _shards.clear();
+
+            for(int i = 0; i < _maxConcurrency; ++i)
+                _shards.emplace_back();
+        }
+
+        init_nodes();
+    }
+
+    // Pin shard i to cpu (cpus_by_node()[i % cpu_count()]) of cpu topology, enabled by default.
+    // Should be called before start().
+    void set_cpu_pinning(bool on) noexcept
+    {
+        DSK_ASSERT(! started());
+        _pin = on;
+    }
+
+    // Topology used to pin shards and group them by NUMA node, cpu_topology::system() by default.
+    // Should be called before start() and before using node_context(),
+    // as shards may be moved to other nodes.
+    void set_cpu_topology(cpu_topology const& t = cpu_topology::system())
+    {
+        DSK_ASSERT(! started());
+
+        _topo = std::addressof(t);
+        _nodeSchs.clear();
+
+        for(size_t k = 0; k < t.node_count(); ++k)
+        {
+            _nodeSchs.emplace_back(*this, k);
+        }
+
+        init_nodes();
+    }
+
+    size_t node_count() const noexcept { return _nodeSchs.size(); }
+
+    size_t shard_node(size_t i) const noexcept { DSK_ASSERT(i < _shardNode.size()); return _shardNode[i]; }
+
+    // node of calling shard, or -1 if not called on a shard thread.
+    ptrdiff_t current_node() const noexcept
+    {
+        return tl_pool == this ? static_cast<ptrdiff_t>(_shardNode[tl_shard]) : -1;
+    }
+
+    // Shard of node k in round-robin order, or any shard if there is none on the node.
+    size_t next_shard_of_node(size_t k) noexcept
+    {
+        DSK_ASSERT(k < _nodeShards.size());
+
+        auto& ss = _nodeShards[k];
+
+        if(ss.empty())
+            return next_shard();
+
+        return ss[_next.fetch_add(1, memory_order_relaxed) % ss.size()];
+    }
+
+    // io_context of a shard on node k, io objects created with it complete on that node.
+    auto& node_context(size_t k) noexcept { return _shards[next_shard_of_node(k)].ctx; }
+
+    // _scheduler_ posting to shards of node k.
+    auto& node_scheduler(size_t k) noexcept
+    {
+        DSK_ASSERT(k < _nodeSchs.size());
+        return _nodeSchs[k];
+    }
+
+    bool started() const noexcept {  return _started; }
+
+    void start()
+    {
+        DSK_ASSERT(! _started);
+        DSK_ASSERT(_shards.size() > 0);
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.reset(_shards.size());
+        }
+
+        for(size_t i = 0; i < _shards.size(); ++i)
+        {
+            auto& s = _shards[i];
+
+            DSK_ASSERT(! s.ctx.stopped());
+
+            s.ctx.get_executor().on_work_started(); // avoid run() from returning when there is no job
+
+            s.thrd = thread([this, i, &s]()
+            {
+                tl_pool      = this;
+                tl_shard     = i;
+                tl_io_thread = {std::addressof(s.ctx), this};
+
+                s.pinned.store(_pin && pin_this_thread_to_cpu(shard_cpu(i)), memory_order_release);
+
+                if constexpr(scheduler_stats_enabled)
+                {
+                    _stats.bind_worker(i);
+                }
+
+                try
+                {
+                    s.ctx.run();
+                }
+                catch(...)
+                {
+                    DSK_ABORT("unhandled expcetion");
+                }
+
+                tl_pool      = nullptr;
+                tl_io_thread = {};
+            });
+        }
+
+        _started = true;
+    }
+
+    void restart()
+    {
+        join();
+        start();
+    }
+
+    void post(auto&& f)
+    {
+        post_to(current_or_next_shard(), DSK_FORWARD(f));
+    }
+
+    // Post to calling shard if it's on node k, otherwise to a shard of node k in round-robin order.
+    void post_to_node(size_t k, auto&& f)
+    {
+        if(tl_pool == this && _shardNode[tl_shard] == k)
+            post_to(tl_shard, DSK_FORWARD(f));
+        else
+            post_to(next_shard_of_node(k), DSK_FORWARD(f));
+    }
+
+    void post_to(size_t i, auto&& f)
+    {
+        DSK_ASSERT(started());
+        DSK_ASSERT(i < _shards.size());
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.on_post();
+            _stats.on_pending_add();
+
+            asio::post(_shards[i].ctx, [this, f = DSK_FORWARD(f), t = scheduler_stats_recorder::now()]() mutable
+            {
+                if(size_t w = _stats.current_worker(); w != scheduler_stats_recorder::npos)
+                    _stats.on_execute(w, t);
+
+                _stats.on_pending_done();
+                f();
+            });
+        }
+        else
+        {
+            asio::post(_shards[i].ctx, DSK_FORWARD(f));
+        }
+    }
+
+    // Signal underlying threads to stop. Pending jobs may be ignored.
+    void stop()
+    {
+        if(started())
+        {
+            for(auto& s : _shards)
+                s.ctx.stop();
+        }
+    }
+
+    // Wait for all outstanding jobs to complete, and exit threads.
+    // The pool can be started again after join();
+    void join()
+    {
+        if(! started())
+            return;
+
+        for(auto& s : _shards)
+            s.ctx.get_executor().on_work_finished(); // allow run() to return when there is no job
+
+        for(auto& s : _shards)
+        {
+            s.thrd.join();
+
+            DSK_ASSERT(s.ctx.stopped());
+
+            s.ctx.restart();
+        }
+
+        _started = false;
+    }
+
+    void stop_and_join()
+    {
+        stop();
+        join();
+    }
+
+    // Empty if DSK_ENABLE_SCHEDULER_STATS is not defined.
+    // Stats are reset on start(), each shard is a worker. Only jobs posted via post()/post_to() are recorded.
+    scheduler_stats stats() const
+    {
+        if constexpr(scheduler_stats_enabled) return _stats.snapshot();
+        else                                  return {};
+    }
 };
 
 
@@ -8,6 +8,10 @@
 #include <boost/asio/basic_waitable_timer.hpp>
 #include <chrono>
 
+#if defined(DSK_DEFAULT_TIMED_OP_TIMER_USE_WHEEL)
+    #include <dsk/asio/timing_wheel.hpp>
+#endif
+
 
 namespace dsk{
 
@@ -68,6 +72,16 @@ using system_timer          = basic_waitable_timer<std::chrono::system_clock>;
 using high_resolution_timer = basic_waitable_timer<std::chrono::high_resolution_clock>;
 
 
+// Default Timer of timed ops: wait(td, op), wait_until(t, op) and wait_for(d, op).
+// Define DSK_DEFAULT_TIMED_OP_TIMER_USE_WHEEL to serve them with timing_wheel_service,
+// which is cheaper for timeouts that are mostly canceled before expiry.
+#if defined(DSK_DEFAULT_TIMED_OP_TIMER_USE_WHEEL)
+    using default_timed_op_timer = wheel_timer;
+#else
+    using default_timed_op_timer = steady_timer;
+#endif
+
+
 
 template<class Timer = steady_timer, class Alloc = DSK_DEFAULT_ALLOCATOR<void>>
 auto wait(auto const& td, asio::io_context& ioc = DSK_DEFAULT_IO_CONTEXT)
@@ -100,7 +114,7 @@ struct [[nodiscard]] timed_async_op
                        errc                   _err{};
                        atomic<bool>           _done{false};
                        continuation           _cont;
-                       std::stop_source       _opSs{std::nostopstate};
+                       inplace_stop_source    _opSs;
                        optional_stop_callback _scb; // must be last defined
 
     using is_async_op = void;
@@ -118,7 +132,7 @@ struct [[nodiscard]] timed_async_op
 
         _cont = DSK_FORWARD(cont);
 
-        _opSs = std::stop_source();
+        _opSs.reset();
 
         if(stop_possible(ctx))
         {
@@ -195,19 +209,19 @@ struct [[nodiscard]] timed_async_op
     }
 };
 
-template<class Timer = steady_timer, take_cat_e Cat = result_cat>
+template<class Timer = default_timed_op_timer, take_cat_e Cat = result_cat>
 auto wait(auto const& td, _async_op_ auto&& op, asio::io_context& ioc = DSK_DEFAULT_IO_CONTEXT)
 {
     return timed_async_op<Cat, Timer, DSK_DECAY_T(op)>(DSK_FORWARD(op), ioc, td);
 }
 
-template<class Timer = steady_timer, take_cat_e Cat = result_cat>
+template<class Timer = default_timed_op_timer, take_cat_e Cat = result_cat>
 auto wait_until(typename Timer::time_point const& t, _async_op_ auto&& op, asio::io_context& ioc = DSK_DEFAULT_IO_CONTEXT)
 {
     return wait<Timer, Cat>(t, DSK_FORWARD(op), ioc);
 }
 
-template<class Timer = steady_timer, take_cat_e Cat = result_cat>
+template<class Timer = default_timed_op_timer, take_cat_e Cat = result_cat>
 auto wait_for(typename Timer::duration const& d, _async_op_ auto&& op, asio::io_context& ioc = DSK_DEFAULT_IO_CONTEXT)
 {
     return wait<Timer, Cat>(d, DSK_FORWARD(op), ioc);
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <dsk/util/mutex.hpp>
+#include <dsk/util/function.hpp>
+#include <dsk/util/small_vector.hpp>
+#include <dsk/util/timing_wheel.hpp>
+#include <dsk/asio/config.hpp>
+#include <dsk/asio/use_async_op.hpp>
+#include <dsk/asio/default_io_scheduler.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/associated_cancellation_slot.hpp>
+#include <chrono>
+
+
+namespace dsk{
+
+
+// Timers of one io_context backed by a hierarchical timing wheel of configurable tick.
+//
+// steady_timer goes into asio's timer heap, each wait/cancel is O(log n) under the io_context lock.
+// Timeouts, which are mostly canceled before expiry, are better served here,
+// wait/cancel is O(1), and only one asio timer per io_context is armed for the earliest tick.
+//
+// A service is created per io_context, so each shard of asio_sharded_io_thread_pool has its own wheel.
+//
+// Expiry is rounded up to tick, so timers never expire early, but may expire up to one tick late.
+class timing_wheel_service : public asio::execution_context::service
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+    using time_point = clock_type::time_point;
+    using duration   = clock_type::duration;
+    using handler_type = unique_function<void(error_code const&), DSK_DEFAULT_ALLOCATOR<void>, 64>;
+
+    static constexpr duration default_tick = std::chrono::milliseconds(1);
+
+    inline static asio::execution_context::id id;
+
+    class entry : public timing_wheel_entry
+    {
+        friend class timing_wheel_service;
+
+        handler_type _handler;
+    };
+
+private:
+    asio::io_context&  _ioc;
+    mutex              _mtx;
+    timing_wheel<>     _wheel;
+    duration           _tick     = default_tick;
+    time_point         _base     = clock_type::now(); // time of _baseTick
+    uint64_t           _baseTick = 0;
+    asio::steady_timer _driver;
+    uint64_t           _armed    = UINT64_MAX; // tick the _driver is armed for.
+    uint64_t           _gen      = 0;          // to ignore completion of re-armed _driver.
+
+    uint64_t tick_of(time_point t, bool roundUp) const noexcept
+    {
+        if(t <= _base)
+        {
+            return _baseTick;
+        }
+
+        auto d = t - _base;
+        auto n = d / _tick;
+
+        if(roundUp && n * _tick < d)
+        {
+            ++n;
+        }
+
+        return _baseTick + static_cast<uint64_t>(n);
+    }
+
+    // with _mtx locked
+    void arm_no_lock()
+    {
+        uint64_t t = _wheel.next_event_tick();
+
+        // a later _armed only makes a spurious wake up, no need to re-arm.
+        if(t >= _armed)
+        {
+            return;
+        }
+
+        _armed = t;
+        _driver.expires_at(_base + _tick * (t - _baseTick)); // cancels the previous wait, if any.
+        _driver.async_wait([this, gen = ++_gen](error_code const& ec)
+        {
+            if(ec != asio::error::operation_aborted)
+            {
+                on_driver(gen);
+            }
+        });
+    }
+
+    void on_driver(uint64_t gen)
+    {
+        small_vector<entry*, 16> expired;
+
+        {
+            lock_guard lg(_mtx);
+
+            if(gen != _gen)
+            {
+                return;
+            }
+
+            _armed = UINT64_MAX;
+
+            _wheel.advance(tick_of(clock_type::now(), false), [&](timing_wheel_entry* e)
+            {
+                expired.emplace_back(static_cast<entry*>(e));
+            });
+
+            arm_no_lock();
+        }
+
+        for(entry* e : expired)
+        {
+            // the entry may be destroyed by handler.
+            handler_type h = mut_move(e->_handler);
+            h(error_code());
+        }
+    }
+
+    void shutdown() override
+    {
+        lock_guard lg(_mtx);
+
+        // like asio, pending handlers are destroyed without invocation.
+        _wheel.clear([](timing_wheel_entry* e)
+        {
+            static_cast<entry*>(e)->_handler = nullptr;
+        });
+
+        ++_gen;
+        _armed = UINT64_MAX;
+        _driver.cancel();
+    }
+
+public:
+    explicit timing_wheel_service(asio::io_context& ioc)
+        : asio::execution_context::service(ioc), _ioc(ioc), _driver(ioc)
+    {}
+
+    ~timing_wheel_service()
+    {
+        DSK_ASSERT(_wheel.empty());
+    }
+
+    asio::io_context& context() noexcept { return _ioc; }
+
+    duration tick() const noexcept { return _tick; }
+
+    // Should be called when there is no pending entry.
+    void set_tick(duration d)
+    {
+        DSK_ASSERT(d > duration::zero());
+
+        lock_guard lg(_mtx);
+        DSK_ASSERT(_wheel.empty());
+
+        _tick     = d;
+        _base     = clock_type::now();
+        _baseTick = _wheel.now_tick();
+    }
+
+    size_t pending_count()
+    {
+        lock_guard lg(_mtx);
+        return _wheel.size();
+    }
+
+    // e should not be waiting.
+    void wait(entry& e, time_point t, handler_type&& h)
+    {
+        DSK_ASSERT(! e.is_linked());
+
+        e._handler = mut_move(h);
+
+        lock_guard lg(_mtx);
+
+        if(_wheel.empty())
+        {
+            // wheel is idle, jump to now, so it won't need to advance through the idle ticks.
+            _wheel.advance(tick_of(clock_type::now(), false), [](auto*){});
+        }
+
+        _wheel.insert(&e, tick_of(t, true));
+        arm_no_lock();
+    }
+
+    // If e is pending and not expired yet, its handler is posted with asio::error::operation_aborted.
+    // return whether it's canceled.
+    bool cancel(entry& e)
+    {
+        {
+            lock_guard lg(_mtx);
+
+            if(! _wheel.erase(&e))
+            {
+                return false;
+            }
+        }
+
+        // _driver is left armed, it's just a spurious wake up if the wheel has nothing to do then.
+        asio::post(_ioc, [h = mut_move(e._handler)]() mutable
+        {
+            h(asio::error::operation_aborted);
+        });
+
+        return true;
+    }
+
+    // Remove e without invoking its handler.
+    void remove(entry& e)
+    {
+        lock_guard lg(_mtx);
+
+        if(_wheel.erase(&e))
+        {
+            e._handler = nullptr;
+        }
+    }
+};
+
+
+inline auto& get_timing_wheel_service(asio::io_context& ioc = DSK_DEFAULT_IO_CONTEXT)
+{
+    return asio::use_service<timing_wheel_service>(ioc);
+}
+
+
+// Timer served by timing_wheel_service, can be used with timed ops:
+//     wait_for<wheel_timer>(d, op);
+// It's a one shot timer of fixed expiry, similar to steady_timer(ioc, td) with async_wait() and cancel().
+// Unlike steady_timer, it should not be destroyed while waiting, the handler would be dropped without invocation.
+class wheel_timer
+{
+public:
+    using clock_type    = timing_wheel_service::clock_type;
+    using time_point    = timing_wheel_service::time_point;
+    using duration      = timing_wheel_service::duration;
+    using executor_type = async_op_io_ctx_executor;
+
+private:
+    timing_wheel_service*       _svc;
+    time_point                  _expiry;
+    timing_wheel_service::entry _entry;
+
+    struct initiate_wait
+    {
+        wheel_timer* _t;
+
+        using executor_type = wheel_timer::executor_type;
+
+        executor_type get_executor() const noexcept { return _t->get_executor(); }
+
+        void operator()(auto&& h) const
+        {
+            auto slot = asio::get_associated_cancellation_slot(h);
+
+            if(slot.is_connected())
+            {
+                slot.assign([t = _t](asio::cancellation_type){ t->cancel(); });
+
+                _t->_svc->wait(_t->_entry, _t->_expiry, [h = DSK_FORWARD(h), slot](error_code const& ec) mutable
+                {
+                    slot.clear();
+                    mut_move(h)(ec);
+                });
+            }
+            else
+            {
+                _t->_svc->wait(_t->_entry, _t->_expiry, DSK_FORWARD(h));
+            }
+        }
+    };
+
+public:
+    wheel_timer(asio::io_context& ioc, time_point const& t)
+        : _svc(&get_timing_wheel_service(ioc)), _expiry(t)
+    {}
+
+    wheel_timer(asio::io_context& ioc, duration const& d)
+        : wheel_timer(ioc, now() + d)
+    {}
+
+    explicit wheel_timer(time_point const& t) : wheel_timer(DSK_DEFAULT_IO_CONTEXT, t) {}
+    explicit wheel_timer(duration   const& d) : wheel_timer(DSK_DEFAULT_IO_CONTEXT, d) {}
+
+    // only when not waiting
+    wheel_timer(wheel_timer&& r) noexcept
+        : _svc(r._svc), _expiry(r._expiry)
+    {
+        DSK_ASSERT(! r._entry.is_linked());
+    }
+
+    ~wheel_timer()
+    {
+        // Unlinking may race with the service thread, so is_linked() is
+        // only checked by remove() under the service lock.
+        _svc->remove(_entry);
+    }
+
+    static auto now() noexcept
+    {
+        return clock_type::now();
+    }
+
+    time_point expiry() const noexcept
+    {
+        return _expiry;
+    }
+
+    executor_type get_executor() const noexcept
+    {
+        return _svc->context().get_executor();
+    }
+
+    // Handler signature: void(error_code)
+    // Expiry is fixed at construction, only one wait at a time.
+    template<class Token = use_async_op_t>
+    auto async_wait(Token&& token = {})
+    {
+        return asio::async_initiate<Token, void(error_code)>(initiate_wait{this}, token);
+    }
+
+    auto wait()
+    {
+        return async_wait(use_async_op);
+    }
+
+    // return number of canceled waits, 0 or 1.
+    size_t cancel()
+    {
+        return _svc->cancel(_entry);
+    }
+};
+
+
+} // namespace dsk
@@ -1,7 +1,13 @@
 #pragma once
 
 #include <dsk/task.hpp>
+#include <dsk/until.hpp>
+#include <dsk/res_queue.hpp>
+#include <dsk/util/string.hpp>
+#include <dsk/util/vector.hpp>
 #include <dsk/asio/write.hpp>
+#include <utility>
+#include <variant>
 
 
 namespace dsk{
@@ -71,4 +77,125 @@ task<size_t> transfer(auto& from, auto& to, size_t count = -1)
 }
 
 
+struct transfer_options
+{
+    size_t count      = -1;         // -1 to transfer until eof.
+    size_t bufCount   = 2;          // at least 2.
+    size_t minBufSize = 4*1024;     // a read starts at minBufSize, doubled after each full read,
+    size_t maxBufSize = 256*1024;   // up to maxBufSize, and halved after a read less than 1/4 of it.
+};
+
+
+// Like transfer(), but a reader and a writer run concurrently, rotating opts.bufCount buffers between them,
+// so next read is in flight while previous write drains, and it runs at the speed of the slower side.
+// If either side failed, the other is canceled and the error is returned.
+task<size_t> pipelined_transfer(auto& from, auto& to, transfer_options opts = {})
+{
+    DSK_ASSERT(opts.bufCount >= 2);
+    DSK_ASSERT(0 < opts.minBufSize && opts.minBufSize <= opts.maxBufSize);
+
+    using filled_buf = std::pair<size_t, size_t>; // index, bytes
+
+    vector<string>        bufs(opts.bufCount);
+    res_queue<size_t>     freeBufs(opts.bufCount);
+    res_queue<filled_buf> filledBufs(opts.bufCount);
+    size_t                total = 0; // only touched by writer until both finished
+
+    for(size_t i = 0; i < opts.bufCount; ++i)
+    {
+        [[maybe_unused]] auto r = freeBufs.try_enqueue(i);
+        DSK_ASSERT(! has_err(r));
+    }
+
+    auto r = DSK_WAIT until_first_failed
+    (
+        // reader
+        [&]() -> task<>
+        {
+            size_t left     = opts.count;
+            size_t readSize = opts.minBufSize;
+
+            while(left > 0)
+            {
+                size_t i = DSK_TRY freeBufs.dequeue();
+                auto&  b = bufs[i];
+
+                resize_buf(b, std::min(left, readSize));
+
+                auto rr = DSK_WAIT from.async_read_some(asio_buf(b), use_async_op);
+
+                if(has_err(rr))
+                {
+                    if(get_err(rr) == asio::error::eof && opts.count == size_t(-1)) break;
+                    else                                                            DSK_THROW(get_err(rr));
+                }
+
+                size_t n = get_val(rr);
+
+                if     (n == buf_size(b))   readSize = std::min(readSize * 2, opts.maxBufSize);
+                else if(n < readSize / 4)   readSize = std::max(readSize / 2, opts.minBufSize);
+
+                if(opts.count != size_t(-1))
+                {
+                    left -= n;
+                }
+
+                DSK_TRY filledBufs.enqueue(filled_buf(i, n));
+            }
+
+            filledBufs.mark_end();
+            DSK_RETURN();
+        }(),
+        // writer
+        [&]() -> task<>
+        {
+            for(;;)
+            {
+                auto rf = DSK_WAIT filledBufs.dequeue();
+
+                if(has_err(rf))
+                {
+                    if(get_err(rf) == errc::end_reached) DSK_RETURN();
+                    else                                 DSK_THROW(get_err(rf));
+                }
+
+                auto [i, n] = get_val(rf);
+
+                DSK_TRY write(to, asio_buf(bufs[i], n));
+
+                total += n;
+
+                DSK_TRY freeBufs.enqueue(i);
+            }
+
+            DSK_UNREACHABLE();
+        }()
+    );
+
+    if(! has_err(r)) // one failed
+    {
+        DSK_THROW(std::visit([](auto& e){ return get_err(e); }, get_val(r)));
+    }
+
+    if(get_err(r) != errc::not_found) // canceled
+    {
+        DSK_THROW(get_err(r));
+    }
+
+    DSK_RETURN(total);
+}
+
+
+template<buf_size_t MaxBufSize>
+task<size_t> pipelined_transfer(auto& from, auto& to, size_t count = -1)
+{
+    static_assert(MaxBufSize >= 256);
+
+    transfer_options opts{.count = count, .maxBufSize = MaxBufSize};
+    opts.minBufSize = std::min(opts.minBufSize, opts.maxBufSize);
+
+    DSK_TRY_RETURN(pipelined_transfer(from, to, opts));
+}
+
+
 } // namespace dsk
@@ -1,7 +1,28 @@
 #pragma once
 
+#include <dsk/task.hpp>
 #include <dsk/asio/ip.hpp>
 #include <boost/asio/ip/udp.hpp>
+#include <span>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__linux__)
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/udp.h>
+    #include <cerrno>
+
+    #ifndef SOL_UDP
+        #define SOL_UDP 17
+    #endif
+    #ifndef UDP_SEGMENT
+        #define UDP_SEGMENT 103
+    #endif
+    #ifndef UDP_GRO
+        #define UDP_GRO 104
+    #endif
+#endif
 
 
 namespace dsk{
@@ -15,6 +36,241 @@ inline auto udp_v4() noexcept { return asio::ip::udp::v4(); }
 inline auto udp_v6() noexcept { return asio::ip::udp::v6(); }
 
 
+// A datagram of receive_batch()/send_batch().
+struct udp_msg
+{
+    std::span<std::byte> buf;              // to receive into, or to send.
+    udp_endpoint         peer;             // sender of received, or destination to send.
+    size_t               size = 0;         // bytes received/sent.
+    uint16_t             segSize = 0;      // send: if non-zero, buf is sent as datagrams of segSize bytes, by UDP_SEGMENT (GSO) on linux.
+                                           // receive: size of each coalesced datagram if GRO is enabled, the last one may be shorter.
+    bool                 truncated = false;// receive: datagram is larger than buf.
+};
+
+
+inline constexpr size_t udp_batch_max = 64; // msgs of a recvmmsg()/sendmmsg() call.
+
+
+#if defined(__linux__)
+
+
+// One recvmmsg()/sendmmsg() call without blocking for at most udp_batch_max msgs.
+// Returns number of msgs done, or -1 with errno set.
+inline int udp_mmsg(int fd, std::span<udp_msg> msgs, bool send, int flags) noexcept
+{
+    mmsghdr hdrs[udp_batch_max];
+    iovec   iovs[udp_batch_max];
+    alignas(cmsghdr) char ctrls[udp_batch_max][CMSG_SPACE(sizeof(int))];
+
+    unsigned n = static_cast<unsigned>(std::min(msgs.size(), udp_batch_max));
+
+    for(unsigned i = 0; i < n; ++i)
+    {
+        udp_msg& m = msgs[i];
+        msghdr&  h = hdrs[i].msg_hdr;
+
+        h = {};
+        hdrs[i].msg_len = 0;
+
+        iovs[i].iov_base = m.buf.data();
+        iovs[i].iov_len  = m.buf.size();
+
+        h.msg_iov     = &iovs[i];
+        h.msg_iovlen  = 1;
+        h.msg_name    = m.peer.data();
+        h.msg_namelen = static_cast<socklen_t>(send ? m.peer.size() : m.peer.capacity());
+
+        if(! send)
+        {
+            h.msg_control    = ctrls[i];
+            h.msg_controllen = sizeof(ctrls[i]);
+        }
+        else if(m.segSize)
+        {
+            h.msg_control    = ctrls[i];
+            h.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+
+            cmsghdr* c = CMSG_FIRSTHDR(&h);
+            c->cmsg_level = SOL_UDP;
+            c->cmsg_type  = UDP_SEGMENT;
+            c->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+            std::memcpy(CMSG_DATA(c), &m.segSize, sizeof(uint16_t));
+        }
+    }
+
+    int r = send ? ::sendmmsg(fd, hdrs, n, flags)
+                 : ::recvmmsg(fd, hdrs, n, flags, nullptr);
+
+    for(int i = 0; i < r; ++i)
+    {
+        udp_msg& m = msgs[i];
+        msghdr&  h = hdrs[i].msg_hdr;
+
+        m.size = hdrs[i].msg_len;
+
+        if(! send)
+        {
+            m.peer.resize(h.msg_namelen);
+            m.truncated = h.msg_flags & MSG_TRUNC;
+            m.segSize   = 0;
+
+            for(cmsghdr* c = CMSG_FIRSTHDR(&h); c; c = CMSG_NXTHDR(&h, c))
+            {
+                if(c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO)
+                {
+                    int segSize = 0;
+                    std::memcpy(&segSize, CMSG_DATA(c), sizeof(segSize));
+                    m.segSize = static_cast<uint16_t>(segSize);
+                }
+            }
+        }
+    }
+
+    return r;
+}
+
+
+// Receive datagrams into msgs by recvmmsg(), waiting for socket to be readable if none is ready.
+// Returns number of msgs received, at least 1, each with its sender in peer.
+task<size_t> receive_batch(auto& s, std::span<udp_msg> msgs, int flags = 0)
+{
+    DSK_ASSERT(! msgs.empty());
+
+    if(! s.native_non_blocking())
+    {
+        DSK_TRY_SYNC s.native_non_blocking(true);
+    }
+
+    size_t done = 0;
+
+    for(;;)
+    {
+        if(DSK_WAIT stop_requested())
+        {
+            DSK_THROW(errc::canceled);
+        }
+
+        int r = udp_mmsg(s.native_handle(), msgs.subspan(done), false, flags | MSG_DONTWAIT);
+
+        if(r >= 0)
+        {
+            done += static_cast<size_t>(r);
+
+            // less than asked means no more is ready.
+            if(done == msgs.size() || static_cast<size_t>(r) < udp_batch_max)
+            {
+                DSK_RETURN(done);
+            }
+        }
+        else if(done)
+        {
+            DSK_RETURN(done); // error is reported by next call.
+        }
+        else if(errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            DSK_TRY s.wait(DSK_NO_CVREF_T(s)::wait_read);
+        }
+        else if(errno != EINTR)
+        {
+            DSK_THROW(error_code(errno, system_category()));
+        }
+    }
+}
+
+
+// Send msgs by sendmmsg(), waiting for socket to be writable if it would block.
+// Returns number of msgs sent, which is less than msgs.size() only if an error occurred after some were sent.
+task<size_t> send_batch(auto& s, std::span<udp_msg> msgs, int flags = 0)
+{
+    if(! s.native_non_blocking())
+    {
+        DSK_TRY_SYNC s.native_non_blocking(true);
+    }
+
+    size_t done = 0;
+
+    while(done < msgs.size())
+    {
+        if(DSK_WAIT stop_requested())
+        {
+            DSK_THROW(errc::canceled);
+        }
+
+        int r = udp_mmsg(s.native_handle(), msgs.subspan(done), true, flags | MSG_DONTWAIT);
+
+        if(r >= 0)
+        {
+            done += static_cast<size_t>(r);
+        }
+        else if(errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            DSK_TRY s.wait(DSK_NO_CVREF_T(s)::wait_write);
+        }
+        else if(errno != EINTR)
+        {
+            if(done) DSK_RETURN(done);
+            DSK_THROW(error_code(errno, system_category()));
+        }
+    }
+
+    DSK_RETURN(done);
+}
+
+
+#else
+
+
+// One datagram per call, as there is no recvmmsg().
+task<size_t> receive_batch(auto& s, std::span<udp_msg> msgs, int flags = 0)
+{
+    DSK_ASSERT(! msgs.empty());
+
+    udp_msg& m = msgs[0];
+
+    m.size      = DSK_TRY s.receive_from(m.buf, m.peer, static_cast<asio::socket_base::message_flags>(flags));
+    m.segSize   = 0;
+    m.truncated = false;
+
+    DSK_RETURN(1);
+}
+
+
+// One datagram per call, segments of segSize are sent separately.
+task<size_t> send_batch(auto& s, std::span<udp_msg> msgs, int flags = 0)
+{
+    size_t done = 0;
+
+    for(udp_msg& m : msgs)
+    {
+        size_t segSize = m.segSize ? m.segSize : m.buf.size();
+
+        m.size = 0;
+
+        do
+        {
+            auto r = DSK_WAIT s.send_to(m.buf.subspan(m.size, std::min(segSize, m.buf.size() - m.size)),
+                                        m.peer, static_cast<asio::socket_base::message_flags>(flags));
+
+            if(has_err(r))
+            {
+                if(done) DSK_RETURN(done);
+                DSK_THROW(get_err(r));
+            }
+
+            m.size += get_val(r);
+        }
+        while(m.size < m.buf.size());
+
+        ++done;
+    }
+
+    DSK_RETURN(done);
+}
+
+
+#endif
+
+
 class udp_socket :
     public basic_socket<asio::ip::udp>
 {
@@ -42,6 +298,36 @@ public:
     {
         return base::async_send_to(mutableBufs, dest, f);
     }
+
+    // Result type: expected<size_t>, see dsk::receive_batch().
+    auto receive_batch(std::span<udp_msg> msgs, message_flags f = message_flags(0))
+    {
+        return dsk::receive_batch(*this, msgs, static_cast<int>(f));
+    }
+
+    // Result type: expected<size_t>, see dsk::send_batch().
+    auto send_batch(std::span<udp_msg> msgs, message_flags f = message_flags(0))
+    {
+        return dsk::send_batch(*this, msgs, static_cast<int>(f));
+    }
+
+    // Coalesce received datagrams of same flow into one msg (UDP_GRO), see udp_msg::segSize.
+    // errc::unsupported_op if not on linux.
+    error_code set_gro(bool on) noexcept
+    {
+#if defined(__linux__)
+        int v = on;
+
+        if(::setsockopt(native_handle(), SOL_UDP, UDP_GRO, &v, sizeof(v)) < 0)
+        {
+            return error_code(errno, system_category());
+        }
+
+        return {};
+#else
+        return errc::unsupported_op;
+#endif
+    }
 };
 
 
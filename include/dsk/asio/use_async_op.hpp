@@ -76,9 +76,18 @@ template<class T>
 concept _asio_execution_context_ = _derived_from_<T, asio::execution_context>;
 
 
+// exc is identified by its address, which equals that of asio_io_thread_pool running it,
+// or by the scheduler bound to calling thread running it, e.g. asio_sharded_io_thread_pool of a shard.
 constexpr void resume(_continuation_ auto&& cont, _scheduler_or_resumer_ auto&& sr, _asio_execution_context_ auto& exc)
 {
-    resume(DSK_FORWARD(cont), DSK_FORWARD(sr), static_cast<void*>(std::addressof(exc)));
+    void const* id = std::addressof(exc);
+
+    if(tl_io_thread.ctx == id)
+    {
+        id = tl_io_thread.sch;
+    }
+
+    resume(DSK_FORWARD(cont), DSK_FORWARD(sr), id);
 }
 
 constexpr void resume(_continuation_ auto&& cont, _scheduler_or_resumer_ auto&& sr, _asio_executor_ auto&& ex)
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <dsk/async_sync_op.hpp>
+#include <dsk/util/atomic.hpp>
+
+
+namespace dsk{
+
+
+// Manual-reset event.
+// wait() finishes immediately if set, otherwise suspends until set() is called.
+class async_event
+{
+    template<class, bool> friend class async_sync_acquire_op;
+
+    atomic<bool>                      _set{false};
+    mutex                             _mtx;
+    intrusive_list<async_sync_waiter> _waiters;
+
+    bool try_acquire_fast   (size_t) const noexcept { return _set.load(memory_order_acquire); }
+    bool try_acquire_no_lock(size_t) const noexcept { return _set.load(memory_order_acquire); }
+
+    void grant_no_lock(async_sync_granted_waiters&) noexcept {} // waiters are only resumed by set()
+
+public:
+    explicit async_event(bool initSet = false) noexcept
+        : _set(initSet)
+    {}
+
+    async_event(async_event const&) = delete;
+    async_event& operator=(async_event const&) = delete;
+
+    ~async_event()
+    {
+        DSK_ASSERT(_waiters.empty());
+    }
+
+    bool is_set() const noexcept
+    {
+        return _set.load(memory_order_acquire);
+    }
+
+    // Result type: expected<void, errc>
+    auto wait()
+    {
+        return async_sync_acquire_op<async_event, false>(this);
+    }
+
+    // Resume all current waiters.
+    void set()
+    {
+        async_sync_granted_waiters ws;
+
+        {
+            lock_guard lg(_mtx);
+
+            _set.store(true, memory_order_release);
+
+            while(auto* w = _waiters.pop_front())
+            {
+                ws.emplace_back(w);
+            }
+        }
+
+        complete_all(ws);
+    }
+
+    void reset() noexcept
+    {
+        _set.store(false, memory_order_relaxed);
+    }
+};
+
+
+} // namespace dsk
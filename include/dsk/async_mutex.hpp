@@ -0,0 +1,246 @@
+#pragma once
+
+#include <dsk/async_sync_op.hpp>
+#include <dsk/util/atomic.hpp>
+
+
+namespace dsk{
+
+
+// FIFO-fair mutex that suspends instead of blocking the thread.
+// Uncontended lock()/unlock() only touch an atomic.
+// On unlock(), the lock is handed to the oldest waiter directly, so newcomers can't barge in.
+class async_mutex
+{
+    template<class, bool> friend class async_sync_acquire_op;
+    friend class async_sync_guard<async_mutex>;
+
+    // 0: unlocked, 1: locked, 2: locked and there may be waiters.
+    atomic<int>                       _state{0};
+    mutex                             _mtx;
+    intrusive_list<async_sync_waiter> _waiters;
+
+    bool try_acquire_fast(size_t) noexcept
+    {
+        int e = 0;
+        return _state.compare_exchange_strong(e, 1, memory_order_acquire, memory_order_relaxed);
+    }
+
+    // Mark there may be waiters, so unlock() will take the slow path and find the waiter to be added.
+    bool try_acquire_no_lock(size_t) noexcept
+    {
+        return _state.exchange(2, memory_order_acquire) == 0;
+    }
+
+    void grant_no_lock(async_sync_granted_waiters&) noexcept {} // lock is only handed over in unlock()
+
+    void release_acquired(size_t) { unlock(); }
+
+public:
+    async_mutex() = default;
+
+    async_mutex(async_mutex const&) = delete;
+    async_mutex& operator=(async_mutex const&) = delete;
+
+    ~async_mutex()
+    {
+        DSK_ASSERT(_waiters.empty());
+    }
+
+    bool try_lock() noexcept
+    {
+        return try_acquire_fast(0);
+    }
+
+    // Result type: expected<void, errc>, unlock() should be called once locked.
+    auto lock()
+    {
+        return async_sync_acquire_op<async_mutex, false>(this);
+    }
+
+    // Result type: expected<async_sync_guard<async_mutex>, errc>, which unlocks on destruction.
+    auto scoped_lock()
+    {
+        return async_sync_acquire_op<async_mutex, true>(this);
+    }
+
+    void unlock()
+    {
+        int e = 1;
+
+        if(_state.compare_exchange_strong(e, 0, memory_order_release, memory_order_relaxed))
+        {
+            return;
+        }
+
+        DSK_ASSERT(e == 2);
+
+        async_sync_waiter* w = nullptr;
+
+        {
+            lock_guard lg(_mtx);
+
+            w = _waiters.pop_front();
+
+            if(! w)
+            {
+                _state.store(0, memory_order_release);
+                return;
+            }
+
+            // still locked, owned by w now.
+            if(_waiters.empty())
+            {
+                _state.store(1, memory_order_relaxed);
+            }
+        }
+
+        w->complete();
+    }
+};
+
+
+// FIFO-fair reader-writer mutex that suspends instead of blocking the thread.
+// A shared lock request doesn't overtake waiting exclusive ones.
+// On unlock, the front exclusive waiter or all consecutive front shared waiters are granted together.
+class async_shared_mutex
+{
+    template<class, bool> friend class async_sync_acquire_op;
+    friend class async_sync_guard<async_shared_mutex>;
+
+    static constexpr size_t exclusive_arg = 0;
+    static constexpr size_t shared_arg    = 1;
+
+    mutex                             _mtx;
+    intrusive_list<async_sync_waiter> _waiters;
+    size_t                            _readers = 0;
+    bool                              _writer  = false;
+
+    bool try_acquire_fast(size_t) noexcept { return false; }
+
+    bool try_grant_no_lock(size_t arg) noexcept
+    {
+        if(arg == shared_arg)
+        {
+            if(_writer)
+                return false;
+
+            ++_readers;
+        }
+        else
+        {
+            if(_writer || _readers)
+                return false;
+
+            _writer = true;
+        }
+
+        return true;
+    }
+
+    bool try_acquire_no_lock(size_t arg) noexcept
+    {
+        return _waiters.empty() && try_grant_no_lock(arg);
+    }
+
+    void grant_no_lock(async_sync_granted_waiters& ws)
+    {
+        while(auto* w = _waiters.front())
+        {
+            if(! try_grant_no_lock(w->_arg))
+            {
+                break;
+            }
+
+            _waiters.pop_front();
+            ws.emplace_back(w);
+        }
+    }
+
+    void release_acquired(size_t arg)
+    {
+        if(arg == shared_arg) unlock_shared();
+        else                  unlock();
+    }
+
+public:
+    async_shared_mutex() = default;
+
+    async_shared_mutex(async_shared_mutex const&) = delete;
+    async_shared_mutex& operator=(async_shared_mutex const&) = delete;
+
+    ~async_shared_mutex()
+    {
+        DSK_ASSERT(_waiters.empty());
+    }
+
+    bool try_lock()
+    {
+        lock_guard lg(_mtx);
+        return try_acquire_no_lock(exclusive_arg);
+    }
+
+    bool try_lock_shared()
+    {
+        lock_guard lg(_mtx);
+        return try_acquire_no_lock(shared_arg);
+    }
+
+    // Result type: expected<void, errc>, unlock() should be called once locked.
+    auto lock()
+    {
+        return async_sync_acquire_op<async_shared_mutex, false>(this, exclusive_arg);
+    }
+
+    // Result type: expected<void, errc>, unlock_shared() should be called once locked.
+    auto lock_shared()
+    {
+        return async_sync_acquire_op<async_shared_mutex, false>(this, shared_arg);
+    }
+
+    // Result type: expected<async_sync_guard<async_shared_mutex>, errc>, which unlocks on destruction.
+    auto scoped_lock()
+    {
+        return async_sync_acquire_op<async_shared_mutex, true>(this, exclusive_arg);
+    }
+
+    auto scoped_lock_shared()
+    {
+        return async_sync_acquire_op<async_shared_mutex, true>(this, shared_arg);
+    }
+
+    void unlock()
+    {
+        async_sync_granted_waiters ws;
+
+        {
+            lock_guard lg(_mtx);
+            DSK_ASSERT(_writer);
+
+            _writer = false;
+            grant_no_lock(ws);
+        }
+
+        complete_all(ws);
+    }
+
+    void unlock_shared()
+    {
+        async_sync_granted_waiters ws;
+
+        {
+            lock_guard lg(_mtx);
+            DSK_ASSERT(_readers > 0);
+
+            if(--_readers == 0)
+            {
+                grant_no_lock(ws);
+            }
+        }
+
+        complete_all(ws);
+    }
+};
+
+
+} // namespace dsk
@@ -8,6 +8,7 @@
 #include <dsk/util/mutex.hpp>
 #include <dsk/util/atomic.hpp>
 #include <dsk/util/allocate_unique.hpp>
+#include <dsk/util/recycling_allocator.hpp>
 #include <optional>
 
 
@@ -162,6 +163,160 @@ auto make_async_op_group(ResultHandler&& rh = ResultHandler{})
 }
 
 
+// Like async_op_group, but without mutex and per group allocation.
+// Each added op is stored inline in its own node allocated with Alloc (recycled by default),
+// which frees itself as soon as the op is done. Outstanding ops are tracked by an atomic counter,
+// so only the final completion synchronizes with until_all_done().
+// Ops should be added by a single owner, and no more op should be added once until_all_done() is initiated,
+// until it finishes, after which the group can be reused.
+// NOTE: nodes refer to the group, so it's neither copyable nor movable.
+template<_async_ctx_ Ctx, class ResultHanlder = null_op_t, class Alloc = recycling_allocator<>>
+class pooled_async_op_group
+{
+    template<class Op>
+    struct node_t
+    {
+        pooled_async_op_group* g;
+        Op                     op;
+    };
+
+    template<class Op>
+    using node_allocator = rebind_alloc<Alloc, node_t<Op>>;
+
+    DSK_NO_UNIQUE_ADDR Ctx           _ctx;
+    DSK_NO_UNIQUE_ADDR ResultHanlder _rh;
+    atomic<size_t>                   _n = 1; // outstanding ops + 1, the extra one is only removed while until_all_done() is waiting.
+    atomic<errc>                     _err{};
+    continuation                     _cont;
+
+    void on_op_done()
+    {
+        if(_n.fetch_sub(1, memory_order_acq_rel) == 1)
+        {
+            // no op is outstanding and the owner is waiting, so the group can be reset for reuse.
+            continuation cont = std::exchange(_cont, {});
+            _n.store(1, memory_order_relaxed);
+
+            //resume(mut_move(cont), _ctx);
+            mut_move(cont)();
+        }
+    }
+
+public:
+    explicit pooled_async_op_group(_async_ctx_ auto&& ctx) : _ctx(DSK_FORWARD(ctx)) {}
+    pooled_async_op_group(_async_ctx_ auto&& ctx, auto&& rh) : _ctx(DSK_FORWARD(ctx)), _rh(DSK_FORWARD(rh)) {}
+
+    // Also add until_all_done() to cleanup scope of ctx, see make_pooled_async_op_group().
+    // The group should be constructed in place where it lives until the scope ends.
+    struct with_cleanup_t{};
+
+    pooled_async_op_group(with_cleanup_t, _async_ctx_ auto& ctx, auto&& rh) : _ctx(ctx), _rh(DSK_FORWARD(rh))
+    {
+        add_cleanup(ctx, until_all_done());
+    }
+
+    pooled_async_op_group(pooled_async_op_group const&) = delete;
+    pooled_async_op_group& operator=(pooled_async_op_group const&) = delete;
+
+    ~pooled_async_op_group()
+    {
+        // must wait until all done, as added ops were initiated.
+        DSK_ASSERT(_n.load(memory_order_relaxed) == 1);
+    }
+
+    // must set before adding any op
+    void set_result_handler(auto&& rh)
+    {
+        _rh = DSK_FORWARD(rh);
+    }
+
+    // approximate number of outstanding ops
+    size_t size() const noexcept
+    {
+        return _n.load(memory_order_relaxed) - 1;
+    }
+
+    void add_and_initiate(_async_op_ auto&& op)
+    {
+        using node_type = node_t<DSK_DECAY_T(op)>;
+        using alloc     = node_allocator<DSK_DECAY_T(op)>;
+
+        DSK_ASSERT(! _cont);
+
+        node_type* node = allocate_unique<node_type>(alloc(), this, DSK_FORWARD(op)).release();
+
+        _n.fetch_add(1, memory_order_relaxed);
+
+        manual_initiate(node->op, _ctx, [node]()
+        {
+            pooled_async_op_group* g = node->g;
+
+            g->_rh(node->op);
+
+            if(is_failed(node->op))
+            {
+                g->_err.store(errc::one_or_more_ops_failed, memory_order_relaxed);
+            }
+
+            allocated_unique_ptr<node_type, alloc>(node).reset(); // free node before group may be destroyed
+
+            g->on_op_done();
+        });
+    }
+
+    struct [[nodiscard]] until_all_done_op
+    {
+        pooled_async_op_group& _g;
+
+        using is_async_op = void;
+
+        bool initiate(_continuation_ auto&& cont)
+        {
+            // no cancel check, as added ops were initiated
+            // and must be waited until all done.
+
+            DSK_ASSERT(! _g._cont);
+
+            if(_g._n.load(memory_order_acquire) == 1)
+            {
+                return false;
+            }
+
+            _g._cont = DSK_FORWARD(cont);
+            _g.on_op_done(); // remove the extra count
+            return true;
+        }
+
+        bool is_failed() const noexcept { return has_err(_g._err.load(memory_order_relaxed)); }
+        errc take_result() noexcept { return _g._err.exchange(errc{}, memory_order_relaxed); } // reset for reuse
+    };
+
+    auto until_all_done()
+    {
+        return until_all_done_op(*this);
+    }
+};
+
+template<class C         > pooled_async_op_group(C   ) -> pooled_async_op_group<C   >;
+template<class C, class R> pooled_async_op_group(C, R) -> pooled_async_op_group<C, R>;
+
+// Create a pooled_async_op_group using current _async_ctx_.
+// NOTE: like make_async_op_group(), until_all_done() will be added to current cleanup scope,
+//       so ops are still waited if the scope is exited early, e.g. by DSK_TRY or cancellation.
+//       The group is constructed in place, its lifetime must match the scope:
+//
+//          auto grp = DSK_WAIT make_pooled_async_op_group();
+template<class ResultHandler = null_op_t>
+auto make_pooled_async_op_group(ResultHandler&& rh = ResultHandler{})
+{
+    return invoke_with_async_ctx([rh = DSK_FORWARD(rh)](_async_ctx_ auto&& ctx) mutable
+    {
+        using grp_type = pooled_async_op_group<DSK_DECAY_T(ctx), DSK_DECAY_T(rh)>;
+        return grp_type(typename grp_type::with_cleanup_t{}, ctx, mut_move(rh));
+    });
+}
+
+
 template<_async_ctx_ Ctx, class ResultHanlder = null_op_t, errc Err = errc::one_or_more_ops_failed>
 class lazy_async_op_group
 {
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <dsk/async_sync_op.hpp>
+
+
+namespace dsk{
+
+
+// FIFO-fair counting semaphore that suspends instead of blocking the thread.
+// An acquire request doesn't overtake waiting ones, even if there are enough units for it.
+class async_semaphore
+{
+    template<class, bool> friend class async_sync_acquire_op;
+    friend class async_sync_guard<async_semaphore>;
+
+    mutex                             _mtx;
+    intrusive_list<async_sync_waiter> _waiters;
+    size_t                            _count = 0;
+
+    bool try_acquire_fast(size_t) noexcept { return false; }
+
+    bool try_acquire_no_lock(size_t n) noexcept
+    {
+        if(_waiters.empty() && _count >= n)
+        {
+            _count -= n;
+            return true;
+        }
+
+        return false;
+    }
+
+    void grant_no_lock(async_sync_granted_waiters& ws)
+    {
+        while(auto* w = _waiters.front())
+        {
+            if(w->_arg > _count)
+            {
+                break;
+            }
+
+            _count -= w->_arg;
+            _waiters.pop_front();
+            ws.emplace_back(w);
+        }
+    }
+
+    void release_acquired(size_t n) { release(n); }
+
+public:
+    explicit async_semaphore(size_t initCount = 0) noexcept
+        : _count(initCount)
+    {}
+
+    async_semaphore(async_semaphore const&) = delete;
+    async_semaphore& operator=(async_semaphore const&) = delete;
+
+    ~async_semaphore()
+    {
+        DSK_ASSERT(_waiters.empty());
+    }
+
+    size_t available()
+    {
+        lock_guard lg(_mtx);
+        return _count;
+    }
+
+    bool try_acquire(size_t n = 1)
+    {
+        lock_guard lg(_mtx);
+        return try_acquire_no_lock(n);
+    }
+
+    // Result type: expected<void, errc>, release(n) should be called once acquired.
+    auto acquire(size_t n = 1)
+    {
+        return async_sync_acquire_op<async_semaphore, false>(this, n);
+    }
+
+    // Result type: expected<async_sync_guard<async_semaphore>, errc>, which releases n units on destruction.
+    auto scoped_acquire(size_t n = 1)
+    {
+        return async_sync_acquire_op<async_semaphore, true>(this, n);
+    }
+
+    void release(size_t n = 1)
+    {
+        async_sync_granted_waiters ws;
+
+        {
+            lock_guard lg(_mtx);
+            DSK_ASSERT(SIZE_MAX - _count >= n);
+
+            _count += n;
+            grant_no_lock(ws);
+        }
+
+        complete_all(ws);
+    }
+};
+
+
+} // namespace dsk
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <dsk/async_op.hpp>
+#include <dsk/any_resumer.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/mutex.hpp>
+#include <dsk/util/small_vector.hpp>
+#include <dsk/util/intrusive_list.hpp>
+#include <utility>
+
+
+namespace dsk{
+
+
+// Common waiter protocol of async_mutex, async_shared_mutex, async_semaphore and async_event.
+//
+// Prim should provide (accessible to async_sync_acquire_op and async_sync_guard):
+//     mutex _mtx;
+//     intrusive_list<async_sync_waiter> _waiters;
+//     bool try_acquire_fast(size_t arg);                     // may be lock free, without _mtx locked.
+//     bool try_acquire_no_lock(size_t arg);                  // with _mtx locked, should respect _waiters for fairness.
+//     void grant_no_lock(async_sync_granted_waiters& ws);    // with _mtx locked, grant front waiters as far as possible.
+//     void release_acquired(size_t arg);                     // only if used by async_sync_guard.
+
+
+class async_sync_waiter : public intrusive_list_hook // linked in Prim::_waiters while waiting
+{
+public:
+    size_t       _arg = 0; // Prim specific, e.g. units of semaphore, whether is shared lock.
+    errc         _err{};
+    any_resumer  _resumer;
+    continuation _cont;
+
+    // when invoked, this op should have been removed from _waiters, but still on same address,
+    // so request_stop() won't affect result at this point.
+    void complete(errc e = {})
+    {
+        _err = e;
+
+        //_scb.reset();
+        resume(mut_move(_cont), _resumer);
+    }
+};
+
+// Waiters granted under lock, to be completed outside of lock.
+// Mostly there are only few, so no allocation for them.
+using async_sync_granted_waiters = small_vector<async_sync_waiter*, 4>;
+
+inline void complete_all(async_sync_granted_waiters& ws)
+{
+    for(auto* w : ws)
+    {
+        w->complete();
+    }
+}
+
+
+// Release the acquired Prim on destruction.
+template<class Prim>
+class async_sync_guard
+{
+    Prim*  _p   = nullptr;
+    size_t _arg = 0;
+
+public:
+    async_sync_guard() = default;
+
+    async_sync_guard(Prim* p, size_t arg) noexcept
+        : _p(p), _arg(arg)
+    {}
+
+    async_sync_guard(async_sync_guard&& r) noexcept
+        : _p(std::exchange(r._p, nullptr)), _arg(r._arg)
+    {}
+
+    async_sync_guard& operator=(async_sync_guard&& r)
+    {
+        if(this != std::addressof(r))
+        {
+            reset();
+            _p   = std::exchange(r._p, nullptr);
+            _arg = r._arg;
+        }
+
+        return *this;
+    }
+
+    ~async_sync_guard() { reset(); }
+
+    bool owns() const noexcept
+    {
+        return _p;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return owns();
+    }
+
+    void reset()
+    {
+        if(_p)
+        {
+            std::exchange(_p, nullptr)->release_acquired(_arg);
+        }
+    }
+};
+
+
+// If Scoped, result type is expected<async_sync_guard<Prim>, errc>, else expected<void, errc>.
+template<class Prim, bool Scoped>
+class async_sync_acquire_op : public async_sync_waiter
+{
+    Prim*                  _p = nullptr;
+    optional_stop_callback _scb; // must be last one defined
+
+    static void cancel(Prim* p, async_sync_waiter* w)
+    {
+        async_sync_granted_waiters ws;
+
+        {
+            lock_guard lg(p->_mtx);
+
+            // O(1), w is unlinked when it's granted.
+            if(! p->_waiters.erase(w))
+            {
+                return;
+            }
+
+            // w may block waiters behind it.
+            p->grant_no_lock(ws);
+        }
+
+        w->complete(errc::canceled);
+        complete_all(ws);
+    }
+
+public:
+    explicit async_sync_acquire_op(Prim* p, size_t arg = 0) noexcept
+        : _p(p)
+    {
+        _arg = arg;
+    }
+
+    using is_async_op = void;
+
+    bool initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
+    {
+        if(stop_requested(ctx))
+        {
+            _err = errc::canceled;
+            return false;
+        }
+
+        // uncontended, never touches _mtx nor scheduler.
+        if(_p->try_acquire_fast(_arg))
+        {
+            return false;
+        }
+
+        {
+            lock_guard lg(_p->_mtx);
+
+            if(_p->try_acquire_no_lock(_arg))
+            {
+                return false;
+            }
+
+            _resumer = get_resumer(ctx);
+            _cont = DSK_FORWARD(cont);
+
+            if(stop_possible(ctx))
+            {
+                _scb.emplace(get_stop_token(ctx), [this]()
+                {
+                    cancel(_p, this);
+                });
+            }
+
+            _p->_waiters.push_back(this); // when initiate() gets called, this op should be
+        }                                 // in its final place, so its address shouldn't change.
+
+        return true;
+    }
+
+    bool is_failed() const noexcept
+    {
+        return has_err(_err);
+    }
+
+    auto take_result() noexcept
+    {
+        if constexpr(Scoped)
+        {
+            return gen_expected_if_no(_err, [&](){ return async_sync_guard<Prim>(_p, _arg); });
+        }
+        else
+        {
+            return make_expected_if_no(_err);
+        }
+    }
+};
+
+
+} // namespace dsk
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <dsk/generator.hpp>
+#include <dsk/res_queue.hpp>
+#include <dsk/start_on.hpp>
+#include <dsk/async_event.hpp>
+#include <dsk/async_op_group.hpp>
+#include <dsk/inline_scheduler.hpp>
+#include <dsk/util/vector.hpp>
+#include <dsk/util/atomic.hpp>
+#include <array>
+#include <optional>
+
+
+namespace dsk{
+
+
+// Pipeline stages over generator<T, E, Alloc>.
+//
+// A plain generator runs in lockstep with its consumer, the producer only runs inside next().
+// Stages here run producers/mappers as ops of an async_op_group, which are decoupled from consumer by a queue,
+// so producing and consuming are overlapped:
+//
+//      auto chunks = batch(map_on(buffered(read_lines(file), 64, ioPool), cpuPool, parse, 8), 1000);
+//
+//      while(auto c = DSK_TRY chunks.next())
+//      {
+//          DSK_TRY insert_rows(*c);
+//      }
+//
+// The ops are stopped and waited on cleanup of the stage, so a stage can be abandoned like any generator.
+// As with generator, cleanup scope must match the stage's lifetime.
+
+
+// async_op_group using current _async_ctx_ with 's' as stop source.
+// Cleanup of current scope requests stop on 's' and waits all ops done.
+inline auto make_stoppable_async_op_group(inplace_stop_source& s)
+{
+    return invoke_with_async_ctx([&s](_async_ctx_ auto&& ctx)
+    {
+        async_op_group grp(make_async_ctx(ctx, std::ref(s)));
+        add_cleanup(ctx, grp.until_all_done());
+        add_cleanup(ctx, sync_async_op([&s](){ s.request_stop(); }));
+        return grp;
+    });
+}
+
+
+// Move all items of g into q.
+// The first error of g is stored in 'err', and ends q.
+// q is ended when the last of 'nPumps' pumps finishes.
+// If 'ss' is shared by pumps, the first failed one requests stop on it to stop the others,
+// and only that one stores its error, as errors of the others are likely caused by the stop.
+template<class T, class E, class Alloc>
+task<void, E, Alloc> pump_generator(generator<T, E, Alloc>& g, res_queue<T>& q, E& err, atomic<size_t>& nPumps,
+                                    inplace_stop_source* ss = nullptr)
+{
+    for(;;)
+    {
+        auto r = DSK_WAIT g.next();
+
+        if(has_err(r))
+        {
+            if(! ss || ss->request_stop())
+            {
+                err = get_err(r);
+            }
+
+            q.mark_end();
+            break;
+        }
+
+        auto& v = get_val(r);
+
+        if(! v)
+        {
+            break;
+        }
+
+        if(has_err(DSK_WAIT q.enqueue(mut_move(*v)))) // end marked or stop requested
+        {
+            break;
+        }
+    }
+
+    if(nPumps.fetch_sub(1, memory_order_acq_rel) == 1)
+    {
+        q.mark_end();
+    }
+
+    DSK_RETURN();
+}
+
+
+// Run g up to n items ahead of consumer on 'sr'.
+// Without 'sr', g is pumped by whoever resumes it, e.g. the io thread its ops complete on.
+template<class T, class E, class Alloc, _scheduler_or_resumer_ SR = inline_scheduler>
+generator<T, E, Alloc> buffered(generator<T, E, Alloc> g, size_t n, SR sr = {})
+{
+    DSK_ASSERT(n > 0);
+
+    res_queue<T>        q(n);
+    E                   err{};
+    atomic<size_t>      nPumps{1};
+    inplace_stop_source ss;
+
+    auto grp = DSK_WAIT make_stoppable_async_op_group(ss);
+
+    grp.add_and_initiate(run_on(sr, pump_generator(g, q, err, nPumps)));
+
+    for(;;)
+    {
+        auto r = DSK_WAIT q.dequeue();
+
+        if(has_err(r))
+        {
+            if(get_err(r) != errc::end_reached)
+            {
+                DSK_THROW(get_err(r));
+            }
+
+            break;
+        }
+
+        DSK_YIELD mut_move(get_val(r));
+    }
+
+    if(has_err(err))
+    {
+        DSK_THROW(err);
+    }
+
+    DSK_RETURN();
+}
+
+
+template<class F, class T, class R = std::invoke_result_t<F&, T>>
+struct map_on_traits
+{
+    using raw_result_type = R;
+};
+
+template<class F, class T, _async_op_ R>
+struct map_on_traits<F, T, R>
+{
+    using raw_result_type = decltype(take_result(std::declval<R&>()));
+};
+
+template<class R>
+struct map_on_value
+{
+    using type = std::remove_cvref_t<R>;
+};
+
+template<_result_ R>
+struct map_on_value<R>
+{
+    using type = std::remove_cvref_t<val_t<R>>;
+};
+
+template<class F, class T>
+using map_on_raw_result_t = typename map_on_traits<F, T>::raw_result_type;
+
+template<class F, class T>
+using map_on_value_t = typename map_on_value<map_on_raw_result_t<F, T>>::type;
+
+
+template<class R>
+struct map_on_slot
+{
+    async_event      done;
+    std::optional<R> r;
+};
+
+template<class E, class Alloc>
+task<void, E, Alloc> map_on_invoke(auto& f, auto v, auto& slot)
+{
+    if constexpr(_async_op_<decltype(f(mut_move(v)))>) slot.r.emplace(DSK_WAIT f(mut_move(v)));
+    else                                               slot.r.emplace(f(mut_move(v)));
+
+    slot.done.set();
+    DSK_RETURN();
+}
+
+// Map each item of g with f on 'sr', with up to maxInFlight items mapped in parallel.
+// Output is in order of input.
+// f(T) can return a value, a _result_, or an _async_op_ of them, errors are rethrown by the stage.
+// f may be invoked concurrently.
+template<
+    class T, class E, class Alloc, _scheduler_or_resumer_ SR, class F,
+    class U = map_on_value_t<F, T>
+>
+generator<U, E, Alloc> map_on(generator<T, E, Alloc> g, SR sr, F f, size_t maxInFlight)
+{
+    using raw_result_t = map_on_raw_result_t<F, T>;
+
+    static_assert(! _void_<U>, "f should return a value");
+
+    DSK_ASSERT(maxInFlight > 0);
+
+    vector<map_on_slot<raw_result_t>> slots(maxInFlight);
+    size_t                            head     = 0;
+    size_t                            inFlight = 0;
+    bool                              srcEnded = false;
+    inplace_stop_source               ss;
+
+    auto grp = DSK_WAIT make_stoppable_async_op_group(ss);
+
+    for(;;)
+    {
+        while(! srcEnded && inFlight < maxInFlight)
+        {
+            auto v = DSK_TRY g.next();
+
+            if(! v)
+            {
+                srcEnded = true;
+                break;
+            }
+
+            auto& s = slots[(head + inFlight) % maxInFlight];
+
+            s.done.reset();
+            s.r.reset();
+
+            grp.add_and_initiate(run_on(sr, map_on_invoke<E, Alloc>(f, mut_move(*v), s)));
+            ++inFlight;
+        }
+
+        if(! inFlight)
+        {
+            break;
+        }
+
+        auto& s = slots[head];
+
+        DSK_TRY s.done.wait();
+
+        head = (head + 1) % maxInFlight;
+        --inFlight;
+
+        if constexpr(_result_<raw_result_t>) DSK_YIELD DSK_TRY_SYNC mut_move(*s.r);
+        else                                 DSK_YIELD mut_move(*s.r);
+    }
+
+    DSK_RETURN();
+}
+
+
+// Group consecutive items of g into vectors of n items, the last one may have less.
+template<class T, class E, class Alloc>
+generator<vector<T>, E, Alloc> batch(generator<T, E, Alloc> g, size_t n)
+{
+    DSK_ASSERT(n > 0);
+
+    vector<T> b;
+    b.reserve(n);
+
+    while(auto v = DSK_TRY g.next())
+    {
+        b.emplace_back(mut_move(*v));
+
+        if(b.size() == n)
+        {
+            DSK_YIELD mut_move(b);
+            b = vector<T>();
+            b.reserve(n);
+        }
+    }
+
+    if(b.size())
+    {
+        DSK_YIELD mut_move(b);
+    }
+
+    DSK_RETURN();
+}
+
+
+// Items of all gens in order of arrival.
+// Each generator is pumped by whoever resumes it, wrap with buffered() to run it on a scheduler.
+// It fails with the first error of gens, on which stop is requested on the rest.
+template<class T, class E, class Alloc, _same_as_<generator<T, E, Alloc>>... Gens>
+generator<T, E, Alloc> merge(generator<T, E, Alloc> g, Gens... gens)
+{
+    constexpr size_t nGen = sizeof...(Gens) + 1;
+
+    res_queue<T>         q(nGen);
+    std::array<E, nGen>  errs{};
+    atomic<size_t>       nPumps{nGen};
+    inplace_stop_source  ss;
+
+    auto grp = DSK_WAIT make_stoppable_async_op_group(ss);
+
+    [&]<size_t... I>(std::index_sequence<I...>, auto&... gs)
+    {
+        (grp.add_and_initiate(pump_generator(gs, q, errs[I], nPumps, &ss)), ...);
+    }(std::make_index_sequence<nGen>(), g, gens...);
+
+    for(;;)
+    {
+        auto r = DSK_WAIT q.dequeue();
+
+        if(has_err(r))
+        {
+            if(get_err(r) != errc::end_reached)
+            {
+                DSK_THROW(get_err(r));
+            }
+
+            break;
+        }
+
+        DSK_YIELD mut_move(get_val(r));
+    }
+
+    for(auto& e : errs)
+    {
+        if(has_err(e))
+        {
+            DSK_THROW(e);
+        }
+    }
+
+    DSK_RETURN();
+}
+
+
+} // namespace dsk
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/thread.hpp>
+#include <cstdint>
+#include <type_traits>
+
+
+namespace dsk{
+
+
+// Stop source/token/callback like std ones, but the state lives in inplace_stop_source itself,
+// and callbacks are linked into it intrusively, so nothing is allocated.
+// Meant to be a member of op state or a local of coroutine frame, which outlives all tokens and callbacks of it.
+
+
+class inplace_stop_source;
+
+template<class F>
+class inplace_stop_callback;
+
+
+class inplace_stop_callback_base
+{
+    friend class inplace_stop_source;
+
+protected:
+    using exec_fn = void(inplace_stop_callback_base*) noexcept;
+
+    inplace_stop_source const*   _src;
+    exec_fn*                     _exec;
+    inplace_stop_callback_base*  _next    = nullptr;
+    inplace_stop_callback_base** _prevPtr = nullptr; // null if not in list
+    bool*                        _removedDuringCallback = nullptr;
+    atomic<bool>                 _callbackCompleted{false};
+
+    inplace_stop_callback_base(inplace_stop_source const* src, exec_fn* exec) noexcept
+        : _src(src), _exec(exec)
+    {}
+
+    inplace_stop_callback_base(inplace_stop_callback_base const&) = delete;
+    inplace_stop_callback_base& operator=(inplace_stop_callback_base const&) = delete;
+
+    void register_callback() noexcept;
+    void deregister_callback() noexcept;
+};
+
+
+class inplace_stop_token
+{
+    template<class F>
+    friend class inplace_stop_callback;
+    friend class inplace_stop_source;
+
+    inplace_stop_source const* _src = nullptr;
+
+    explicit inplace_stop_token(inplace_stop_source const* src) noexcept : _src(src) {}
+
+public:
+    template<class F>
+    using callback_type = inplace_stop_callback<F>;
+
+    inplace_stop_token() = default;
+
+    bool stop_requested() const noexcept;
+    bool stop_possible() const noexcept { return _src != nullptr; }
+
+    friend bool operator==(inplace_stop_token const&, inplace_stop_token const&) = default;
+};
+
+
+class inplace_stop_source
+{
+    friend class inplace_stop_callback_base;
+
+    static constexpr uint8_t stop_requested_flag = 1;
+    static constexpr uint8_t locked_flag         = 2;
+
+    using thread_id = decltype(this_thread::get_id());
+
+    mutable atomic<uint8_t>             _state{0};
+    mutable inplace_stop_callback_base* _callbacks = nullptr;
+            thread_id                   _notifyingThread{};
+
+    // return state before locked.
+    uint8_t lock() const noexcept
+    {
+        uint8_t s = _state.load(memory_order_relaxed);
+
+        for(;;)
+        {
+            while(s & locked_flag)
+            {
+                this_thread::yield();
+                s = _state.load(memory_order_relaxed);
+            }
+
+            if(_state.compare_exchange_weak(s, s | locked_flag, memory_order_acquire, memory_order_relaxed))
+            {
+                return s;
+            }
+        }
+    }
+
+    void unlock(uint8_t s) const noexcept
+    {
+        _state.store(s, memory_order_release);
+    }
+
+    bool try_lock_unless_stop_requested(bool setStopRequested) const noexcept
+    {
+        uint8_t s = _state.load(memory_order_relaxed);
+
+        for(;;)
+        {
+            while(s & locked_flag)
+            {
+                if(s & stop_requested_flag)
+                {
+                    return false;
+                }
+
+                this_thread::yield();
+                s = _state.load(memory_order_relaxed);
+            }
+
+            if(s & stop_requested_flag)
+            {
+                return false;
+            }
+
+            uint8_t ns = s | locked_flag | (setStopRequested ? stop_requested_flag : 0);
+
+            if(_state.compare_exchange_weak(s, ns, memory_order_acq_rel, memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+    }
+
+    // return false if stop has been requested, then cb is not added.
+    bool try_add_callback(inplace_stop_callback_base* cb) const noexcept
+    {
+        if(! try_lock_unless_stop_requested(false))
+        {
+            return false;
+        }
+
+        cb->_next    = _callbacks;
+        cb->_prevPtr = &_callbacks;
+
+        if(_callbacks)
+        {
+            _callbacks->_prevPtr = &cb->_next;
+        }
+
+        _callbacks = cb;
+
+        unlock(0);
+        return true;
+    }
+
+    void remove_callback(inplace_stop_callback_base* cb) const noexcept
+    {
+        uint8_t s = lock();
+
+        if(cb->_prevPtr) // not invoked yet
+        {
+            *cb->_prevPtr = cb->_next;
+
+            if(cb->_next)
+            {
+                cb->_next->_prevPtr = cb->_prevPtr;
+            }
+
+            unlock(s);
+            return;
+        }
+
+        thread_id notifyingThread = _notifyingThread;
+        unlock(s);
+
+        // cb is being invoked or has been invoked by request_stop().
+        if(this_thread::get_id() == notifyingThread)
+        {
+            // removed inside cb itself, tell request_stop() not to touch it any more.
+            if(cb->_removedDuringCallback)
+            {
+                *cb->_removedDuringCallback = true;
+            }
+        }
+        else
+        {
+            cb->_callbackCompleted.wait(false, memory_order_acquire);
+        }
+    }
+
+public:
+    using token_type = inplace_stop_token;
+
+    inplace_stop_source() = default;
+
+    // A copied/moved source is a new one, only for moving op state around before use.
+    inplace_stop_source([[maybe_unused]] inplace_stop_source const& r) noexcept { DSK_ASSERT(! r._callbacks); }
+    inplace_stop_source& operator=([[maybe_unused]] inplace_stop_source const& r) noexcept
+    {
+        DSK_ASSERT(! _callbacks && ! r._callbacks);
+        reset();
+        return *this;
+    }
+
+    ~inplace_stop_source()
+    {
+        DSK_ASSERT(! _callbacks);
+    }
+
+    // Clear stop state, so it can be reused by next run of op.
+    // No callback should be registered.
+    void reset() noexcept
+    {
+        DSK_ASSERT(! _callbacks);
+        _state.store(0, memory_order_relaxed);
+    }
+
+    bool stop_requested() const noexcept { return _state.load(memory_order_acquire) & stop_requested_flag; }
+    constexpr bool stop_possible() const noexcept { return true; }
+
+    inplace_stop_token get_token() const noexcept { return inplace_stop_token(this); }
+
+    // Return true if stop is requested by this call.
+    // Callbacks are invoked on calling thread, and a callback being destroyed waits for its invocation to finish,
+    // unless destroyed by itself.
+    bool request_stop() noexcept
+    {
+        if(! try_lock_unless_stop_requested(true))
+        {
+            return false;
+        }
+
+        _notifyingThread = this_thread::get_id();
+
+        while(_callbacks)
+        {
+            inplace_stop_callback_base* cb = _callbacks;
+
+            cb->_prevPtr = nullptr;
+            _callbacks   = cb->_next;
+
+            if(_callbacks)
+            {
+                _callbacks->_prevPtr = &_callbacks;
+            }
+
+            unlock(stop_requested_flag);
+
+            bool removedDuringCallback = false;
+            cb->_removedDuringCallback = &removedDuringCallback;
+
+            cb->_exec(cb);
+
+            if(! removedDuringCallback)
+            {
+                cb->_removedDuringCallback = nullptr;
+                cb->_callbackCompleted.store(true, memory_order_release);
+                cb->_callbackCompleted.notify_all();
+            }
+
+            lock();
+        }
+
+        unlock(stop_requested_flag);
+        return true;
+    }
+};
+
+
+inline bool inplace_stop_token::stop_requested() const noexcept
+{
+    return _src && _src->stop_requested();
+}
+
+
+inline void inplace_stop_callback_base::register_callback() noexcept
+{
+    if(_src && ! _src->try_add_callback(this))
+    {
+        _src = nullptr;
+        _exec(this); // stop already requested
+    }
+}
+
+inline void inplace_stop_callback_base::deregister_callback() noexcept
+{
+    if(_src)
+    {
+        _src->remove_callback(this);
+    }
+}
+
+
+// Invoke F on request_stop() of the source of the token, or immediately if already requested.
+// Not movable, as it's linked into the source.
+template<class F>
+class inplace_stop_callback : inplace_stop_callback_base
+{
+    DSK_NO_UNIQUE_ADDR F _f;
+
+    static void execute(inplace_stop_callback_base* cb) noexcept
+    {
+        static_cast<inplace_stop_callback*>(cb)->_f();
+    }
+
+public:
+    using callback_type = F;
+
+    template<class C>
+    explicit inplace_stop_callback(inplace_stop_token const& t, C&& f)
+        noexcept(std::is_nothrow_constructible_v<F, C>)
+        requires(std::is_constructible_v<F, C>)
+        : inplace_stop_callback_base(t._src, &execute), _f(DSK_FORWARD(f))
+    {
+        register_callback();
+    }
+
+    ~inplace_stop_callback()
+    {
+        deregister_callback();
+    }
+};
+
+template<class F>
+inplace_stop_callback(inplace_stop_token, F) -> inplace_stop_callback<F>;
+
+
+} // namespace dsk
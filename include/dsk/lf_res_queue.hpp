@@ -0,0 +1,496 @@
+#pragma once
+
+#include <dsk/async_op.hpp>
+#include <dsk/any_resumer.hpp>
+#include <dsk/res_queue.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/mutex.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/vector.hpp>
+#include <dsk/util/small_vector.hpp>
+#include <dsk/util/intrusive_list.hpp>
+#include <dsk/util/mpmc_queue.hpp>
+#include <dsk/util/spsc_queue.hpp>
+#include <optional>
+
+
+namespace dsk{
+
+
+// Bounded queue on a lock-free ring buffer, with the same async interface and end semantics as res_queue.
+// Enqueue/dequeue only touch the ring while no one is waiting,
+// the mutex is taken only when a side has to suspend or there are waiters to wake up.
+//
+// Ring should provide: capacity(), try_push(v), try_pop() -> optional<T>.
+// Waiting ops are served by the opposite side while they are suspended,
+// so bounded_spsc_queue still sees at most one producer and one consumer at a time.
+//
+// NOTE: capacity is rounded up to power of 2, and can't be increased.
+//       An enqueue racing with mark_end() may still succeed.
+template<class T, class Ring>
+class lf_res_queue
+{
+    template<bool IsEnqueue>
+    class async_queue_op : public intrusive_list_hook // linked in waiter list while waiting
+    {
+    public:
+        lf_res_queue*                     _q = nullptr;
+        DSK_DEF_MEMBER_IF(IsEnqueue, T)   _v;
+        std::optional<
+            expected<
+                std::conditional_t<
+                    IsEnqueue, void, T>,
+                errc>>                    _r;
+        any_resumer                       _resumer;
+        continuation                      _cont;
+        optional_stop_callback            _scb; // must be last one defined
+
+        explicit async_queue_op(lf_res_queue* q, auto&&... args)
+            : _q(q), _v(DSK_FORWARD(args)...)
+        {
+            static_assert(IsEnqueue || ! sizeof...(args));
+        }
+
+        using is_async_op = void;
+
+        bool initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
+        {
+            DSK_ASSERT(! _r);
+
+            if(stop_requested(ctx))
+            {
+                _r.emplace(unexpect, errc::canceled);
+                return false;
+            }
+
+            if constexpr(IsEnqueue)
+            {
+                if(errc e = _q->try_enqueue_impl(mut_move(_v)); e != errc::out_of_capacity)
+                {
+                    if(has_err(e)) _r.emplace(unexpect, e);
+                    else           _r.emplace(expect);
+
+                    return false;
+                }
+            }
+            else
+            {
+                if(auto r = _q->try_dequeue_impl(); r || get_err(r) != errc::resource_unavailable)
+                {
+                    _r.emplace(mut_move(r));
+                    return false;
+                }
+            }
+
+            {
+                unique_lock lk(_q->_mtx);
+
+                auto& waiters = _q->get_waiters<IsEnqueue>();
+
+                // Register before retrying, the opposite side checks waiters after each op,
+                // so either the retry sees its item/room or it sees this waiter.
+                waiters.push_back(this);
+                _q->update_waiting_no_lock<IsEnqueue>();
+                atomic_thread_fence(memory_order_seq_cst);
+
+                if constexpr(IsEnqueue)
+                {
+                    if(_q->_ring.try_push(mut_move(_v)))
+                    {
+                        waiters.erase(this);
+                        _q->update_waiting_no_lock<IsEnqueue>();
+                        lk.unlock();
+
+                        _q->_enqueueItems.fetch_add(1, memory_order_relaxed);
+                        _q->wake_waiters<false>();
+                        _r.emplace(expect);
+                        return false;
+                    }
+
+                    _q->_enqueueWait.fetch_add(1, memory_order_relaxed);
+                }
+                else
+                {
+                    if(auto v = _q->_ring.try_pop())
+                    {
+                        waiters.erase(this);
+                        _q->update_waiting_no_lock<IsEnqueue>();
+                        lk.unlock();
+
+                        _q->_dequeueItems.fetch_add(1, memory_order_relaxed);
+                        _q->wake_waiters<true>();
+                        _r.emplace(expect, mut_move(*v));
+                        return false;
+                    }
+
+                    if(_q->_endMarked.load(memory_order_seq_cst))
+                    {
+                        waiters.erase(this);
+                        _q->update_waiting_no_lock<IsEnqueue>();
+                        _r.emplace(unexpect, errc::end_reached);
+                        return false;
+                    }
+
+                    _q->_dequeueWait.fetch_add(1, memory_order_relaxed);
+                }
+
+                _resumer = get_resumer(ctx);
+                _cont = DSK_FORWARD(cont);
+
+                if(stop_possible(ctx))
+                {
+                    _scb.emplace(get_stop_token(ctx), [this]()
+                    {
+                        bool thisExists = [&]()
+                        {
+                            lock_guard lg(_q->_mtx);
+
+                            if(_q->get_waiters<IsEnqueue>().erase(this))
+                            {
+                                _q->update_waiting_no_lock<IsEnqueue>();
+                                return true;
+                            }
+
+                            return false;
+                        }();
+
+                        if(thisExists)
+                        {
+                            _r.emplace(unexpect, errc::canceled);
+                            complete();
+                        }
+                    });
+                }
+            }
+
+            return true;
+        }
+
+        bool is_failed() const noexcept
+        {
+            DSK_ASSERT(_r);
+            return has_err(*_r);
+        }
+
+        auto take_result() noexcept
+        {
+            DSK_ASSERT(_r);
+            return *mut_move(_r);
+        }
+
+        // result should have been set.
+        void complete()
+        {
+            DSK_ASSERT(_r);
+
+            //_scb.reset();
+            resume(mut_move(_cont), _resumer);
+        }
+    };
+
+    using async_enqueue_op = async_queue_op<true>;
+    using async_dequeue_op = async_queue_op<false>;
+
+    // waiters taken under lock, completed outside of lock.
+    template<bool IsEnqueue>
+    using taken_waiters = small_vector<async_queue_op<IsEnqueue>*, 4>;
+
+    Ring _ring;
+
+    alignas(cache_line_size) atomic<size_t> _enqueueTotal{0};
+                             atomic<size_t> _enqueueWait {0};
+                             atomic<size_t> _enqueueItems{0};
+                             atomic<size_t> _enqueueWaiting{0}; // size of _enqueueWaiters
+
+    alignas(cache_line_size) atomic<size_t> _dequeueTotal{0};
+                             atomic<size_t> _dequeueWait {0};
+                             atomic<size_t> _dequeueItems{0};
+                             atomic<size_t> _dequeueWaiting{0}; // size of _dequeueWaiters
+
+    alignas(cache_line_size) atomic<bool>   _endMarked{false};
+    mutex                                   _mtx;
+    intrusive_list<async_enqueue_op>        _enqueueWaiters;
+    intrusive_list<async_dequeue_op>        _dequeueWaiters;
+
+    template<bool IsEnqueue>
+    auto& get_waiters() noexcept
+    {
+        if constexpr(IsEnqueue) return _enqueueWaiters;
+        else                    return _dequeueWaiters;
+    }
+
+    template<bool IsEnqueue>
+    void update_waiting_no_lock() noexcept
+    {
+        if constexpr(IsEnqueue) _enqueueWaiting.store(_enqueueWaiters.size(), memory_order_relaxed);
+        else                    _dequeueWaiting.store(_dequeueWaiters.size(), memory_order_relaxed);
+    }
+
+    // Called after an item was pushed (IsEnqueue == false) or popped (IsEnqueue == true),
+    // serve waiters of the opposite side with the ring, while they are suspended.
+    template<bool IsEnqueue>
+    void wake_waiters()
+    {
+        atomic_thread_fence(memory_order_seq_cst);
+
+        auto& waiting = IsEnqueue ? _enqueueWaiting : _dequeueWaiting;
+
+        if(! waiting.load(memory_order_relaxed))
+        {
+            return;
+        }
+
+        taken_waiters<IsEnqueue> ws;
+
+        {
+            lock_guard lg(_mtx);
+
+            auto& waiters = get_waiters<IsEnqueue>();
+
+            while(auto* w = waiters.front())
+            {
+                if constexpr(IsEnqueue)
+                {
+                    if(! _ring.try_push(mut_move(w->_v)))
+                    {
+                        break;
+                    }
+
+                    w->_r.emplace(expect);
+                    _enqueueItems.fetch_add(1, memory_order_relaxed);
+                }
+                else
+                {
+                    auto v = _ring.try_pop();
+
+                    if(! v)
+                    {
+                        break;
+                    }
+
+                    w->_r.emplace(expect, mut_move(*v));
+                    _dequeueItems.fetch_add(1, memory_order_relaxed);
+                }
+
+                waiters.pop_front();
+                ws.emplace_back(w);
+            }
+
+            update_waiting_no_lock<IsEnqueue>();
+        }
+
+        for(auto* w : ws)
+        {
+            w->complete();
+        }
+    }
+
+    // v is moved only on success.
+    errc try_enqueue_impl(auto&& v)
+    {
+        if(_endMarked.load(memory_order_relaxed))
+        {
+            return errc::end_reached;
+        }
+
+        _enqueueTotal.fetch_add(1, memory_order_relaxed);
+
+        // Don't overtake waiters.
+        if(_enqueueWaiting.load(memory_order_relaxed) || ! _ring.try_push(DSK_FORWARD(v)))
+        {
+            return errc::out_of_capacity;
+        }
+
+        _enqueueItems.fetch_add(1, memory_order_relaxed);
+        wake_waiters<false>();
+        return {};
+    }
+
+    expected<T, errc> try_dequeue_impl()
+    {
+        _dequeueTotal.fetch_add(1, memory_order_relaxed);
+
+        auto v = _ring.try_pop();
+
+        // An item enqueued before mark_end() must be visible once _endMarked is seen.
+        if(! v && _endMarked.load(memory_order_seq_cst))
+        {
+            v = _ring.try_pop();
+
+            if(! v)
+            {
+                _dequeueWait.fetch_add(1, memory_order_relaxed);
+                return errc::end_reached;
+            }
+        }
+
+        if(! v)
+        {
+            return errc::resource_unavailable;
+        }
+
+        _dequeueItems.fetch_add(1, memory_order_relaxed);
+        wake_waiters<true>();
+        return mut_move(*v);
+    }
+
+public:
+    explicit lf_res_queue(size_t cap)
+        : _ring(cap)
+    {
+        DSK_ASSERT(cap > 0);
+    }
+
+    ~lf_res_queue()
+    {
+        DSK_ASSERT(_enqueueWaiters.empty());
+        DSK_ASSERT(_dequeueWaiters.empty());
+    }
+
+    // snapshot
+    res_queue_stats stats() const noexcept
+    {
+        res_queue_stats s;
+        s.enqueueTotal = _enqueueTotal.load(memory_order_relaxed);
+        s.enqueueWait  = _enqueueWait .load(memory_order_relaxed);
+        s.enqueueItems = _enqueueItems.load(memory_order_relaxed);
+        s.dequeueTotal = _dequeueTotal.load(memory_order_relaxed);
+        s.dequeueWait  = _dequeueWait .load(memory_order_relaxed);
+        s.dequeueItems = _dequeueItems.load(memory_order_relaxed);
+        return s;
+    }
+
+    size_t capacity() const noexcept
+    {
+        return _ring.capacity();
+    }
+
+    // Mark end of queue.
+    // Current dequeue waiters will be resumed with errc::end_reached.
+    // Dequeue ops will return errc::end_reached until all items have been retrived.
+    // Enqueue ops will fail with errc::end_reached.
+    bool mark_end()
+    {
+        if(_endMarked.exchange(true, memory_order_seq_cst))
+        {
+            return false;
+        }
+
+        taken_waiters<false> ws;
+
+        {
+            lock_guard lg(_mtx);
+
+            while(auto* w = _dequeueWaiters.pop_front())
+            {
+                // an item may have been pushed but not handed to w yet.
+                if(auto v = _ring.try_pop())
+                {
+                    w->_r.emplace(expect, mut_move(*v));
+                    _dequeueItems.fetch_add(1, memory_order_relaxed);
+                }
+                else
+                {
+                    w->_r.emplace(unexpect, errc::end_reached);
+                }
+
+                ws.emplace_back(w);
+            }
+
+            update_waiting_no_lock<false>();
+        }
+
+        for(auto* w : ws)
+        {
+            w->complete();
+        }
+
+        return true;
+    }
+
+    void clear_end_mark()
+    {
+        _endMarked.store(false, memory_order_seq_cst);
+    }
+
+    auto enqueue(auto&&... args)
+    {
+        return async_enqueue_op(this, DSK_FORWARD(args)...);
+    }
+
+    auto dequeue()
+    {
+        return async_dequeue_op(this);
+    }
+
+    errc try_enqueue(auto&&... args)
+    {
+        T v(DSK_FORWARD(args)...);
+
+        if(errc e = try_enqueue_impl(mut_move(v)); has_err(e))
+        {
+            if(e == errc::out_of_capacity)
+            {
+                _enqueueWait.fetch_add(1, memory_order_relaxed);
+            }
+
+            return e;
+        }
+
+        return {};
+    }
+
+    expected<T, errc> try_dequeue()
+    {
+        auto r = try_dequeue_impl();
+
+        if(is_err(r, errc::resource_unavailable))
+        {
+            _dequeueWait.fetch_add(1, memory_order_relaxed);
+        }
+
+        return r;
+    }
+
+    // One can use it after DSK_TRY dequeue() to make the whole awaitable.
+    errc force_dequeue_all(auto& cont)
+    {
+        size_t n = 0;
+
+        while(auto v = _ring.try_pop())
+        {
+            cont.emplace_back(mut_move(*v));
+            ++n;
+        }
+
+        if(! n)
+        {
+            if(_endMarked.load(memory_order_seq_cst)) return errc::end_reached;
+            else                                      return {};
+        }
+
+        _dequeueTotal.fetch_add(1, memory_order_relaxed);
+        _dequeueItems.fetch_add(n, memory_order_relaxed);
+        wake_waiters<true>();
+        return {};
+    }
+
+    template<class Cont = vector<T>>
+    expected<Cont, errc> force_dequeue_all()
+    {
+        Cont cont;
+        DSK_E_TRY_ONLY(force_dequeue_all(cont));
+        return cont;
+    }
+};
+
+
+// At most one enqueuer and one dequeuer at a time.
+template<class T>
+using res_queue_spsc = lf_res_queue<T, bounded_spsc_queue<T>>;
+
+template<class T>
+using res_queue_mpmc = lf_res_queue<T, bounded_mpmc_queue<T>>;
+
+
+} // namespace dsk
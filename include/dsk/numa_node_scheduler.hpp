@@ -0,0 +1,41 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/continuation.hpp>
+#include <dsk/util/debug.hpp>
+
+
+namespace dsk{
+
+
+// _scheduler_ of workers on a NUMA node of Pool, which should provide post_to_node(node, cont).
+// Used to tie ops to a node, e.g. the creator of a res_pool or a connection's handlers:
+//      DSK_TRY run_on(pool.node_scheduler(n), op);
+// Pool keeps one per node, so its address is stable and can be used as _resumer_ id.
+template<class Pool>
+class numa_node_scheduler
+{
+    Pool*  _pool = nullptr;
+    size_t _node = 0;
+
+public:
+    using is_scheduler = void;
+
+    numa_node_scheduler() = default;
+
+    numa_node_scheduler(Pool& pool, size_t node) noexcept
+        : _pool(std::addressof(pool)), _node(node)
+    {}
+
+    auto&   pool() const noexcept { return *_pool; }
+    size_t  node() const noexcept { return _node; }
+
+    void post(_continuation_ auto&& cont)
+    {
+        DSK_ASSERT(_pool);
+        _pool->post_to_node(_node, DSK_FORWARD(cont));
+    }
+};
+
+
+} // namespace dsk
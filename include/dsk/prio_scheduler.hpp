@@ -0,0 +1,247 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/resumer.hpp>
+#include <dsk/continuation.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/deque.hpp>
+#include <dsk/util/mutex.hpp>
+#include <array>
+
+
+namespace dsk{
+
+
+enum prio_lane_e : size_t
+{
+    prio_high,
+    prio_normal,
+    prio_low
+};
+
+
+enum prio_policy_e
+{
+    // always run from the highest non-empty lane,
+    // but a lane skipped maxSkips times in a row is run next, so it can't be locked out.
+    prio_strict,
+
+    // weighted round robin, in each round, lane l runs up to weights[l] jobs,
+    // higher lanes first.
+    prio_weighted
+};
+
+
+// _scheduler_ of a single lane of PrioSch.
+template<class PrioSch>
+class prio_lane_scheduler
+{
+    PrioSch* _ps   = nullptr;
+    size_t   _lane = 0;
+
+public:
+    using is_scheduler = void;
+
+    prio_lane_scheduler() = default;
+
+    prio_lane_scheduler(PrioSch& ps, size_t lane) noexcept
+        : _ps(std::addressof(ps)), _lane(lane)
+    {}
+
+    auto&  owner() const noexcept { return *_ps; }
+    size_t  lane() const noexcept { return _lane; }
+
+    void post(_continuation_ auto&& cont)
+    {
+        _ps->post(_lane, DSK_FORWARD(cont));
+    }
+};
+
+
+// _scheduler_ adaptor with Lanes priority lanes over Sch, e.g. simple_thread_pool or asio_io_thread_pool.
+//
+// Each post() puts the job in its lane and posts a token to Sch,
+// the token runs whichever job is picked by the policy at that time, not the one posted with it.
+// So a job posted to a higher lane overtakes the lower ones already queued,
+// though it still waits for the jobs Sch is already running.
+//
+// Job is the type lanes hold, Sch::post() is called with a lambda of pointer size.
+// Should outlive all jobs posted to it.
+template<_scheduler_ Sch, size_t Lanes = 3, class Job = continuation>
+class prio_scheduler
+{
+    static_assert(Lanes > 1);
+
+public:
+    static constexpr size_t   lane_count        = Lanes;
+    static constexpr uint32_t default_max_skips = 64;
+
+private:
+    Sch&                          _sch;
+    prio_policy_e                 _policy;
+    uint32_t                      _maxSkips = default_max_skips;
+    std::array<uint32_t, Lanes>   _weights{};
+    mutable mutex                 _mtx;
+    std::array<deque<Job>, Lanes> _lanes;
+    std::array<uint32_t, Lanes>   _counters{}; // prio_strict: consecutive skips; prio_weighted: credits left in this round.
+
+    std::array<prio_lane_scheduler<prio_scheduler>, Lanes> _laneSchs;
+
+    void init_lanes() noexcept
+    {
+        for(size_t l = 0; l < Lanes; ++l)
+        {
+            _laneSchs[l] = prio_lane_scheduler(*this, l);
+        }
+    }
+
+    size_t pick_strict_no_lock() noexcept
+    {
+        size_t p = Lanes;
+
+        for(size_t l = 0; l < Lanes; ++l)
+        {
+            if(_lanes[l].empty())
+            {
+                continue;
+            }
+
+            if(p == Lanes)
+            {
+                p = l;
+            }
+            else if(_counters[l] >= _maxSkips) // starving
+            {
+                p = l;
+                break;
+            }
+        }
+
+        DSK_ASSERT(p < Lanes);
+
+        for(size_t l = 0; l < Lanes; ++l)
+        {
+            if(l == p)           _counters[l] = 0;
+            else if(_lanes[l].size()) ++_counters[l];
+        }
+
+        return p;
+    }
+
+    size_t pick_weighted_no_lock() noexcept
+    {
+        for(;;)
+        {
+            for(size_t l = 0; l < Lanes; ++l)
+            {
+                if(_counters[l] && _lanes[l].size())
+                {
+                    --_counters[l];
+                    return l;
+                }
+            }
+
+            _counters = _weights; // new round
+        }
+    }
+
+    // Each token runs exactly one job, as tokens and jobs are 1:1, there is always one.
+    void run_one()
+    {
+        Job job = [&]()
+        {
+            lock_guard lg(_mtx);
+
+            size_t l = (_policy == prio_strict) ? pick_strict_no_lock() : pick_weighted_no_lock();
+            Job    j = mut_move(_lanes[l].front());
+
+            _lanes[l].pop_front();
+            return j;
+        }();
+
+        job();
+    }
+
+public:
+    using is_scheduler = void;
+
+    // prio_strict
+    explicit prio_scheduler(Sch& sch, uint32_t maxSkips = default_max_skips)
+        : _sch(sch), _policy(prio_strict), _maxSkips(maxSkips)
+    {
+        DSK_ASSERT(maxSkips > 0);
+        init_lanes();
+    }
+
+    // prio_weighted, each weight should be > 0.
+    prio_scheduler(Sch& sch, std::array<uint32_t, Lanes> const& weights)
+        : _sch(sch), _policy(prio_weighted), _weights(weights), _counters(weights)
+    {
+        for(uint32_t w : weights)
+        {
+            DSK_ASSERT(w > 0);
+        }
+
+        init_lanes();
+    }
+
+    prio_scheduler(prio_scheduler const&) = delete;
+    prio_scheduler& operator=(prio_scheduler const&) = delete;
+
+    ~prio_scheduler()
+    {
+        for(auto& q : _lanes)
+        {
+            DSK_ASSERT(q.empty());
+        }
+    }
+
+    auto& underlying_scheduler() noexcept { return _sch; }
+    prio_policy_e policy() const noexcept { return _policy; }
+
+    // jobs queued in lane l, not started yet.
+    size_t size(size_t l) const
+    {
+        DSK_ASSERT(l < Lanes);
+        lock_guard lg(_mtx);
+        return _lanes[l].size();
+    }
+
+    // _scheduler_ posting to lane l.
+    auto& lane(size_t l) noexcept
+    {
+        DSK_ASSERT(l < Lanes);
+        return _laneSchs[l];
+    }
+
+    void post(size_t l, _continuation_ auto&& job)
+    {
+        DSK_ASSERT(l < Lanes);
+
+        {
+            lock_guard lg(_mtx);
+            _lanes[l].emplace_back(DSK_FORWARD(job));
+        }
+
+        _sch.post([this](){ run_one(); });
+    }
+
+    void post(_continuation_ auto&& job)
+    {
+        post(prio_normal, DSK_FORWARD(job));
+    }
+
+};
+
+
+// _resumer_ that posts to lane l of a prio_scheduler:
+//      DSK_TRY resume_on(prio_resumer(ps, prio_high), op);
+// Each lane is a distinct _scheduler_, so it's kept when converted to any_resumer,
+// e.g. by run_on(), and continuation is posted when switching lanes.
+auto prio_resumer(auto& prioSch, size_t l) noexcept
+{
+    return scheudler_resumer(prioSch.lane(l));
+}
+
+
+} // namespace dsk
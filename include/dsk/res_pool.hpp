@@ -6,6 +6,7 @@
 #include <dsk/util/list.hpp>
 #include <dsk/util/deque.hpp>
 #include <dsk/util/mutex.hpp>
+#include <dsk/util/intrusive_list.hpp>
 #include <dsk/util/conditional_lock.hpp>
 #include <dsk/util/concepts.hpp>
 #include <dsk/util/unordered.hpp>
@@ -150,7 +151,7 @@ class res_pool
         }
     };
 
-    class async_acquire_op
+    class async_acquire_op : public intrusive_list_hook // linked in _waiters while waiting
     {
     public:
         res_pool*                              _pool = nullptr;
@@ -243,12 +244,7 @@ class res_pool
     DSK_DEF_MEMBER_IF(has_res,  Creator) _creator;
     DSK_DEF_MEMBER_IF(has_res, Recycler) _recycler;
 
-    deque<async_acquire_op*> _waiterQueue; // ops waiting for res
-
-    // unstable_unordered_map<
-    //     async_acquire_op*,
-    //     async_acquire_op**
-    // > _waiters; // map to _waiterQueue item.
+    intrusive_list<async_acquire_op> _waiters; // ops waiting for res
 
     res_iter invalid_iter() noexcept
     {
@@ -259,25 +255,16 @@ class res_pool
     void add_waiter_no_lock(async_acquire_op* w)
     {
         DSK_ASSERT(w);
-        /*auto& b =*/ _waiterQueue.emplace_back(w);
-        //DSK_VERIFY(_waiters.emplace(w, &b).second);
+        _waiters.push_back(w);
     }
 
     void cancel(async_acquire_op* w)
     {
         lock_guard lg(_mtx);
 
-        //if(auto it = _waiters.find(w); it != _waiters.end())
-        //{
-        //    *(it->second) = nullptr; // mark _waiterQueue item as deleted
-        //    _waiters.erase(it);
-        //    w->complete_on_cancellation();
-        //}
-
-        // linear search. _waiterQueue should be relatively small
-        if(auto it = std::ranges::find(_waiterQueue, w); it != _waiterQueue.end())
+        // O(1), w is unlinked when it's taken by recycle().
+        if(_waiters.erase(w))
         {
-            *it = nullptr; // mark as deleted
             w->complete_on_cancellation();
         }
     }
@@ -296,12 +283,9 @@ class res_pool
         {
             lock_guard lg(_mtx);
 
-            while(_waiterQueue.size() && ! _waiterQueue.front())
-            {
-                _waiterQueue.pop_front(); // pop item marked as deleted
-            }
+            w = _waiters.pop_front();
 
-            if(_waiterQueue.empty()) // no waiter, put back resource.
+            if(! w) // no waiter, put back resource.
             {
                 auto it = rr.release();
 
@@ -317,10 +301,6 @@ class res_pool
 
                 return;
             }
-
-            w = _waiterQueue.front();
-            //DSK_VERIFY(_waiters.erase(w));
-            _waiterQueue.pop_front();
         }
 
         //if constexpr(has_res)
@@ -351,8 +331,8 @@ public:
 
     ~res_pool()
     {
-        if constexpr(has_res) DSK_ASSERT(_inuse.empty() && _waiterQueue.empty() /*&& _waiters.empty()*/);
-        else                  DSK_ASSERT(_size == 0 && _waiterQueue.empty() /*&& _waiters.empty()*/);
+        if constexpr(has_res) DSK_ASSERT(_inuse.empty() && _waiters.empty());
+        else                  DSK_ASSERT(_size == 0 && _waiters.empty());
     }
 
     void set_creator(auto&& f) requires(has_res)
@@ -5,6 +5,9 @@
 #include <dsk/util/debug.hpp>
 #include <dsk/util/range.hpp>
 #include <dsk/util/mutex.hpp>
+#include <dsk/util/deque.hpp>
+#include <dsk/util/vector.hpp>
+#include <dsk/util/intrusive_list.hpp>
 #include <dsk/util/concepts.hpp>
 #include <dsk/util/unordered.hpp>
 #include <deque>
@@ -22,6 +25,8 @@ struct res_queue_stats
     size_t enqueueWait  = 0; // failed enqueue requests
     size_t dequeueTotal = 0; //  total dequeue requests
     size_t dequeueWait  = 0; // failed dequeue requests
+    size_t enqueueItems = 0; //  total items enqueued, including ones handed to dequeue waiters directly
+    size_t dequeueItems = 0; //  total items dequeued, including ones handed to dequeue waiters directly
 
     constexpr void reset() noexcept { *this = {}; }
 
@@ -33,118 +38,80 @@ struct res_queue_stats
 
     constexpr double enqueue_no_wait_rate() const noexcept { return static_cast<double>(enqueue_no_wait()) / enqueueTotal; }
     constexpr double dequeue_no_wait_rate() const noexcept { return static_cast<double>(dequeue_no_wait()) / dequeueTotal; }
+
+    // average items per request
+    constexpr double avg_enqueue_batch() const noexcept { return static_cast<double>(enqueueItems) / enqueueTotal; }
+    constexpr double avg_dequeue_batch() const noexcept { return static_cast<double>(dequeueItems) / dequeueTotal; }
 };
 
 
 template<class T>
 class res_queue
 {
-    template<bool IsEnqueue>
-    class async_queue_op
+    // Waiting ops are linked in waiter queues.
+    // Once taken out of a waiter queue under lock, no one else refers to it,
+    // so items can be transferred and it can be completed outside of lock.
+
+    struct enqueue_waiter : intrusive_list_hook
     {
-    public:
-        res_queue*                        _rq = nullptr;
-        DSK_DEF_MEMBER_IF(IsEnqueue, T)   _v;
-        std::optional<
-            expected<
-                std::conditional_t<
-                    IsEnqueue, void, T>,
-                errc>>                    _r;
-        any_resumer                       _resumer;
-        continuation                      _cont;
-        optional_stop_callback            _scb; // must be last one defined
-
-        explicit async_queue_op(res_queue* p, auto&&... args)
-            : _rq(p), _v(DSK_FORWARD(args)...)
-        {
-            static_assert(IsEnqueue || ! sizeof...(args));
-        }
+        size_t remaining = 0; // items not enqueued yet
 
-        using is_async_op = void;
+        // move up to n (> 0) of remaining items to q, return number of moved ones.
+        size_t (*give)(enqueue_waiter&, deque<T>& q, size_t n) = nullptr;
+        void   (*complete)(enqueue_waiter&, errc) = nullptr;
+    };
 
-        bool initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
-        {
-            DSK_ASSERT(! _r);
+    struct dequeue_waiter : intrusive_list_hook
+    {
+        size_t want = 0; // max number of items can still be taken
 
-            if(stop_requested(ctx))
-            {
-                _r.emplace(unexpect, errc::canceled);
-                return false;
-            }
+        void (*put)(dequeue_waiter&, T&&) = nullptr;
+        void (*complete)(dequeue_waiter&, errc) = nullptr; // errc::end_reached if no item is taken
+    };
 
-            {
-                unique_lock lk(_rq->_mtx);
+    // Waiters taken out of waiter queue under lock, to be completed outside of lock.
+    // Mostly there is only one, so no allocation for it.
+    template<class W>
+    struct taken_waiters
+    {
+        W*         first = nullptr;
+        vector<W*> rest;
 
-                if constexpr(IsEnqueue)
-                {
-                    if(auto r = _rq->try_enqueue_no_lock(mut_move(_v)))
-                    {
-                        lk.unlock();
+        void add(W* w)
+        {
+            if(! first) first = w;
+            else        rest.emplace_back(w);
+        }
 
-                        if(*r)
-                        {
-                            (*r)->complete(mut_move(_v));
-                        }
+        void complete_all(errc e = {})
+        {
+            if(first)
+            {
+                first->complete(*first, e);
 
-                        _r.emplace(expect);
-                        return false;
-                    }
-                    else if(r.error() != errc::out_of_capacity)
-                    {
-                        _r.emplace(unexpect, r.error());
-                        return false;
-                    }
-                }
-                else // dequeue
+                for(auto* w : rest)
                 {
-                    if(auto r = _rq->try_dequeue_no_lock())
-                    {
-                        lk.unlock();
-
-                        if(r->first)
-                        {
-                            r->first->complete();
-                        }
-
-                        _r.emplace(expect, mut_move(r->second));
-                        return false;
-                    }
-                    else if(r.error() != errc::resource_unavailable)
-                    {
-                        _r.emplace(unexpect, r.error());
-                        return false;
-                    }
+                    w->complete(*w, e);
                 }
+            }
+        }
+    };
 
-                _resumer = get_resumer(ctx);
-                _cont = DSK_FORWARD(cont);
-
-                if(stop_possible(ctx))
-                {
-                    _scb.emplace(get_stop_token(ctx), [this]()
-                    {
-                        bool thisExists = [&]()
-                        {
-                            lock_guard lg(_rq->_mtx);
-                            return _rq->get_waiters<IsEnqueue>().erase(this);
-                        }();
-
-                        if(thisExists)
-                        {
-                            DSK_ASSERT(! _r);
-
-                            //_scb.reset();
-                            _r.emplace(unexpect, errc::canceled);
-                            resume(mut_move(_cont), _resumer);
-                        }
-                    });
-                }
+    template<class Waiter, class R>
+    class async_queue_op_base : public Waiter
+    {
+    public:
+        res_queue*                       _rq = nullptr;
+        std::optional<expected<R, errc>> _r;
+        any_resumer                      _resumer;
+        continuation                     _cont;
+        optional_stop_callback           _scb; // must be last one defined
 
-                _rq->get_waiters<IsEnqueue>().add(this); // when initiate() gets called, this op should be
-            }                                            // in its final place, so its address shouldn't change.
+        explicit async_queue_op_base(res_queue* p)
+            : _rq(p)
+        {}
 
-            return true;
-        }
+        using is_async_op = void;
 
         bool is_failed() const noexcept
         {
@@ -158,91 +125,314 @@ class res_queue
             return *mut_move(_r);
         }
 
+        // should be called with _rq->_mtx locked.
+        // when initiate() gets called, this op should be in its final place, so its address shouldn't change.
+        void wait_no_lock(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
+        {
+            _resumer = get_resumer(ctx);
+            _cont = DSK_FORWARD(cont);
+
+            if(stop_possible(ctx))
+            {
+                _scb.emplace(get_stop_token(ctx), [this]()
+                {
+                    bool thisExists = [&]()
+                    {
+                        lock_guard lg(_rq->_mtx);
+                        return _rq->waiters_of(this).erase(this);
+                    }();
+
+                    if(thisExists)
+                    {
+                        complete_with(unexpect, errc::canceled);
+                    }
+                });
+            }
+
+            _rq->waiters_of(this).push_back(this);
+        }
+
         // when invoked, this op should have been removed from queue, but still on same address,
         // so request_stop() won't affect result at this point.
-        void complete(auto&&... args)
+        void complete_with(auto&&... args)
         {
-            static_assert(! IsEnqueue || ! sizeof...(args));
             DSK_ASSERT(! _r);
 
             //_scb.reset();
-            _r.emplace(expect, DSK_FORWARD(args)...);
+            _r.emplace(DSK_FORWARD(args)...);
             resume(mut_move(_cont), _resumer);
         }
+    };
+
+    class async_enqueue_op : public async_queue_op_base<enqueue_waiter, void>
+    {
+        using base = async_queue_op_base<enqueue_waiter, void>;
 
-        void complete_with_err(errc e)
+        T _v;
+
+    public:
+        explicit async_enqueue_op(res_queue* p, auto&&... args)
+            : base(p), _v(DSK_FORWARD(args)...)
         {
-            DSK_ASSERT(! _r);
+            this->remaining = 1;
 
-            //_scb.reset();
-            _r.emplace(unexpect, e);
-            resume(mut_move(_cont), _resumer);
+            this->give = [](enqueue_waiter& w, deque<T>& q, size_t)
+            {
+                auto& op = static_cast<async_enqueue_op&>(w);
+                q.emplace_back(mut_move(op._v));
+                op.remaining = 0;
+                return size_t(1);
+            };
+
+            this->complete = [](enqueue_waiter& w, errc e)
+            {
+                auto& op = static_cast<async_enqueue_op&>(w);
+                if(has_err(e)) op.complete_with(unexpect, e);
+                else           op.complete_with(expect);
+            };
         }
-    };
 
-    using async_enqueue_op = async_queue_op<true>;
-    using async_dequeue_op = async_queue_op<false>;
+        bool initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
+        {
+            DSK_ASSERT(! this->_r);
 
-    template<bool IsEnqueue>
-    struct waiter_queue
-    {
-        using op_type = async_queue_op<IsEnqueue>;
+            if(stop_requested(ctx))
+            {
+                this->_r.emplace(unexpect, errc::canceled);
+                return false;
+            }
+
+            {
+                unique_lock lk(this->_rq->_mtx);
 
-        deque<op_type*> waiterQueue;
-        //unstable_unordered_map<op_type*, op_type**> waiters; // map to waiterQueue item.
+                if(auto r = this->_rq->try_enqueue_no_lock(mut_move(_v)))
+                {
+                    lk.unlock();
 
-        size_t size() const noexcept { return waiterQueue.size(); }
-        bool  empty() const noexcept { return waiterQueue.empty(); }
+                    if(dequeue_waiter* w = *r)
+                    {
+                        w->put(*w, mut_move(_v));
+                        w->complete(*w, {});
+                    }
 
-        void add(op_type* w)
+                    this->_r.emplace(expect);
+                    return false;
+                }
+                else if(r.error() != errc::out_of_capacity)
+                {
+                    this->_r.emplace(unexpect, r.error());
+                    return false;
+                }
+
+                this->wait_no_lock(DSK_FORWARD(ctx), DSK_FORWARD(cont));
+            }
+
+            return true;
+        }
+    };
+
+    class async_dequeue_op : public async_queue_op_base<dequeue_waiter, T>
+    {
+        using base = async_queue_op_base<dequeue_waiter, T>;
+
+    public:
+        explicit async_dequeue_op(res_queue* p)
+            : base(p)
         {
-            DSK_ASSERT(w);
-            /*auto& b =*/ waiterQueue.emplace_back(w);
-            //DSK_VERIFY(waiters.emplace(w, &b).second);
+            this->want = 1;
+
+            this->put = [](dequeue_waiter& w, T&& v)
+            {
+                auto& op = static_cast<async_dequeue_op&>(w);
+                DSK_ASSERT(! op._r);
+                op._r.emplace(expect, mut_move(v));
+                op.want = 0;
+            };
+
+            this->complete = [](dequeue_waiter& w, errc e)
+            {
+                auto& op = static_cast<async_dequeue_op&>(w);
+
+                if(has_err(e))
+                {
+                    op.complete_with(unexpect, e);
+                }
+                else
+                {
+                    DSK_ASSERT(op._r);
+                    resume(mut_move(op._cont), op._resumer);
+                }
+            };
         }
 
-        op_type* take_oldest()
+        bool initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
         {
-            while(waiterQueue.size() && ! waiterQueue.front())
+            DSK_ASSERT(! this->_r);
+
+            if(stop_requested(ctx))
             {
-                waiterQueue.pop_front(); // pop item marked as deleted
+                this->_r.emplace(unexpect, errc::canceled);
+                return false;
             }
 
-            if(waiterQueue.empty())
+            taken_waiters<enqueue_waiter> ws;
+
             {
-                return nullptr;
+                unique_lock lk(this->_rq->_mtx);
+
+                auto r = this->_rq->try_dequeue_no_lock(ws);
+
+                if(! r && r.error() == errc::resource_unavailable)
+                {
+                    this->wait_no_lock(DSK_FORWARD(ctx), DSK_FORWARD(cont));
+                    return true;
+                }
+
+                this->_r.emplace(mut_move(r));
             }
 
-            auto* w = waiterQueue.front();
-            //DSK_VERIFY(waiters.erase(w));
-            waiterQueue.pop_front();
+            ws.complete_all();
+            return false;
+        }
+    };
+
+    // Moves all items of Range, as many as capacity allows under each lock acquisition.
+    // If it's canceled while waiting, some items may have been enqueued.
+    template<class Range>
+    class async_enqueue_bulk_op : public async_queue_op_base<enqueue_waiter, void>
+    {
+        using base = async_queue_op_base<enqueue_waiter, void>;
+        using iter = std::ranges::iterator_t<Range>;
+
+        Range _items;
+        iter  _it{};
 
-            return w;
+    public:
+        explicit async_enqueue_bulk_op(res_queue* p, auto&& items)
+            : base(p), _items(DSK_FORWARD(items))
+        {
+            this->give = [](enqueue_waiter& w, deque<T>& q, size_t n)
+            {
+                auto& op = static_cast<async_enqueue_bulk_op&>(w);
+                size_t m = std::min(n, op.remaining);
+
+                for(size_t i = 0; i < m; ++i, ++op._it)
+                {
+                    q.emplace_back(mut_move(*op._it));
+                }
+
+                op.remaining -= m;
+                return m;
+            };
+
+            this->complete = [](enqueue_waiter& w, errc e)
+            {
+                auto& op = static_cast<async_enqueue_bulk_op&>(w);
+                if(has_err(e)) op.complete_with(unexpect, e);
+                else           op.complete_with(expect);
+            };
+        }
+
+        bool initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
+        {
+            DSK_ASSERT(! this->_r);
+
+            if(stop_requested(ctx))
+            {
+                this->_r.emplace(unexpect, errc::canceled);
+                return false;
+            }
+
+            _it = std::ranges::begin(_items);
+            this->remaining = std::ranges::size(_items);
+
+            taken_waiters<dequeue_waiter> ws;
+
+            {
+                unique_lock lk(this->_rq->_mtx);
+
+                if(errc e = this->_rq->template enqueue_items_no_lock<false>(_it, this->remaining, ws); has_err(e))
+                {
+                    this->_r.emplace(unexpect, e);
+                    return false;
+                }
+
+                if(this->remaining)
+                {
+                    ++this->_rq->_stats.enqueueWait;
+                    this->wait_no_lock(DSK_FORWARD(ctx), DSK_FORWARD(cont));
+                    lk.unlock();
+                    ws.complete_all();
+                    return true;
+                }
+            }
+
+            ws.complete_all();
+            this->_r.emplace(expect);
+            return false;
         }
+    };
+
+    // Result type: expected<size_t, errc>, number of items appended to Out.
+    template<class Out>
+    class async_dequeue_up_to_op : public async_queue_op_base<dequeue_waiter, size_t>
+    {
+        using base = async_queue_op_base<dequeue_waiter, size_t>;
+
+        Out&   _out;
+        size_t _n   = 0;
+        size_t _got = 0;
 
-        // NOTE: may contain null ops.
-        deque<op_type*> take_all()
+    public:
+        async_dequeue_up_to_op(res_queue* p, size_t n, Out& out)
+            : base(p), _out(out), _n(n)
         {
-            //waiters.clear();
-            return mut_move(waiterQueue);
+            DSK_ASSERT(_n > 0);
+
+            this->put = [](dequeue_waiter& w, T&& v)
+            {
+                auto& op = static_cast<async_dequeue_up_to_op&>(w);
+                op._out.emplace_back(mut_move(v));
+                ++op._got;
+                --op.want;
+            };
+
+            this->complete = [](dequeue_waiter& w, errc e)
+            {
+                auto& op = static_cast<async_dequeue_up_to_op&>(w);
+                if(has_err(e)) op.complete_with(unexpect, e);
+                else           op.complete_with(expect, op._got);
+            };
         }
 
-        bool erase(op_type* w)
+        bool initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
         {
-            //if(auto it = waiters.find(w); it != waiters.end())
-            //{
-            //    *(it->second) = nullptr; // mark waiterQueue item as deleted
-            //    waiters.erase(it);
-            //    return true;
-            //}
-
-            // linear search. waiterQueue should be relatively small
-            if(auto it = std::ranges::find(waiterQueue, w); it != waiterQueue.end())
+            DSK_ASSERT(! this->_r);
+
+            if(stop_requested(ctx))
             {
-                *it = nullptr; // mark as deleted
-                return true;
+                this->_r.emplace(unexpect, errc::canceled);
+                return false;
             }
 
+            taken_waiters<enqueue_waiter> ws;
+
+            {
+                unique_lock lk(this->_rq->_mtx);
+
+                auto r = this->_rq->try_dequeue_up_to_no_lock(_n, _out, ws);
+
+                if(! r && r.error() == errc::resource_unavailable)
+                {
+                    this->want = _n;
+                    this->wait_no_lock(DSK_FORWARD(ctx), DSK_FORWARD(cont));
+                    return true;
+                }
+
+                this->_r.emplace(mut_move(r));
+            }
+
+            ws.complete_all();
             return false;
         }
     };
@@ -251,16 +441,12 @@ class res_queue
     size_t   _cap = 1;
     bool     _endMarked = false;
     deque<T> _resQueue;
-    waiter_queue<true > _enqueueWaiters;
-    waiter_queue<false> _dequeueWaiters;
-    res_queue_stats     _stats;
+    intrusive_list<enqueue_waiter> _enqueueWaiters;
+    intrusive_list<dequeue_waiter> _dequeueWaiters;
+    res_queue_stats _stats;
 
-    template<bool IsEnqueue>
-    auto& get_waiters() noexcept
-    {
-        if constexpr(IsEnqueue) return _enqueueWaiters;
-        else                    return _dequeueWaiters;
-    }
+    auto& waiters_of(enqueue_waiter*) noexcept { return _enqueueWaiters; }
+    auto& waiters_of(dequeue_waiter*) noexcept { return _dequeueWaiters; }
 
     void integrity_assert_no_lock() const
     {
@@ -270,7 +456,8 @@ class res_queue
     #endif
     }
 
-    expected<async_dequeue_op*, errc> try_enqueue_no_lock(auto&&... args)
+    // returned dequeue waiter should be given the item and completed outside of lock.
+    expected<dequeue_waiter*, errc> try_enqueue_no_lock(auto&&... args)
     {
         integrity_assert_no_lock();
 
@@ -287,8 +474,11 @@ class res_queue
             return errc::out_of_capacity;
         }
 
-        if(auto* w = _dequeueWaiters.take_oldest())
+        ++_stats.enqueueItems;
+
+        if(auto* w = _dequeueWaiters.pop_front())
         {
+            ++_stats.dequeueItems;
             return w;
         }
 
@@ -296,7 +486,72 @@ class res_queue
         return nullptr;
     }
 
-    expected<std::pair<async_enqueue_op*, T>, errc> try_dequeue_no_lock()
+    // Move n items from it, first to dequeue waiters, then to queue as capacity allows(or ignore it).
+    // it and n are updated to the remaining.
+    template<bool IgnoreCap>
+    errc enqueue_items_no_lock(auto& it, size_t& n, taken_waiters<dequeue_waiter>& ws)
+    {
+        integrity_assert_no_lock();
+
+        if(_endMarked)
+        {
+            return errc::end_reached;
+        }
+
+        ++_stats.enqueueTotal;
+
+        while(n && _dequeueWaiters.size()) // only if queue is empty
+        {
+            dequeue_waiter* w = _dequeueWaiters.pop_front();
+            size_t          m = std::min(n, w->want);
+
+            for(size_t i = 0; i < m; ++i, ++it)
+            {
+                w->put(*w, mut_move(*it));
+            }
+
+            n -= m;
+            _stats.enqueueItems += m;
+            _stats.dequeueItems += m;
+            ws.add(w);
+        }
+
+        while(n && (IgnoreCap || _resQueue.size() < _cap))
+        {
+            _resQueue.emplace_back(mut_move(*it));
+            ++it;
+            --n;
+            ++_stats.enqueueItems;
+        }
+
+        return {};
+    }
+
+    // Move items of enqueue waiters into freed capacity, drained ones are taken to ws.
+    void refill_no_lock(taken_waiters<enqueue_waiter>& ws)
+    {
+        while(_resQueue.size() < _cap)
+        {
+            enqueue_waiter* w = _enqueueWaiters.front();
+
+            if(! w)
+            {
+                break;
+            }
+
+            _stats.enqueueItems += w->give(*w, _resQueue, _cap - _resQueue.size());
+
+            if(w->remaining) // no more room
+            {
+                break;
+            }
+
+            _enqueueWaiters.pop_front();
+            ws.add(w);
+        }
+    }
+
+    expected<T, errc> try_dequeue_no_lock(taken_waiters<enqueue_waiter>& ws)
     {
         integrity_assert_no_lock();
 
@@ -312,15 +567,40 @@ class res_queue
 
         T v = mut_move(_resQueue.front());
         _resQueue.pop_front();
+        ++_stats.dequeueItems;
 
-        auto* w = _enqueueWaiters.take_oldest();
+        refill_no_lock(ws);
 
-        if(w)
+        return v;
+    }
+
+    expected<size_t, errc> try_dequeue_up_to_no_lock(size_t n, auto& out, taken_waiters<enqueue_waiter>& ws)
+    {
+        integrity_assert_no_lock();
+
+        ++_stats.dequeueTotal;
+
+        if(_resQueue.empty())
         {
-            _resQueue.emplace_back(mut_move(w->_v));
+            ++_stats.dequeueWait;
+
+            if(_endMarked) return errc::end_reached;
+            else           return errc::resource_unavailable;
+        }
+
+        size_t m = std::min(n, _resQueue.size());
+
+        for(size_t i = 0; i < m; ++i)
+        {
+            out.emplace_back(mut_move(_resQueue.front()));
+            _resQueue.pop_front();
         }
 
-        return {expect, w, mut_move(v)};
+        _stats.dequeueItems += m;
+
+        refill_no_lock(ws);
+
+        return m;
     }
 
 public:
@@ -345,7 +625,7 @@ public:
     {
         lock_guard lg(_mtx);
         DSK_ASSERT(SIZE_MAX - _cap >= n);
-        _cap += n;            
+        _cap += n;
     }
 
     void clear()
@@ -362,7 +642,8 @@ public:
     {
         bool isFirst = false;
 
-        auto waiters = [&]()
+        taken_waiters<dequeue_waiter> ws;
+
         {
             lock_guard lg(_mtx);
             integrity_assert_no_lock();
@@ -372,20 +653,15 @@ public:
                 _endMarked = true;
                 isFirst = true;
 
-                return _dequeueWaiters.take_all();
-            }
-
-            return decltype(_dequeueWaiters.take_all())();
-        }();
-
-        for(auto* w : waiters)
-        {
-            if(w)
-            {
-                w->complete_with_err(errc::end_reached);
+                while(auto* w = _dequeueWaiters.pop_front())
+                {
+                    ws.add(w);
+                }
             }
         }
 
+        ws.complete_all(errc::end_reached);
+
         return isFirst;
     }
 
@@ -405,17 +681,37 @@ public:
         return async_dequeue_op(this);
     }
 
+    // Enqueue all items of 'items', which are std::moved into the queue.
+    // Under each lock acquisition, as many items as capacity allows are moved,
+    // and dequeue waiters are woken up once per batch.
+    // If 'items' is an lvalue, it's referenced, so it must outlive the op.
+    auto enqueue_bulk(std::ranges::sized_range auto&& items)
+    {
+        using range_t = DSK_CONDITIONAL_T(std::is_lvalue_reference_v<decltype(items)>,
+                                          decltype(items), DSK_DECAY_T(items));
+
+        return async_enqueue_bulk_op<range_t>(this, DSK_FORWARD(items));
+    }
+
+    // Dequeue at least 1 and at most n items under a single lock acquisition, which are appended to 'out'.
+    // Result type: expected<size_t, errc>, the number of dequeued items.
+    auto dequeue_up_to(size_t n, auto& out)
+    {
+        return async_dequeue_up_to_op<DSK_NO_REF_T(out)>(this, n, out);
+    }
+
     errc try_enqueue(auto&&... args)
     {
         unique_lock lk(_mtx);
 
-        DSK_E_TRY(async_dequeue_op* dequeueOp, try_enqueue_no_lock(DSK_FORWARD(args)...));
+        DSK_E_TRY(dequeue_waiter* w, try_enqueue_no_lock(DSK_FORWARD(args)...));
 
         lk.unlock();
 
-        if(dequeueOp)
+        if(w)
         {
-            dequeueOp->complete(DSK_FORWARD(args)...);
+            w->put(*w, T(DSK_FORWARD(args)...));
+            w->complete(*w, {});
         }
 
         return {};
@@ -423,16 +719,15 @@ public:
 
     expected<T, errc> try_dequeue()
     {
+        taken_waiters<enqueue_waiter> ws;
+
         unique_lock lk(_mtx);
 
-        DSK_E_TRY_FWD(DSK_PARAM([enqueueOp, v]), try_dequeue_no_lock());
+        DSK_E_TRY_FWD(v, try_dequeue_no_lock(ws));
 
         lk.unlock();
 
-        if(enqueueOp)
-        {
-            enqueueOp->complete();
-        }
+        ws.complete_all();
 
         return mut_move(v);
     }
@@ -445,39 +740,18 @@ public:
             return {};
         }
 
-        vector<std::pair<async_dequeue_op*, T>> waiters;
+        taken_waiters<dequeue_waiter> ws;
 
         {
-            unique_lock lk(_mtx);
-            integrity_assert_no_lock();
-
-            if(_endMarked)
-            {
-                return errc::end_reached;
-            }
-
-            ++_stats.enqueueTotal;
-
-            _resQueue.append_range(move_range(r));
-
-            waiters.reserve(std::min(_dequeueWaiters.size(), _resQueue.size()));
+            lock_guard lg(_mtx);
 
-            while(auto* w = _dequeueWaiters.take_oldest())
-            {
-                waiters.emplace_back(w, mut_move(_resQueue.front()));
-                _resQueue.pop_front();
+            auto   it = std::ranges::begin(r);
+            size_t n  = static_cast<size_t>(std::ranges::distance(r));
 
-                if(_resQueue.empty())
-                {
-                    break;
-                }
-            }
+            DSK_E_TRY_ONLY(enqueue_items_no_lock<true>(it, n, ws));
         }
 
-        for(auto&[w, v] : waiters)
-        {
-            w->complete(mut_move(v));
-        }
+        ws.complete_all();
 
         return {};
     }
@@ -485,7 +759,7 @@ public:
     // One can use it after DSK_TRY dequeue() to make the whole awaitable.
     errc force_dequeue_all(auto& cont)
     {
-        vector<async_enqueue_op*> waiters;
+        taken_waiters<enqueue_waiter> ws;
 
         {
             unique_lock lk(_mtx);
@@ -498,29 +772,15 @@ public:
             }
 
             ++_stats.dequeueTotal;
+            _stats.dequeueItems += _resQueue.size();
 
             cont.append_range(move_range(_resQueue));
             _resQueue.clear();
 
-            waiters.reserve(std::min(_enqueueWaiters.size(), _cap));
-
-            while(auto* w = _enqueueWaiters.take_oldest())
-            {
-                _resQueue.emplace_back(mut_move(w->_v));
-
-                waiters.emplace_back(w);
-
-                if(_resQueue.size() >= _cap)
-                {
-                    break;
-                }
-            }
+            refill_no_lock(ws);
         }
 
-        for(auto* w : waiters)
-        {
-            w->complete();
-        }
+        ws.complete_all();
 
         return {};
     }
@@ -2,6 +2,8 @@
 
 #include <dsk/scheduler.hpp>
 #include <dsk/continuation.hpp>
+#include <span>
+#include <ranges>
 #include <type_traits>
 
 
@@ -15,6 +17,30 @@ template<class T>
 concept _scheduler_or_resumer_ = _scheduler_<T> || _resumer_<T>;
 
 
+// _scheduler_ that can enqueue a batch of continuations at once, i.e. under a single lock
+// and waking only as many workers as needed, instead of one post() per continuation.
+// Elements of the batch are moved from.
+template<class T>
+concept _bulk_scheduler_ = _scheduler_<T> && requires(std::remove_cvref_t<T>& s, std::span<continuation> cs){ s.post_bulk(cs); };
+
+// Post each continuation of conts, elements are moved from.
+// If sr supports post_bulk(), the whole batch is posted at once.
+constexpr void post_bulk(_scheduler_or_resumer_ auto&& sr, std::ranges::range auto&& conts)
+{
+    if constexpr(requires{ sr.post_bulk(conts); })
+    {
+        sr.post_bulk(conts);
+    }
+    else
+    {
+        for(auto&& c : conts)
+        {
+            sr.post(mut_move(c));
+        }
+    }
+}
+
+
 template<_scheduler_ Sch>
 class scheudler_resumer
 {
@@ -32,6 +58,11 @@ public:
     {
         _sch->post(DSK_FORWARD(cont));
     }
+
+    constexpr void post_bulk(std::ranges::range auto&& conts) requires(_bulk_scheduler_<Sch>)
+    {
+        _sch->post_bulk(conts);
+    }
 };
 
 template<class Sch>
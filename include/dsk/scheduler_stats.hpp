@@ -0,0 +1,391 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/vector.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/stringify.hpp>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <memory>
+
+
+// Scheduler telemetry is compiled out unless DSK_ENABLE_SCHEDULER_STATS is defined.
+// When compiled out, schedulers don't record anything and stats() returns empty scheduler_stats.
+
+
+namespace dsk{
+
+
+#if defined(DSK_ENABLE_SCHEDULER_STATS)
+    inline constexpr bool scheduler_stats_enabled = true;
+#else
+    inline constexpr bool scheduler_stats_enabled = false;
+#endif
+
+
+// log2 bucketed latency histogram in nanoseconds.
+// Bucket 0 counts [0, 2), bucket i counts [2^i, 2^(i+1)).
+class latency_histogram
+{
+public:
+    static constexpr size_t bucket_count = 40; // up to about 18 minutes
+
+    static constexpr size_t bucket_of(uint64_t ns) noexcept
+    {
+        size_t i = ns ? static_cast<size_t>(std::bit_width(ns)) - 1 : 0;
+        return i < bucket_count ? i : bucket_count - 1;
+    }
+
+    // exclusive upper bound of bucket i
+    static constexpr uint64_t bucket_upper(size_t i) noexcept
+    {
+        return uint64_t(1) << (i + 1);
+    }
+
+private:
+    std::array<size_t, bucket_count> _buckets{};
+    size_t _count = 0;
+
+public:
+    constexpr void reset() noexcept { *this = {}; }
+
+    constexpr void add(uint64_t ns, size_t n = 1) noexcept
+    {
+        _buckets[bucket_of(ns)] += n;
+        _count += n;
+    }
+
+    constexpr void add_to_bucket(size_t i, size_t n) noexcept
+    {
+        _buckets[i] += n;
+        _count += n;
+    }
+
+    constexpr size_t count() const noexcept { return _count; }
+    constexpr size_t bucket(size_t i) const noexcept { return _buckets[i]; }
+
+    // upper bound (ns) of the bucket where p-th (0 <= p <= 1) percentile lies.
+    constexpr uint64_t percentile(double p) const noexcept
+    {
+        if(! _count)
+            return 0;
+
+        auto target = static_cast<size_t>(p * static_cast<double>(_count - 1)) + 1;
+        size_t acc = 0;
+
+        for(size_t i = 0; i < bucket_count; ++i)
+        {
+            acc += _buckets[i];
+
+            if(acc >= target)
+                return bucket_upper(i);
+        }
+
+        return bucket_upper(bucket_count - 1);
+    }
+
+    constexpr latency_histogram& operator+=(latency_histogram const& o) noexcept
+    {
+        for(size_t i = 0; i < bucket_count; ++i)
+            _buckets[i] += o._buckets[i];
+
+        _count += o._count;
+        return *this;
+    }
+
+    constexpr latency_histogram& operator-=(latency_histogram const& o) noexcept
+    {
+        for(size_t i = 0; i < bucket_count; ++i)
+            _buckets[i] -= o._buckets[i];
+
+        _count -= o._count;
+        return *this;
+    }
+};
+
+
+struct scheduler_worker_stats
+{
+    size_t posted        = 0; // jobs posted from this worker
+    size_t executed      = 0; // jobs executed by this worker
+    size_t steals        = 0; // jobs taken from other workers' queues
+    size_t parks         = 0; // times went idle and blocked waiting for jobs
+    size_t wakeups       = 0; // times woken up from parking
+    size_t maxQueueDepth = 0; // high-water mark of worker's own queue, if it has one
+
+    constexpr void reset() noexcept { *this = {}; }
+
+    constexpr scheduler_worker_stats& operator+=(scheduler_worker_stats const& o) noexcept
+    {
+        posted        += o.posted;
+        executed      += o.executed;
+        steals        += o.steals;
+        parks         += o.parks;
+        wakeups       += o.wakeups;
+        maxQueueDepth  = std::max(maxQueueDepth, o.maxQueueDepth);
+        return *this;
+    }
+
+    // NOTE: maxQueueDepth is kept as is.
+    constexpr scheduler_worker_stats& operator-=(scheduler_worker_stats const& o) noexcept
+    {
+        posted   -= o.posted;
+        executed -= o.executed;
+        steals   -= o.steals;
+        parks    -= o.parks;
+        wakeups  -= o.wakeups;
+        return *this;
+    }
+};
+
+
+struct scheduler_stats
+{
+    vector<scheduler_worker_stats> workers;
+    size_t            externalPosted      = 0; // jobs posted from threads not belonging to the scheduler
+    size_t            maxSharedQueueDepth = 0; // high-water mark of shared queue or total pending jobs, if tracked
+    latency_histogram postToRun;               // latency from post() to start of execution
+
+    constexpr void reset() noexcept { *this = {}; }
+
+    scheduler_worker_stats total() const noexcept
+    {
+        scheduler_worker_stats t;
+
+        for(auto& w : workers)
+            t += w;
+
+        return t;
+    }
+
+    size_t posted() const noexcept { return total().posted + externalPosted; }
+
+    // Stats accumulated since prev snapshot, useful for periodic reporting.
+    // High-water marks are kept as is.
+    scheduler_stats since(scheduler_stats const& prev) const
+    {
+        scheduler_stats d = *this;
+
+        for(size_t i = 0; i < std::min(d.workers.size(), prev.workers.size()); ++i)
+            d.workers[i] -= prev.workers[i];
+
+        d.externalPosted -= prev.externalPosted;
+        d.postToRun      -= prev.postToRun;
+        return d;
+    }
+};
+
+
+// Generate a report, e.g.:
+//      periodic_reporter rpt;
+//      auto prev = pool.stats();
+//      rpt.report([&]()
+//      {
+//          auto cur = pool.stats();
+//          return gen_scheduler_report("pool", cur.since(std::exchange(prev, cur)));
+//      });
+inline auto gen_scheduler_report(char const* name, scheduler_stats const& s)
+{
+    auto t = s.total();
+
+    auto r = cat_as_str("\n      ", name, ": workers=", s.workers.size(),
+                        ", posted=", s.posted(), ", executed=", t.executed,
+                        ", steals=", t.steals, ", parks=", t.parks, ", wakeups=", t.wakeups,
+                        ", maxQueueDepth=", std::max(t.maxQueueDepth, s.maxSharedQueueDepth),
+                        ", postToRun(ns) p50<", s.postToRun.percentile(0.5),
+                        " p99<", s.postToRun.percentile(0.99),
+                        " p999<", s.postToRun.percentile(0.999), "\n");
+
+    for(size_t i = 0; i < s.workers.size(); ++i)
+    {
+        auto& w = s.workers[i];
+
+        append_as_str(r, "        #", i, ": posted=", w.posted, ", executed=", w.executed,
+                         ", steals=", w.steals, ", parks=", w.parks, ", wakeups=", w.wakeups,
+                         ", maxQueueDepth=", w.maxQueueDepth, "\n");
+    }
+
+    return r;
+}
+
+
+// Records scheduler_stats for a scheduler.
+// Per worker counters are cache line padded and only written by the worker itself,
+// except posted and maxQueueDepth, which may be written by any thread posting to the worker.
+class scheduler_stats_recorder
+{
+public:
+    using clock      = std::chrono::steady_clock;
+    using time_point = clock::time_point;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    struct alignas(cache_line_size) worker_t
+    {
+        atomic<size_t> posted{0}, executed{0}, steals{0}, parks{0}, wakeups{0}, maxQueueDepth{0};
+        std::array<atomic<size_t>, latency_histogram::bucket_count> latency{};
+    };
+
+    std::unique_ptr<worker_t[]> _workers;
+    size_t                      _size = 0;
+    atomic<size_t>              _externalPosted{0};
+    atomic<size_t>              _maxSharedQueueDepth{0};
+    atomic<size_t>              _pending{0};
+    atomic<size_t>              _nBound{0};
+
+    inline static thread_local scheduler_stats_recorder const* tl_rec = nullptr;
+    inline static thread_local size_t                          tl_idx = npos;
+
+    // single writer increment
+    static void inc(atomic<size_t>& c) noexcept
+    {
+        c.store(c.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+
+    static void update_max(atomic<size_t>& m, size_t v) noexcept
+    {
+        size_t cur = m.load(memory_order_relaxed);
+
+        while(cur < v && ! m.compare_exchange_weak(cur, v, memory_order_relaxed))
+        {}
+    }
+
+public:
+    static time_point now() noexcept { return clock::now(); }
+
+    // Should be called before workers start.
+    void reset(size_t nWorkers)
+    {
+        _workers.reset(new worker_t[nWorkers]);
+        _size = nWorkers;
+        _externalPosted.store(0, memory_order_relaxed);
+        _maxSharedQueueDepth.store(0, memory_order_relaxed);
+        _pending.store(0, memory_order_relaxed);
+        _nBound.store(0, memory_order_relaxed);
+    }
+
+    size_t size() const noexcept { return _size; }
+
+    // Called by worker thread on start, so posts from it can be identified.
+    void bind_worker(size_t i) noexcept
+    {
+        DSK_ASSERT(i < _size);
+        tl_rec = this;
+        tl_idx = i;
+    }
+
+    // For worker threads not created by the scheduler itself, bind calling thread on first call.
+    // Return index of calling worker.
+    size_t bind_worker_lazily() noexcept
+    {
+        if(tl_rec != this || tl_idx >= _size)
+        {
+            tl_rec = this;
+            tl_idx = _nBound.fetch_add(1, memory_order_relaxed) % _size;
+        }
+
+        return tl_idx;
+    }
+
+    // index of calling worker, or npos if calling thread isn't a worker.
+    size_t current_worker() const noexcept
+    {
+        return tl_rec == this ? tl_idx : npos;
+    }
+
+    void on_post(size_t n = 1) noexcept
+    {
+        if(size_t w = current_worker(); w != npos) _workers[w].posted.fetch_add(n, memory_order_relaxed);
+        else                                       _externalPosted.fetch_add(n, memory_order_relaxed);
+    }
+
+    void on_queue_depth(size_t w, size_t depth) noexcept
+    {
+        update_max(_workers[w].maxQueueDepth, depth);
+    }
+
+    void on_shared_queue_depth(size_t depth) noexcept
+    {
+        update_max(_maxSharedQueueDepth, depth);
+    }
+
+    // For schedulers whose queue depth is not observable, track total pending jobs instead.
+    // Requires calling on_pending_done() on execution.
+    void on_pending_add() noexcept
+    {
+        on_shared_queue_depth(_pending.fetch_add(1, memory_order_relaxed) + 1);
+    }
+
+    void on_pending_done() noexcept
+    {
+        _pending.fetch_sub(1, memory_order_relaxed);
+    }
+
+    // called by worker w
+    void on_execute(size_t w, time_point postTime) noexcept
+    {
+        auto& wk = _workers[w];
+        auto  ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now() - postTime).count();
+
+        inc(wk.executed);
+        inc(wk.latency[latency_histogram::bucket_of(ns > 0 ? static_cast<uint64_t>(ns) : 0)]);
+    }
+
+    // for worker slots that may be shared by multiple threads.
+    void on_execute_any(size_t w, time_point postTime) noexcept
+    {
+        auto& wk = _workers[w];
+        auto  ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now() - postTime).count();
+
+        wk.executed.fetch_add(1, memory_order_relaxed);
+        wk.latency[latency_histogram::bucket_of(ns > 0 ? static_cast<uint64_t>(ns) : 0)].fetch_add(1, memory_order_relaxed);
+    }
+
+    void on_steal (size_t w) noexcept { inc(_workers[w].steals); }
+    void on_park  (size_t w) noexcept { inc(_workers[w].parks); }
+    void on_wakeup(size_t w) noexcept { inc(_workers[w].wakeups); }
+
+    scheduler_stats snapshot() const
+    {
+        scheduler_stats s;
+
+        s.workers.resize(_size);
+        s.externalPosted      = _externalPosted.load(memory_order_relaxed);
+        s.maxSharedQueueDepth = _maxSharedQueueDepth.load(memory_order_relaxed);
+
+        for(size_t i = 0; i < _size; ++i)
+        {
+            auto& wk = _workers[i];
+            auto& sw = s.workers[i];
+
+            sw.posted        = wk.posted       .load(memory_order_relaxed);
+            sw.executed      = wk.executed     .load(memory_order_relaxed);
+            sw.steals        = wk.steals       .load(memory_order_relaxed);
+            sw.parks         = wk.parks        .load(memory_order_relaxed);
+            sw.wakeups       = wk.wakeups      .load(memory_order_relaxed);
+            sw.maxQueueDepth = wk.maxQueueDepth.load(memory_order_relaxed);
+
+            for(size_t b = 0; b < latency_histogram::bucket_count; ++b)
+                s.postToRun.add_to_bucket(b, wk.latency[b].load(memory_order_relaxed));
+        }
+
+        return s;
+    }
+};
+
+
+// Job with post time, used when DSK_ENABLE_SCHEDULER_STATS is defined.
+template<class Job>
+struct timed_job
+{
+    Job job;
+    scheduler_stats_recorder::time_point postTime = scheduler_stats_recorder::now();
+
+    decltype(auto) operator()() { return job(); }
+};
+
+
+} // namespace dsk
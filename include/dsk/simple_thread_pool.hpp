@@ -4,6 +4,9 @@
 #include <dsk/expected.hpp>
 #include <dsk/continuation.hpp>
 #include <dsk/default_allocator.hpp>
+#include <dsk/scheduler_stats.hpp>
+#include <dsk/trace.hpp>
+#include <dsk/numa_node_scheduler.hpp>
 #include <dsk/util/debug.hpp>
 #include <dsk/util/deque.hpp>
 #include <dsk/util/vector.hpp>
@@ -11,37 +14,66 @@
 #include <dsk/util/mutex.hpp>
 #include <dsk/util/thread.hpp>
 #include <dsk/util/atomic.hpp>
+#include <dsk/util/ws_deque.hpp>
+#include <dsk/util/mpmc_queue.hpp>
+#include <dsk/util/allocate_unique.hpp>
+#include <dsk/util/recycling_allocator.hpp>
 #include <dsk/util/condition_variable.hpp>
+#include <dsk/util/cpu_affinity.hpp>
+#include <dsk/util/cpu_topology.hpp>
+#include <ranges>
 
 
 namespace dsk{
 
 
+enum simple_thread_pool_mode_e
+{
+    // each worker has a mutex protected deque,
+    // idle worker sweeps other workers' deques with try_to_lock.
+    stp_locked_deques,
+
+    // each worker has a lock-free Chase-Lev deque (owner LIFO, thief FIFO),
+    // idle worker steals from random victims, then parks on an atomic wait.
+    // Jobs posted from outside of the pool go to a shared lock-free injection queue.
+    stp_lock_free_deques
+};
+
+
 // A somewhat not so naive thread pool,
 // based on a simple work stealing implementation.
 template<
-    class Job = continuation
+    class Job = continuation,
     //class Job = unique_function<void()>
+    simple_thread_pool_mode_e Mode = stp_locked_deques
 >
 class simple_thread_pool_t
 {
+    static constexpr bool lock_free = (Mode == stp_lock_free_deques);
+
     enum err_e { e_ok = 0, e_stop, e_nolock, e_nojob, r_exit };
 
+    using job_type = DSK_CONDITIONAL_T(scheduler_stats_enabled, timed_job<Job>, Job);
+
     class thread_state
     {
         mutex              _mtx;
         condition_variable _cv;
         bool               _stop = false;
-        deque<Job>         _jobs;
+        deque<job_type>    _jobs;
 
     public:
+        // owner only
+        std::optional<job_type> next;         // LIFO slot for jobs posted by the owner itself
+        uint32_t                nextRuns = 0; // consecutive runs from next
+
         // vector::resize(n) requires move or copy ctor,
         // but they should never be called in our case.
         thread_state() = default;
         thread_state(thread_state&&) noexcept { DSK_ASSERT(true); }
         ///
 
-        std::optional<Job> try_pop()
+        std::optional<job_type> try_pop()
         {
             unique_lock lk(_mtx, try_to_lock);
 
@@ -53,7 +85,7 @@ class simple_thread_pool_t
             return job;
         }
 
-        std::optional<Job> pop()
+        std::optional<job_type> pop(bool& parked)
         {
             unique_lock lk(_mtx);
 
@@ -65,6 +97,7 @@ class simple_thread_pool_t
                 if(_jobs.size())
                     break;
 
+                parked = true;
                 _cv.wait(lk);
             }
 
@@ -73,12 +106,13 @@ class simple_thread_pool_t
             return job;
         }
 
-        bool try_push(auto&& job)
+        // return queue size after push, or 0 if failed.
+        size_t try_push(auto&& job)
         {
             unique_lock lk(_mtx, try_to_lock);
             
             if(! lk)
-                return false;
+                return 0;
 
             bool wasEmpty = _jobs.empty();
 
@@ -87,10 +121,11 @@ class simple_thread_pool_t
             if(wasEmpty)
                 _cv.notify_one();
 
-            return true;
+            return _jobs.size();
         }
 
-        void push(auto&& job)
+        // return queue size after push
+        size_t push(auto&& job)
         {
             lock_guard lk(_mtx);
 
@@ -100,6 +135,27 @@ class simple_thread_pool_t
 
             if(wasEmpty)
                 _cv.notify_one();
+
+            return _jobs.size();
+        }
+
+        // push n jobs from it under a single lock, jobs are moved from.
+        // return queue size after push
+        size_t push_bulk(auto& it, size_t n)
+        {
+            lock_guard lk(_mtx);
+
+            bool wasEmpty = _jobs.empty();
+
+            for(size_t i = 0; i < n; ++i, ++it)
+            {
+                _jobs.emplace_back(mut_move(*it));
+            }
+
+            if(wasEmpty)
+                _cv.notify_one();
+
+            return _jobs.size();
         }
 
         void stop()
@@ -110,11 +166,548 @@ class simple_thread_pool_t
         }
     };
 
+    // In lock-free mode, jobs are boxed so they can be passed around as pointers.
+    // Boxes are recycled by per-thread caches, so steady state posting doesn't hit the heap:
+    // a job posted and run on the same worker reuses the box locally,
+    // boxes freed on other threads flow back through the shared depot in batches.
+    using job_allocator = recycling_allocator<job_type>;
+    using job_ptr       = allocated_unique_ptr<job_type, job_allocator>;
+
+    static constexpr size_t   lf_deque_init_cap     = 256;
+    static constexpr size_t   lf_inject_cap         = 4096;
+    static constexpr uint32_t lf_inject_check_ticks = 61; // poll injection queue every n local jobs to keep it from starving
+
+    // A job posted from a worker of the pool goes to the worker's next slot, so it runs on the same
+    // core while the frame is still hot. To keep other jobs from starving, jobs run from next slot
+    // consecutively are limited, after that it is requeued like any other job.
+    static constexpr uint32_t next_max_runs = 3;
+
+    class lf_thread_state
+    {
+    public:
+        ws_deque<job_type*> jobs{lf_deque_init_cap};
+        job_type*           next = nullptr; // see next_max_runs
+        uint32_t            nextRuns = 0;
+        uint32_t            rnd = 0;
+        uint32_t            tick = 0;
+
+        // vector::resize(n) requires move or copy ctor,
+        // but they should never be called in our case.
+        lf_thread_state() = default;
+        lf_thread_state(lf_thread_state&&) noexcept { DSK_ASSERT(true); }
+        ///
+
+        // xorshift32
+        uint32_t next_rnd() noexcept
+        {
+            rnd ^= rnd << 13;
+            rnd ^= rnd >> 17;
+            rnd ^= rnd << 5;
+            return rnd;
+        }
+    };
+
+    using state_type = DSK_CONDITIONAL_T(lock_free, lf_thread_state, thread_state);
+
     vector<thread>       _threads;
-    vector<thread_state> _states;
+    vector<state_type>   _states;
     atomic<uint32_t>     _next = 0;
     uint32_t             _size = 0;
     int                  _maxConcurrency = default_max_concurrency();
+    bool                 _useNext = true;
+
+    // see set_cpu_topology()
+    cpu_topology const*                               _topo = nullptr;
+    vector<uint32_t>                                  _nodeBegin;  // workers of node k are [_nodeBegin[k], _nodeBegin[k + 1])
+    vector<uint32_t>                                  _workerNode; // node of each worker
+    vector<numa_node_scheduler<simple_thread_pool_t>> _nodeSchs;
+
+    scheduler_stats_recorder _stats; // only used if scheduler_stats_enabled
+
+    // lock-free mode only
+    std::optional<bounded_mpmc_queue<job_type*>>         _inject;
+    mutex                                                _overflowMtx; // when _inject is full
+    deque<job_type*>                                     _overflow;
+    atomic<size_t>                                       _overflowSize = 0;
+    vector<std::optional<bounded_mpmc_queue<job_type*>>> _nodeInject; // by post_to_node(), if more than 1 node
+    atomic<bool>                                         _stop  = false;
+    atomic<uint32_t>                                     _epoch = 0; // parked workers wait on it
+    atomic<uint32_t>                                     _nIdle = 0;
+
+    inline static thread_local simple_thread_pool_t const* tl_pool  = nullptr;
+    inline static thread_local uint32_t                    tl_index = 0;
+
+    static job_type* lf_box(auto&& f)
+    {
+        return allocate_unique<job_type>(job_allocator(), DSK_FORWARD(f)).release();
+    }
+
+    static void lf_free(job_type* j)
+    {
+        job_ptr job(j);
+    }
+
+    void exec(uint32_t index, job_type& job)
+    {
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.on_execute(index, job.postTime);
+        }
+
+        trace(trace_job_begin, this);
+        job();
+        trace(trace_job_end, this);
+    }
+
+    // wake up to n parked workers, if any.
+    void lf_notify(size_t n = 1) noexcept
+    {
+        // pairs with the fence in lf_park(),
+        // so either we see the idle worker, or it sees the job we just pushed.
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if(uint32_t nIdle = _nIdle.load(memory_order_relaxed))
+        {
+            _epoch.fetch_add(1, memory_order_release);
+
+            if(n >= nIdle)
+            {
+                _epoch.notify_all();
+            }
+            else
+            {
+                for(size_t i = 0; i < n; ++i)
+                    _epoch.notify_one();
+            }
+        }
+    }
+
+    job_type* lf_pop_injected(uint32_t index)
+    {
+        if(_nodeInject.size())
+        {
+            if(auto j = _nodeInject[_workerNode[index]]->try_pop())
+                return *j;
+        }
+
+        if(auto j = _inject->try_pop())
+            return *j;
+
+        if(_overflowSize.load(memory_order_relaxed))
+        {
+            lock_guard lk(_overflowMtx);
+
+            if(_overflow.size())
+            {
+                job_type* j = _overflow.front();
+                _overflow.pop_front();
+                _overflowSize.store(_overflow.size(), memory_order_relaxed);
+                return j;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // jobs posted to other nodes, taken only when there is nothing else,
+    // as workers of their nodes may be all busy or parked.
+    job_type* lf_pop_other_nodes(uint32_t index)
+    {
+        for(size_t k = 0; k < _nodeInject.size(); ++k)
+        {
+            if(k != _workerNode[index])
+            {
+                if(auto j = _nodeInject[k]->try_pop())
+                    return *j;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void init_nodes()
+    {
+        size_t nNode = _nodeSchs.size();
+
+        _workerNode.resize(_size);
+        _nodeBegin.assign(nNode + 1, 0);
+
+        for(uint32_t index = 0; index < _size; ++index)
+        {
+            uint32_t k = _topo ? static_cast<uint32_t>(_topo->node_of_worker(index, _size)) : 0;
+
+            _workerNode[index] = k;
+            ++_nodeBegin[k + 1];
+        }
+
+        for(size_t k = 0; k < nNode; ++k)
+        {
+            _nodeBegin[k + 1] += _nodeBegin[k];
+        }
+    }
+
+    // The i-th worker to visit from worker index, when looking for a job.
+    // Workers of the same node go first, starting from index + rot, then the others, starting from rot.
+    uint32_t neighbor(uint32_t index, uint32_t i, uint32_t rot = 0) const noexcept
+    {
+        uint32_t k = _workerNode[index];
+        uint32_t b = _nodeBegin[k];
+        uint32_t e = _nodeBegin[k + 1];
+        uint32_t n = e - b;
+
+        if(i < n)
+            return b + (index - b + rot + i) % n;
+
+        return (e + (rot + i - n) % (_size - n)) % _size;
+    }
+
+    job_type* lf_steal(uint32_t index)
+    {
+        auto& s = _states[index];
+
+        // start from a random victim of the same node, then go through all the others.
+        uint32_t rot = s.next_rnd() % _size;
+
+        for(uint32_t i = 0; i < _size; ++i)
+        {
+            uint32_t v = neighbor(index, i, rot);
+
+            if(v == index)
+                continue;
+
+            if(auto j = _states[v].jobs.steal())
+            {
+                if constexpr(scheduler_stats_enabled)
+                {
+                    _stats.on_steal(index);
+                }
+
+                return *j;
+            }
+        }
+
+        return nullptr;
+    }
+
+    job_type* lf_find_job(uint32_t index)
+    {
+        auto& s = _states[index];
+
+        if(s.next)
+        {
+            job_type* j = std::exchange(s.next, nullptr);
+
+            if(++s.nextRuns <= next_max_runs)
+                return j;
+
+            // requeue it behind others
+            lf_inject(j);
+            lf_notify();
+        }
+
+        s.nextRuns = 0;
+
+        if(++s.tick % lf_inject_check_ticks == 0)
+        {
+            if(job_type* j = lf_pop_injected(index))
+                return j;
+        }
+
+        if(auto j = s.jobs.pop())
+            return *j;
+
+        job_type* j = lf_pop_injected(index);
+
+        if(! j)
+            j = lf_steal(index);
+
+        if(! j)
+            j = lf_pop_other_nodes(index);
+
+        // there may be more, let another worker help.
+        if(j)
+            lf_notify();
+
+        return j;
+    }
+
+    // Return a job found during re-check, or nullptr after being woken up.
+    job_type* lf_park(uint32_t index)
+    {
+        uint32_t e = _epoch.load(memory_order_acquire);
+
+        _nIdle.fetch_add(1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        job_type* j = nullptr;
+
+        if(! _stop.load(memory_order_relaxed))
+        {
+            j = lf_pop_injected(index);
+
+            if(! j)
+                j = lf_steal(index);
+
+            if(! j)
+                j = lf_pop_other_nodes(index);
+
+            if(! j)
+            {
+                if constexpr(scheduler_stats_enabled)
+                {
+                    _stats.on_park(index);
+                }
+
+                _epoch.wait(e, memory_order_acquire);
+
+                if constexpr(scheduler_stats_enabled)
+                {
+                    _stats.on_wakeup(index);
+                }
+            }
+        }
+
+        _nIdle.fetch_sub(1, memory_order_relaxed);
+        return j;
+    }
+
+    // push to one of the queues of workers [b, b + n), starting from round-robin selected one.
+    void push_to_queues(uint32_t b, uint32_t n, auto&& f)
+    {
+        uint32_t index = b + _next.fetch_add(1, memory_order_relaxed) % n;
+
+        // First try to push to one of the threads without blocking.
+        for(uint32_t i = 0; i < n; ++i)
+        {
+            uint32_t k = b + (index - b + i) % n;
+
+            if(size_t depth = _states[k].try_push(DSK_FORWARD(f)))
+            {
+                if constexpr(scheduler_stats_enabled)
+                {
+                    _stats.on_queue_depth(k, depth);
+                }
+
+                return;
+            }
+        }
+
+        // Otherwise, do a blocking push on the selected thread.
+        size_t depth = _states[index].push(DSK_FORWARD(f));
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.on_queue_depth(index, depth);
+        }
+    }
+
+    void run(uint32_t index)
+    {
+        tl_pool  = this;
+        tl_index = index;
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.bind_worker(index);
+        }
+
+        auto& s = _states[index];
+
+        for(;;)
+        {
+            std::optional<job_type> job;
+
+            if(s.next)
+            {
+                job = mut_move(*s.next);
+                s.next.reset();
+
+                if(++s.nextRuns > next_max_runs)
+                {
+                    // requeue it behind others
+                    push_to_queues(0, _size, mut_move(*job));
+                    job.reset();
+                }
+            }
+
+            if(! job)
+            {
+                s.nextRuns = 0;
+
+                // First try to pop from one of threads without blocking.
+                for(uint32_t i = 0; i < _size; ++i)
+                {
+                    if((job = _states[neighbor(index, i)].try_pop()))
+                    {
+                        if constexpr(scheduler_stats_enabled)
+                        {
+                            if(i) _stats.on_steal(index);
+                        }
+
+                        break;
+                    }
+                }
+
+                // Otherwise, do a blocking pop on own thread.
+                if(! job)
+                {
+                    bool parked = false;
+
+                    job = s.pop(parked);
+
+                    if constexpr(scheduler_stats_enabled)
+                    {
+                        if(parked)
+                        {
+                            _stats.on_park(index);
+                            _stats.on_wakeup(index);
+                        }
+                    }
+
+                    if(! job)
+                        break; // stop requested, only exit own thread
+                }
+            }
+
+            exec(index, *job);
+        }
+
+        tl_pool  = nullptr;
+        tl_index = 0;
+    }
+
+    void lf_run(uint32_t index)
+    {
+        tl_pool  = this;
+        tl_index = index;
+
+        _states[index].rnd = (index + 1) * 0x9E3779B9u;
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.bind_worker(index);
+        }
+
+        while(! _stop.load(memory_order_relaxed))
+        {
+            job_type* j = lf_find_job(index);
+
+            if(! j && ! (j = lf_park(index)))
+                continue;
+
+            job_ptr job(j);
+            exec(index, *job);
+        }
+
+        tl_pool  = nullptr;
+        tl_index = 0;
+    }
+
+    void lf_inject(job_type* j)
+    {
+        if(! _inject->try_push(j))
+        {
+            lock_guard lk(_overflowMtx);
+            _overflow.emplace_back(j);
+            _overflowSize.store(_overflow.size(), memory_order_relaxed);
+        }
+    }
+
+    void lf_post(auto&& f)
+    {
+        job_type* j = lf_box(DSK_FORWARD(f));
+
+        if(tl_pool == this)
+        {
+            auto& s = _states[tl_index];
+
+            // the worker will run it soon, no need to notify others,
+            // unless a previous one is moved out.
+            if(_useNext && ! (j = std::exchange(s.next, j)))
+                return;
+
+            s.jobs.push(j);
+
+            if constexpr(scheduler_stats_enabled)
+            {
+                _stats.on_queue_depth(tl_index, s.jobs.size());
+            }
+        }
+        else
+        {
+            lf_inject(j);
+
+            if constexpr(scheduler_stats_enabled)
+            {
+                _stats.on_shared_queue_depth(_inject->size() + _overflowSize.load(memory_order_relaxed));
+            }
+        }
+
+        lf_notify();
+    }
+
+    void lf_post_bulk(auto& fs, size_t n)
+    {
+        if(tl_pool == this)
+        {
+            auto& s = _states[tl_index];
+
+            for(auto&& f : fs)
+            {
+                s.jobs.push(lf_box(mut_move(f)));
+            }
+
+            if constexpr(scheduler_stats_enabled)
+            {
+                _stats.on_queue_depth(tl_index, s.jobs.size());
+            }
+        }
+        else
+        {
+            for(auto&& f : fs)
+            {
+                lf_inject(lf_box(mut_move(f)));
+            }
+
+            if constexpr(scheduler_stats_enabled)
+            {
+                _stats.on_shared_queue_depth(_inject->size() + _overflowSize.load(memory_order_relaxed));
+            }
+        }
+
+        lf_notify(n);
+    }
+
+    // free all remaining jobs, must be called after all workers exit.
+    void lf_clear()
+    {
+        for(auto& s : _states)
+        {
+            if(s.next)
+                lf_free(s.next);
+
+            while(auto j = s.jobs.pop())
+                lf_free(*j);
+        }
+
+        while(auto j = _inject->try_pop())
+            lf_free(*j);
+
+        for(job_type* j : _overflow)
+            lf_free(j);
+
+        for(auto& q : _nodeInject)
+        {
+            while(auto j = q->try_pop())
+                lf_free(*j);
+        }
+
+        _inject.reset();
+        _nodeInject.clear();
+        _overflow.clear();
+        _overflowSize.store(0, memory_order_relaxed);
+        _stop.store(false, memory_order_relaxed);
+    }
 
 public:
     simple_thread_pool_t(simple_thread_pool_t const&) = delete;
@@ -123,6 +716,7 @@ public:
     explicit simple_thread_pool_t(int n = -1, start_scheduler_e startNow = dont_start_now)
     {
         set_max_concurrency(n);
+        set_cpu_topology(nullptr);
 
         if(startNow)
         {
@@ -154,6 +748,47 @@ public:
         _maxConcurrency = n > 0 ? n : default_max_concurrency();
     }
 
+    // Enabled by default. Posts from a worker of the pool go to its next slot, see next_max_runs.
+    // Should be called before start().
+    void set_next_slot_enabled(bool on) noexcept
+    {
+        DSK_ASSERT(! started());
+        _useNext = on;
+    }
+
+    // Workers are split over NUMA nodes of t in proportion to their cpus, each is pinned to cpus of its node,
+    // and an idle worker looks for jobs on workers of the same node before going across nodes.
+    // Jobs can be tied to a node with post_to_node() or node_scheduler().
+    // nullptr to disable, which is the default, then there is a single node of all workers.
+    // Should be called before start().
+    void set_cpu_topology(cpu_topology const* t = std::addressof(cpu_topology::system()))
+    {
+        DSK_ASSERT(! started());
+
+        _topo = t;
+        _nodeSchs.clear();
+
+        for(size_t k = 0; k < (t ? t->node_count() : 1); ++k)
+        {
+            _nodeSchs.emplace_back(*this, k);
+        }
+    }
+
+    size_t node_count() const noexcept { return _nodeSchs.size(); }
+
+    // node of calling worker, or -1 if not called on a worker of the pool.
+    ptrdiff_t current_node() const noexcept
+    {
+        return tl_pool == this ? static_cast<ptrdiff_t>(_workerNode[tl_index]) : -1;
+    }
+
+    // _scheduler_ posting to workers of node k.
+    auto& node_scheduler(size_t k) noexcept
+    {
+        DSK_ASSERT(k < _nodeSchs.size());
+        return _nodeSchs[k];
+    }
+
     bool started() const noexcept {  return _size > 0; }
 
     void start()
@@ -170,29 +805,45 @@ public:
 
         _threads.reserve(_size);
 
+        if constexpr(lock_free)
+        {
+            _inject.emplace(lf_inject_cap);
+        }
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.reset(_size);
+        }
+
+        init_nodes();
+
+        if constexpr(lock_free)
+        {
+            if(_nodeSchs.size() > 1)
+            {
+                _nodeInject = decltype(_nodeInject)(_nodeSchs.size());
+
+                for(auto& q : _nodeInject)
+                    q.emplace(lf_inject_cap);
+            }
+        }
+
         for(uint32_t index = 0; index < _size; ++index)
         {
             _threads.emplace_back([this, index]()
             {
-                for(;;)
+                if(_topo)
                 {
-                    std::optional<Job> job;
-
-                    // First try to pop from one of threads without blocking.
-                    for(uint32_t i = 0; i < _size; ++i)
-                    {
-                        if((job = _states[(index + i) % _size].try_pop()))
-                            break;
-                    }
-
-                    // Otherwise, do a blocking pop on own thread.
-                    if(! job)
-                    {
-                        if(! (job = _states[index].pop()))
-                            return; // stop requested, only exit own thread
-                    }
+                    pin_this_thread_to_cpus(_topo->node(_workerNode[index]).cpus);
+                }
 
-                    (*job)();
+                if constexpr(lock_free)
+                {
+                    lf_run(index);
+                }
+                else
+                {
+                    run(index);
                 }
             });
         }
@@ -208,17 +859,116 @@ public:
     {
         DSK_ASSERT(started());
 
-        uint32_t index = _next.fetch_add(1, memory_order_relaxed) % _size;
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.on_post();
+        }
 
-        // First try to push to one of the threads without blocking.
-        for(uint32_t i = 0; i < _size; ++i)
+        if constexpr(lock_free)
         {
-            if(_states[(index + i) % _size].try_push(DSK_FORWARD(f)))
+            lf_post(DSK_FORWARD(f));
+        }
+        else
+        {
+            if(_useNext && tl_pool == this)
+            {
+                auto& s = _states[tl_index];
+
+                if(s.next)
+                    push_to_queues(0, _size, mut_move(*s.next));
+
+                s.next.emplace(DSK_FORWARD(f));
                 return;
+            }
+
+            push_to_queues(0, _size, DSK_FORWARD(f));
         }
+    }
 
-        // Otherwise, do a blocking push on the selected thread.
-        _states[index].push(DSK_FORWARD(f));
+    // Post to a worker of node k, see set_cpu_topology().
+    // Posts from a worker of node k are same as post().
+    // Workers of node k are preferred, but it may still be stolen by other nodes when they are idle.
+    void post_to_node(size_t k, auto&& f)
+    {
+        DSK_ASSERT(started());
+        DSK_ASSERT(k < _nodeSchs.size());
+
+        if(tl_pool == this && _workerNode[tl_index] == k)
+        {
+            post(DSK_FORWARD(f));
+            return;
+        }
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.on_post();
+        }
+
+        if constexpr(lock_free)
+        {
+            job_type* j = lf_box(DSK_FORWARD(f));
+
+            if(_nodeInject.empty() || ! _nodeInject[k]->try_push(j))
+            {
+                lf_inject(j);
+
+                if constexpr(scheduler_stats_enabled)
+                {
+                    _stats.on_shared_queue_depth(_inject->size() + _overflowSize.load(memory_order_relaxed));
+                }
+            }
+
+            lf_notify();
+        }
+        else
+        {
+            uint32_t b = _nodeBegin[k];
+            uint32_t n = _nodeBegin[k + 1] - b;
+
+            if(n) push_to_queues(b, n, DSK_FORWARD(f));
+            else  push_to_queues(0, _size, DSK_FORWARD(f)); // no worker on the node
+        }
+    }
+
+    // Post a batch of jobs, elements of fs are moved from.
+    // In locked mode, the batch is split over at most size() worker queues, each one is locked once.
+    // In lock-free mode, jobs go to calling worker's deque or the injection queue without locking.
+    // Only as many parked workers as jobs are woken up.
+    void post_bulk(std::ranges::sized_range auto&& fs)
+    {
+        DSK_ASSERT(started());
+
+        size_t n = std::ranges::size(fs);
+
+        if(! n)
+            return;
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.on_post(n);
+        }
+
+        if constexpr(lock_free)
+        {
+            lf_post_bulk(fs, n);
+        }
+        else
+        {
+            uint32_t nq    = static_cast<uint32_t>(std::min<size_t>(n, _size));
+            uint32_t index = _next.fetch_add(nq, memory_order_relaxed) % _size;
+            auto     it    = std::ranges::begin(fs);
+
+            for(uint32_t i = 0; i < nq; ++i)
+            {
+                uint32_t k     = (index + i) % _size;
+                size_t   depth = _states[k].push_bulk(it, n / nq + (i < n % nq));
+
+                if constexpr(scheduler_stats_enabled)
+                {
+                    _stats.on_queue_depth(k, depth);
+                }
+            }
+        }
     }
 
     // Signal underlying threads to stop. Pending jobs may be ignored.
@@ -227,9 +977,18 @@ public:
         if(! started())
             return;
 
-        for(auto& s : _states)
+        if constexpr(lock_free)
+        {
+            _stop.store(true, memory_order_relaxed);
+            _epoch.fetch_add(1, memory_order_release);
+            _epoch.notify_all();
+        }
+        else
         {
-            s.stop();
+            for(auto& s : _states)
+            {
+                s.stop();
+            }
         }
     }
 
@@ -246,6 +1005,11 @@ public:
             t.join();
         }
 
+        if constexpr(lock_free)
+        {
+            lf_clear();
+        }
+
         _threads.clear();
         _states.clear();
         _next.store(0, memory_order_relaxed);
@@ -257,10 +1021,19 @@ public:
         stop();
         join();
     }
+
+    // Empty if DSK_ENABLE_SCHEDULER_STATS is not defined.
+    // Stats are reset on start().
+    scheduler_stats stats() const
+    {
+        if constexpr(scheduler_stats_enabled) return _stats.snapshot();
+        else                                  return {};
+    }
 };
 
 
 using simple_thread_pool = simple_thread_pool_t<>;
+using lock_free_thread_pool = simple_thread_pool_t<continuation, stp_lock_free_deques>;
 
 
 // a single lock round-robin style thread pool
@@ -352,7 +1125,9 @@ public:
                         _jobs.pop_front();
                     }
 
+                    trace(trace_job_begin, this);
                     (*job)();
+                    trace(trace_job_end, this);
                 }
             });
         }
@@ -376,6 +1151,36 @@ public:
         _cv.notify_one();
     }
 
+    // Post a batch of jobs under a single lock, elements of fs are moved from.
+    void post_bulk(std::ranges::sized_range auto&& fs)
+    {
+        DSK_ASSERT(started());
+
+        size_t n = std::ranges::size(fs);
+
+        if(! n)
+            return;
+
+        {
+            unique_lock lock(_mtx);
+
+            for(auto&& f : fs)
+            {
+                _jobs.emplace_back(mut_move(f));
+            }
+        };
+
+        if(n >= _threads.size())
+        {
+            _cv.notify_all();
+        }
+        else
+        {
+            for(size_t i = 0; i < n; ++i)
+                _cv.notify_one();
+        }
+    }
+
     // Signal underlying threads to stop. Pending jobs may be ignored.
     void stop()
     {
@@ -4,6 +4,9 @@
 #include <dsk/async_op.hpp>
 #include <dsk/awaitables.hpp>
 #include <dsk/continuation.hpp>
+#include <dsk/any_resumer.hpp>
+#include <dsk/util/tuple.hpp>
+#include <dsk/util/vector.hpp>
 #include <dsk/util/atomic.hpp>
 #include <dsk/util/allocate_unique.hpp>
 
@@ -17,15 +20,24 @@ struct start_async_op_on_scheduler_op : Op
     DSK_NO_UNIQUE_ADDR Resumer _resumer;
 
     using is_async_op = void;
+    using is_scheduler_start_op = void;
 
-    void initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
+    auto& start_resumer() noexcept { return _resumer; }
+
+    // the job initiate() posts to _resumer
+    auto make_initiator(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
     {
-        _resumer.post([this, ctx = DSK_FORWARD(ctx), cont = DSK_FORWARD(cont)]() mutable
+        return [this, ctx = DSK_FORWARD(ctx), cont = DSK_FORWARD(cont)]() mutable
         {
             manual_initiate(static_cast<Op&>(*this),
                             make_async_ctx_if<OverrideCtx>(ctx, mut_move(_resumer)),
                             bind_resumer_if<Solely>(mut_move(cont), get_resumer(ctx)));
-        });
+        };
+    }
+
+    void initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
+    {
+        _resumer.post(make_initiator(DSK_FORWARD(ctx), DSK_FORWARD(cont)));
     }
 };
 
@@ -52,4 +64,61 @@ auto solely_run_on(_scheduler_or_resumer_ auto&& sr, _async_op_ auto&& op)
 }
 
 
+template<class T>
+concept _bulk_startable_op_ = requires(std::remove_cvref_t<T>& op)
+{
+    typename std::remove_cvref_t<T>::is_scheduler_start_op;
+    { op.start_resumer().scheduler() } -> _bulk_scheduler_;
+};
+
+// Initiate each op of 'ops', which is a tuple or range, with continuation genCont(op, idx).
+// Consecutive start_on() ops targeting the same _bulk_scheduler_ are collected and posted
+// with a single post_bulk(), instead of one post() per op. Ops are still started in order,
+// a pending batch is posted before any other op is initiated.
+// NOTE: like manual_initiate(), continuations may be resumed inside,
+//       so don't use ops or related resources after this returns.
+void manual_initiate_each(auto& ops, _async_ctx_ auto&& ctx, auto&& genCont)
+{
+    any_resumer          batchSr;
+    vector<continuation> batch;
+
+    auto flush = [&]()
+    {
+        if(batch.size())
+        {
+            batchSr.post_bulk(batch);
+            batch.clear();
+        }
+    };
+
+    size_t idx = 0;
+
+    uforeach(ops, [&](auto& op)
+    {
+        if constexpr(_bulk_startable_op_<decltype(op)>)
+        {
+            if(! is_immediate(op))
+            {
+                any_resumer sr(op.start_resumer());
+
+                if(sr.typed_id() != batchSr.typed_id())
+                {
+                    flush();
+                    batchSr = sr;
+                }
+
+                batch.emplace_back(op.make_initiator(ctx, genCont(op, idx++)));
+                return;
+            }
+        }
+
+        // keep ops started in order.
+        flush();
+        manual_initiate(op, ctx, genCont(op, idx++));
+    });
+
+    flush();
+}
+
+
 } // namespace dsk
@@ -1,27 +1,168 @@
 #pragma once
 
+#include <dsk/inplace_stop_source.hpp>
 #include <dsk/util/concepts.hpp>
 #include <dsk/util/function.hpp>
 #include <optional>
+#include <variant>
 #include <stop_token>
 
 
 namespace dsk{
 
 
-template<class T> concept _stop_source_ = _no_cvref_same_as_<T, std::stop_source>;
-template<class T> concept _stop_token_  = _no_cvref_same_as_<T, std::stop_token>;
+class any_stop_token;
+class any_stop_source;
+
+
+template<class T> concept _stop_source_ = _no_cvref_same_as_<T, std::stop_source>
+                                       || _no_cvref_same_as_<T, inplace_stop_source>
+                                       || _no_cvref_same_as_<T, any_stop_source>;
+
+template<class T> concept _stop_token_  = _no_cvref_same_as_<T, std::stop_token>
+                                       || _no_cvref_same_as_<T, inplace_stop_token>
+                                       || _no_cvref_same_as_<T, any_stop_token>;
 
 template<class T>
-concept _stop_source_or_ref_wrap_ = _stop_source_<T> || _ref_wrap_of_<T, std::stop_source>;
+concept _stop_source_or_ref_wrap_ = _stop_source_<T>
+                                 || _ref_wrap_of_<T, std::stop_source>
+                                 || _ref_wrap_of_<T, inplace_stop_source>
+                                 || _ref_wrap_of_<T, any_stop_source>;
 
 
-[[nodiscard]] auto   get_stop_token(std::stop_source const& s) noexcept { return s.get_token(); }
-[[nodiscard]] auto&& get_stop_token(_stop_token_ auto&&     t) noexcept { return DSK_FORWARD(t); }
+[[nodiscard]] auto   get_stop_token(_stop_source_ auto const& s) noexcept { return s.get_token(); }
+[[nodiscard]] auto&& get_stop_token(_stop_token_  auto&&      t) noexcept { return DSK_FORWARD(t); }
 
 template<class T> concept _stop_obj_ = requires(T t){ dsk::get_stop_token(t); };
 
 
+// Either a std::stop_token or an inplace_stop_token.
+class any_stop_token
+{
+    std::stop_token    _st;
+    inplace_stop_token _ist;
+
+public:
+    any_stop_token() = default;
+    any_stop_token(std::stop_token t) noexcept : _st(mut_move(t)) {}
+    any_stop_token(inplace_stop_token t) noexcept : _ist(t) {}
+
+    bool is_inplace() const noexcept { return _ist.stop_possible(); }
+
+    auto const&     std_token() const noexcept { return _st; }
+    auto const& inplace_token() const noexcept { return _ist; }
+
+    bool stop_requested() const noexcept { return is_inplace() ? _ist.stop_requested() : _st.stop_requested(); }
+    bool  stop_possible() const noexcept { return is_inplace() || _st.stop_possible(); }
+};
+
+
+// Either a std::stop_source or a reference to an inplace_stop_source,
+// so a task can be run with either one without allocating.
+// Copies refer to the same stop state.
+class any_stop_source
+{
+    std::stop_source     _ss{std::nostopstate};
+    inplace_stop_source* _iss = nullptr;
+
+public:
+    any_stop_source() = default;
+    any_stop_source(std::nostopstate_t) noexcept {}
+    any_stop_source(std::stop_source s) noexcept : _ss(mut_move(s)) {}
+    any_stop_source(inplace_stop_source& s) noexcept : _iss(std::addressof(s)) {}
+    any_stop_source(inplace_stop_source&&) = delete;
+
+    bool is_inplace() const noexcept { return _iss != nullptr; }
+
+    bool stop_requested() const noexcept { return _iss ? _iss->stop_requested() : _ss.stop_requested(); }
+    bool  stop_possible() const noexcept { return _iss || _ss.stop_possible(); }
+    bool   request_stop()       noexcept { return _iss ? _iss->request_stop() : _ss.request_stop(); }
+
+    any_stop_token get_token() const noexcept
+    {
+        if(_iss) return _iss->get_token();
+        else     return _ss.get_token();
+    }
+};
+
+
+// std::stop_callback or inplace_stop_callback, depending on the token.
+template<class F>
+class any_stop_callback
+{
+    std::variant<std::monostate, std::stop_callback<F>, inplace_stop_callback<F>> _cb;
+
+public:
+    using callback_type = F;
+
+    template<class C>
+    any_stop_callback(std::stop_token const& t, C&& f)
+    {
+        _cb.template emplace<1>(t, DSK_FORWARD(f));
+    }
+
+    template<class C>
+    any_stop_callback(inplace_stop_token const& t, C&& f)
+    {
+        _cb.template emplace<2>(t, DSK_FORWARD(f));
+    }
+
+    template<class C>
+    any_stop_callback(any_stop_token const& t, C&& f)
+    {
+        if(t.is_inplace()) _cb.template emplace<2>(t.inplace_token(), DSK_FORWARD(f));
+        else               _cb.template emplace<1>(t.std_token(), DSK_FORWARD(f));
+    }
+
+    any_stop_callback(any_stop_callback const&) = delete;
+    any_stop_callback& operator=(any_stop_callback const&) = delete;
+};
+
+template<class F>
+any_stop_callback(auto, F) -> any_stop_callback<F>;
+
+
+// Bridge to external APIs requiring a std::stop_token.
+// For an inplace token, a std::stop_source is created and stopped along with it,
+// otherwise the token is used as is, no allocation.
+// Should outlive the use of get_token().
+class std_stop_token_bridge
+{
+    std::stop_source _ss{std::nostopstate};
+    std::stop_token  _st;
+
+    struct request_stop_t
+    {
+        std::stop_source* ss;
+        void operator()() const noexcept { ss->request_stop(); }
+    };
+
+    std::optional<inplace_stop_callback<request_stop_t>> _scb;
+
+public:
+    explicit std_stop_token_bridge(_stop_obj_ auto const& s)
+    {
+        any_stop_token t = get_stop_token(s);
+
+        if(t.is_inplace())
+        {
+            _ss = std::stop_source();
+            _st = _ss.get_token();
+            _scb.emplace(t.inplace_token(), request_stop_t(std::addressof(_ss)));
+        }
+        else
+        {
+            _st = t.std_token();
+        }
+    }
+
+    std_stop_token_bridge(std_stop_token_bridge const&) = delete;
+    std_stop_token_bridge& operator=(std_stop_token_bridge const&) = delete;
+
+    auto const& get_token() const noexcept { return _st; }
+};
+
+
 // once set, cannot be moved/copied.
 template<class T>
 class once_optional
@@ -75,11 +216,12 @@ public:
 };
 
 
+// Works with any stop token, inplace_stop_token is registered without allocation.
 template<class F = unique_function<void()>>
 class optional_stop_callback_t
-    : public once_optional<std::stop_callback<F>>
+    : public once_optional<any_stop_callback<F>>
 {
-    using base = once_optional<std::stop_callback<F>>;
+    using base = once_optional<any_stop_callback<F>>;
 
 public:
     auto& emplace(_stop_obj_ auto&& s, auto&& f)
@@ -87,7 +229,7 @@ public:
         return base::emplace(get_stop_token(DSK_FORWARD(s)), DSK_FORWARD(f));
     }
 
-    void emplace_if_stop_possible(std::stop_source const& s, auto&& f)
+    void emplace_if_stop_possible(_stop_source_ auto const& s, auto&& f)
     {
         if(s.stop_possible())
         {
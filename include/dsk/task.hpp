@@ -1,6 +1,7 @@
 #pragma once
 
 #include <dsk/config.hpp>
+#include <dsk/trace.hpp>
 #include <dsk/expected.hpp>
 #include <dsk/optional.hpp>
 #include <dsk/awaitables.hpp>
@@ -12,6 +13,7 @@
 #include <dsk/util/tuple.hpp>
 #include <dsk/util/handle.hpp>
 #include <dsk/util/allocator.hpp>
+#include <dsk/util/frame_arena.hpp>
 #include <memory>
 #include <functional>
 #include <stop_token>
@@ -51,12 +53,12 @@ constexpr        get_resumer_t        get_resumer() noexcept { return {}; }
 
 struct [[nodiscard]] set_stop_source_t
 {
-    std::stop_source const& s;
+    any_stop_source s;
 };
 
-auto set_stop_source(std::stop_source const& s) noexcept
+auto set_stop_source(any_stop_source s) noexcept
 {
-    return set_stop_source_t(s);
+    return set_stop_source_t(mut_move(s));
 }
 
 
@@ -107,6 +109,20 @@ auto add_parent_cleanup(_async_op_ auto&& op) noexcept
 }
 
 
+// Make a frame_arena of capacity bytes owned by current coroutine,
+// frames of its descendants are carved from it.
+// Only for task/generator<T, E, frame_arena_allocator<...>>.
+struct [[nodiscard]] use_frame_arena_t
+{
+    size_t capacity;
+};
+
+constexpr auto use_frame_arena(size_t capacity = frame_arena<>::default_capacity) noexcept
+{
+    return use_frame_arena_t(capacity);
+}
+
+
 template<class E>
 struct [[nodiscard]] coro_throw_t
 {
@@ -207,7 +223,7 @@ protected:
 
     coro_promise_base* _parent = nullptr;
     continuation       _cont;
-    std::stop_source   _ss{std::nostopstate};
+    any_stop_source    _ss;
     any_resumer        _resumer; // just for async ctx, not this->_cont.
 
     lazy_async_op_group_stack
@@ -219,11 +235,18 @@ protected:
     _cleanupGpStack{coro_cleanup_async_ctx(*this)};
 
 public:
+    coro_promise_base() noexcept
+    {
+        trace(trace_coro_create, this);
+    }
+
     // coroutine has many exist points, but cleanup can be done only at those awaitable suspend points.
     ~coro_promise_base()
     {
         _cleanupGpStack.pop_untill_non_empty();
         DSK_RELEASE_ASSERT(_cleanupGpStack.empty());
+
+        trace(trace_coro_destroy, this);
     }
 
     auto get_async_ctx() noexcept
@@ -275,6 +298,33 @@ public:
 };
 
 
+// Make the arena of Scope current while the coroutine is running,
+// by switching it on each suspend/resume of awaiter A.
+template<class Scope, class A>
+struct [[nodiscard]] frame_arena_awaiter
+{
+    Scope& scope;
+    A      a;
+
+    constexpr bool await_ready() noexcept(noexcept(a.await_ready()))
+    {
+        return a.await_ready();
+    }
+
+    constexpr decltype(auto) await_suspend(auto h) noexcept(noexcept(a.await_suspend(h)))
+    {
+        scope.deactivate(); // a.await_suspend() may resume others or destroy this coroutine.
+        return a.await_suspend(h);
+    }
+
+    constexpr decltype(auto) await_resume() noexcept(noexcept(a.await_resume()))
+    {
+        scope.activate();
+        return a.await_resume();
+    }
+};
+
+
 template<class Host, class Alloc, bool IsGen>
 class coro_promise : public coro_promise_base
 {
@@ -318,7 +368,32 @@ public:
     }
 
 private:
+    static constexpr bool uses_frame_arena = requires{ typename allocator_type::frame_arena_type; };
+
     Host* _ho = nullptr;
+    DSK_DEF_MEMBER_IF(uses_frame_arena, frame_arena_scope<typename allocator_type::frame_arena_type>) _fa;
+
+    // mk() should return the awaiter as prvalue, so no move of it is needed.
+    auto frame_arena_scoped(auto&& mk)
+    {
+        if constexpr(uses_frame_arena) return frame_arena_awaiter<decltype(_fa), decltype(mk())>{_fa, mk()};
+        else                           return mk();
+    }
+
+    // Awaiter of a suspend point, with frame arena switching and tracing if enabled.
+    template<bool TraceSuspend = true>
+    auto suspend_point(auto&& mk)
+    {
+        if constexpr(tracing_enabled)
+        {
+            using awaiter_type = decltype(frame_arena_scoped(mk));
+            return trace_awaiter<awaiter_type, TraceSuspend>{static_cast<coro_promise_base const*>(this), frame_arena_scoped(mk)};
+        }
+        else
+        {
+            return frame_arena_scoped(mk);
+        }
+    }
 
 public:
     Host& host() noexcept { DSK_ASSERT(_ho); return *_ho; }
@@ -332,6 +407,8 @@ public:
     // if error raises in cleanup, it will overwrite exisitng result;
     std::coroutine_handle<> initiate_cleanup(auto& cleanupOp)
     {
+        trace(trace_coro_cleanup, static_cast<coro_promise_base const*>(this));
+
         bool initiated = initiate(cleanupOp, this->get_async_ctx(), [&]() mutable
         {
             if(is_failed(cleanupOp))
@@ -380,7 +457,7 @@ public:
         return ho;
     }
 
-    auto initial_suspend() noexcept { return std::suspend_always(); }
+    auto initial_suspend() noexcept { return suspend_point<false>([](){ return std::suspend_always(); }); }
 
     auto final_suspend() noexcept
     {
@@ -405,9 +482,12 @@ public:
     {
         _ho->emplace_val(DSK_FORWARD(v));
 
-        return suspend_by_invoke([this]()
+        return suspend_point([this]()
         {
-            return _cont.tail_resume();
+            return suspend_by_invoke([this]()
+            {
+                return _cont.tail_resume();
+            });
         });
     }
 
@@ -451,7 +531,7 @@ public:
     template<class F>
     auto await_transform(create_stop_callback_t<F>&& t) noexcept
     {
-        return resume_by_invoke([&](){ return std::stop_callback(_ss.get_token(), DSK_FORWARD(t.f)); });
+        return resume_by_invoke([&](){ return any_stop_callback<std::decay_t<F>>(_ss.get_token(), DSK_FORWARD(t.f)); });
     }
 
     template<class F>
@@ -477,6 +557,19 @@ public:
         return resume_by_invoke([&](){ return this->add_parent_cleanup(DSK_FORWARD(t.op)); });
     }
 
+    auto await_transform(use_frame_arena_t t) noexcept
+    {
+        static_assert(uses_frame_arena, "Alloc should be frame_arena_allocator<...>");
+
+        return resume_by_invoke([this, t]()
+        {
+            if(auto* a = allocator_type::frame_arena_type::create(t.capacity))
+            {
+                _fa.reset(a);
+            }
+        });
+    }
+
     auto await_transform(get_async_ctx_t) noexcept
     {
         return resume_by_invoke([&](){ return this->get_async_ctx(); });
@@ -496,9 +589,12 @@ public:
     template<class E>
     auto await_transform(coro_throw_t<E>&& t) noexcept
     {
-        return suspend_by_invoke([&, cleanupOp = cleanup()]() mutable
+        return suspend_point([&]()
         {
-            return initiate_throw(DSK_FORWARD(t.err), cleanupOp);
+            return suspend_by_invoke([&, cleanupOp = cleanup()]() mutable
+            {
+                return initiate_throw(DSK_FORWARD(t.err), cleanupOp);
+            });
         });
     }
 
@@ -506,18 +602,21 @@ public:
     template<class ArgTuple>
     auto await_transform(coro_return_t<ArgTuple>&& t) noexcept
     {
-        return suspend_by_invoke([&, cleanupOp = cleanup()]() mutable
+        return suspend_point([&]()
         {
-            return apply_elms(t.args, [&](auto&&... args)
+            return suspend_by_invoke([&, cleanupOp = cleanup()]() mutable
             {
-                if constexpr(IsGen)
+                return apply_elms(t.args, [&](auto&&... args)
                 {
-                    static_assert(sizeof...(args) == 0, "generator shouldn't return value");
-                }
+                    if constexpr(IsGen)
+                    {
+                        static_assert(sizeof...(args) == 0, "generator shouldn't return value");
+                    }
 
-                _ho->emplace_val(DSK_FORWARD(args)...); // for generator, a default constructed optional, which is null, to end next() loop.
+                    _ho->emplace_val(DSK_FORWARD(args)...); // for generator, a default constructed optional, which is null, to end next() loop.
 
-                return initiate_cleanup(cleanupOp);
+                    return initiate_cleanup(cleanupOp);
+                });
             });
         });
     }
@@ -548,7 +647,7 @@ public:
             }
         };
 
-        return errorable_awaiter(DSK_FORWARD(t), cleanup());
+        return suspend_point([&](){ return errorable_awaiter(DSK_FORWARD(t), cleanup()); });
     }
 
     auto await_transform(_async_op_ auto&& op) noexcept
@@ -573,7 +672,7 @@ public:
             }
         };
 
-        return async_op_awaiter(op);
+        return suspend_point([&](){ return async_op_awaiter(op); });
     }
 };
 
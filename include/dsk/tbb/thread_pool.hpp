@@ -1,6 +1,7 @@
 #pragma once
 
 #include <dsk/config.hpp>
+#include <dsk/scheduler_stats.hpp>
 #include <dsk/util/debug.hpp>
 #include <dsk/tbb/allocator.hpp>
 #include <tbb/task_arena.h>
@@ -19,6 +20,25 @@ class tbb_thread_pool
     tbb::task_group_context      _ctx{tbb::task_group_context::isolated}; // for canceling jobs
     tbb::task_group              _tg{_ctx}; // dispatching and tracking jobs
     tbb::task_arena::constraints _opts;
+    scheduler_stats_recorder     _stats; // only used if scheduler_stats_enabled
+
+    // Worker index is arena slot, which may be used by different threads over time.
+    // Posts from a job are attributed to the slot running it.
+    void post_impl(auto&& f)
+    {
+        // tbb only uses functor's const operator()
+        if constexpr(requires{ std::as_const(f)(); })
+        {
+            _tg.run(DSK_FORWARD(f));
+        }
+        else
+        {
+            _tg.run([f = DSK_FORWARD(f)]()
+            {
+                const_cast<DSK_NO_CV_T(f)&>(f)();
+            });
+        }
+    }
 
 public:
     tbb_thread_pool(tbb_thread_pool const&) = delete;
@@ -82,6 +102,11 @@ public:
         DSK_ASSERT(_opts.max_concurrency);
 
         _arena.initialize(_opts, reservedForMasters, priority);
+
+        if constexpr(scheduler_stats_enabled)
+        {
+            _stats.reset(static_cast<size_t>(_arena.max_concurrency()));
+        }
     }
 
     void restart(unsigned reservedForMasters = 1,
@@ -95,21 +120,31 @@ public:
     {
         DSK_ASSERT(started());
 
-        _arena.execute([&]()
+        if constexpr(scheduler_stats_enabled)
         {
-            // tbb only uses functor's const operator()
-            if constexpr(requires{ std::as_const(f)(); })
-            {
-                _tg.run(DSK_FORWARD(f));
-            }
-            else
+            _stats.on_post();
+            _stats.on_pending_add();
+
+            _arena.execute([&]()
             {
-                _tg.run([f = DSK_FORWARD(f)]()
+                post_impl([this, f = DSK_FORWARD(f), t = scheduler_stats_recorder::now()]() mutable
                 {
-                    const_cast<DSK_NO_CV_T(f)&>(f)();
+                    size_t w = static_cast<size_t>(tbb::this_task_arena::current_thread_index()) % _stats.size();
+
+                    _stats.bind_worker(w);
+                    _stats.on_execute_any(w, t);
+                    _stats.on_pending_done();
+                    f();
                 });
-            }
-        });
+            });
+        }
+        else
+        {
+            _arena.execute([&]()
+            {
+                post_impl(DSK_FORWARD(f));
+            });
+        }
 
         //_arena.execute([&]() mutable { _tg.run(_tg.defer(DSK_FORWARD(f))); });
 
@@ -148,6 +183,14 @@ public:
             _arena.execute([this](){ _tg.wait(); }); // _tg.wait() also resets context cancellation state.
         }
     }
+
+    // Empty if DSK_ENABLE_SCHEDULER_STATS is not defined.
+    // Stats are reset on start(). Steals and parks are not observable, queue depth is tracked as total pending jobs.
+    scheduler_stats stats() const
+    {
+        if constexpr(scheduler_stats_enabled) return _stats.snapshot();
+        else                                  return {};
+    }
 };
 
 
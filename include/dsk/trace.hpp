@@ -0,0 +1,389 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/vector.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/thread.hpp>
+#include <dsk/util/mutex.hpp>
+#include <dsk/util/spsc_queue.hpp>
+#include <dsk/util/condition_variable.hpp>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+    #include <intrin.h>
+#endif
+
+
+// Async task tracing is compiled out unless DSK_ENABLE_TRACING is defined.
+// When compiled in, nothing is recorded until tracer::instance().start(path) is called:
+//
+//      tracer::instance().start("app.trace.json");
+//      ...
+//      tracer::instance().stop();
+//
+// Events are pushed to per-thread lock-free ring buffers, and a background thread converts them to
+// Chrome trace event JSON, which can be opened in chrome://tracing or https://ui.perfetto.dev.
+// Events are dropped if a ring buffer is full, see tracer::dropped().
+
+
+namespace dsk{
+
+
+#if defined(DSK_ENABLE_TRACING)
+    inline constexpr bool tracing_enabled = true;
+#else
+    inline constexpr bool tracing_enabled = false;
+#endif
+
+
+enum trace_event_e : uint8_t
+{
+    trace_coro_create,  // id: promise
+    trace_coro_resume,  // id: promise, including initial resume
+    trace_coro_suspend, // id: promise, including DSK_RETURN/DSK_THROW
+    trace_coro_cleanup, // id: promise, async cleanup starts
+    trace_coro_destroy, // id: promise
+    trace_post,         // id: scheduler, a continuation is posted by any_resumer
+    trace_job_begin,    // id: scheduler, a worker starts a job
+    trace_job_end       // id: scheduler
+};
+
+
+struct trace_record
+{
+    uint64_t      ts = 0; // trace_clock_now()
+    void const*   id = nullptr;
+    trace_event_e ev = trace_coro_create;
+};
+
+
+// tsc on x86, converted to time by the flusher, otherwise steady clock in ns.
+inline uint64_t trace_clock_now() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+
+struct trace_thread_buffer
+{
+    bounded_spsc_queue<trace_record> q;
+    uint32_t                         tid;
+    atomic<bool>                     exited{false};
+
+    trace_thread_buffer(size_t cap, uint32_t id) : q(cap), tid(id) {}
+};
+
+// marks buffer exited on thread exit, so flusher can release it once drained.
+struct trace_thread_slot
+{
+    std::shared_ptr<trace_thread_buffer> b;
+    uint32_t                             gen = 0;
+
+    ~trace_thread_slot()
+    {
+        if(b) b->exited.store(true, memory_order_release);
+    }
+};
+
+
+class tracer
+{
+    using clock         = std::chrono::steady_clock;
+    using thread_buffer = trace_thread_buffer;
+
+    inline static atomic<bool>                   s_on{false};
+    inline static atomic<uint32_t>               s_gen{0}; // sessions started, buffers are recreated for each
+    inline static thread_local trace_thread_slot tl_slot;
+
+    mutex                                  _mtx;
+    condition_variable                     _cv;
+    vector<std::shared_ptr<thread_buffer>> _bufs;
+    uint32_t                               _nextTid = 1;
+    size_t                                 _bufCap = 0;
+    bool                                   _stopping = false;
+    thread                                 _flusher;
+    atomic<size_t>                         _dropped{0};
+
+    // flusher only
+    std::FILE* _out = nullptr;
+    bool       _first = true;
+    uint64_t   _tick0 = 0;
+    clock::time_point _t0;
+
+    thread_buffer* register_thread()
+    {
+        lock_guard lg(_mtx);
+
+        if(! s_on.load(memory_order_relaxed))
+        {
+            return nullptr;
+        }
+
+        if(tl_slot.b)
+        {
+            tl_slot.b->exited.store(true, memory_order_release); // from previous session
+        }
+
+        tl_slot.b   = std::make_shared<thread_buffer>(_bufCap, _nextTid++);
+        tl_slot.gen = s_gen.load(memory_order_relaxed);
+
+        _bufs.emplace_back(tl_slot.b);
+        return tl_slot.b.get();
+    }
+
+    // ns from session start per tick, by elapsed time of both clocks.
+    double ns_per_tick() const noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        uint64_t ticks = trace_clock_now() - _tick0;
+        auto     ns    = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _t0).count();
+
+        return ticks ? static_cast<double>(ns) / static_cast<double>(ticks) : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+
+    void write_record(trace_record const& r, uint32_t tid, double nsPerTick)
+    {
+        static constexpr char const* fmts[] =
+        {
+            R"({"name":"coro","cat":"coro","ph":"b","id":"%p","pid":1,"tid":%u,"ts":%.3f})",
+            R"({"name":"run","cat":"coro","ph":"B","pid":1,"tid":%u,"ts":%.3f,"args":{"coro":"%p"}})",
+            R"({"name":"run","cat":"coro","ph":"E","pid":1,"tid":%u,"ts":%.3f,"args":{"coro":"%p"}})",
+            R"({"name":"cleanup","cat":"coro","ph":"n","id":"%p","pid":1,"tid":%u,"ts":%.3f})",
+            R"({"name":"coro","cat":"coro","ph":"e","id":"%p","pid":1,"tid":%u,"ts":%.3f})",
+            R"({"name":"post","cat":"sched","ph":"i","s":"t","pid":1,"tid":%u,"ts":%.3f,"args":{"sch":"%p"}})",
+            R"({"name":"job","cat":"sched","ph":"B","pid":1,"tid":%u,"ts":%.3f,"args":{"sch":"%p"}})",
+            R"({"name":"job","cat":"sched","ph":"E","pid":1,"tid":%u,"ts":%.3f,"args":{"sch":"%p"}})"
+        };
+
+        double us = static_cast<double>(r.ts - _tick0) * nsPerTick / 1000.0;
+
+        std::fputs(_first ? "\n" : ",\n", _out);
+        _first = false;
+
+        switch(r.ev)
+        {
+            case trace_coro_create :
+            case trace_coro_cleanup:
+            case trace_coro_destroy: std::fprintf(_out, fmts[r.ev], r.id, tid, us); break;
+            default                : std::fprintf(_out, fmts[r.ev], tid, us, r.id); break;
+        }
+    }
+
+    // drain all buffers, release those of exited threads.
+    void flush()
+    {
+        vector<std::shared_ptr<thread_buffer>> bufs;
+
+        {
+            lock_guard lg(_mtx);
+            bufs = _bufs;
+        }
+
+        double nsPerTick = ns_per_tick();
+
+        for(auto& b : bufs)
+        {
+            bool exited = b->exited.load(memory_order_acquire);
+
+            while(auto r = b->q.try_pop())
+            {
+                write_record(*r, b->tid, nsPerTick);
+            }
+
+            if(exited)
+            {
+                lock_guard lg(_mtx);
+                std::erase(_bufs, b);
+            }
+        }
+
+        std::fflush(_out);
+    }
+
+    void flusher_run(clock::duration interval)
+    {
+        unique_lock lk(_mtx);
+
+        while(! _stopping)
+        {
+            _cv.wait_for(lk, interval);
+
+            lk.unlock();
+            flush();
+            lk.lock();
+        }
+    }
+
+public:
+    tracer() = default;
+    tracer(tracer const&) = delete;
+    tracer& operator=(tracer const&) = delete;
+
+    ~tracer() { stop(); }
+
+    static tracer& instance()
+    {
+        static tracer t;
+        return t;
+    }
+
+    static bool active() noexcept { return s_on.load(memory_order_relaxed); }
+
+    // Start a session writing to file at path, return false if already started or failed to open the file.
+    // Each thread gets a ring buffer of perThreadCapacity records on its first event.
+    bool start(char const* path,
+               std::chrono::milliseconds flushInterval = std::chrono::milliseconds(100),
+               size_t perThreadCapacity = 64 * 1024)
+    {
+        lock_guard lg(_mtx);
+
+        if(s_on.load(memory_order_relaxed))
+        {
+            return false;
+        }
+
+        _out = std::fopen(path, "wb");
+
+        if(! _out)
+        {
+            return false;
+        }
+
+        std::fputs(R"({"displayTimeUnit":"ns","traceEvents":[)", _out);
+
+        _first    = true;
+        _tick0    = trace_clock_now();
+        _t0       = clock::now();
+        _bufCap   = perThreadCapacity;
+        _stopping = false;
+        _dropped.store(0, memory_order_relaxed);
+
+        for(auto& b : _bufs)
+        {
+            b->exited.store(true, memory_order_release);
+        }
+
+        _bufs.clear();
+        s_gen.fetch_add(1, memory_order_relaxed);
+
+        s_on.store(true, memory_order_release);
+        _flusher = thread([this, flushInterval](){ flusher_run(flushInterval); });
+        return true;
+    }
+
+    // Stop recording, write remaining events and close the file.
+    void stop()
+    {
+        {
+            lock_guard lg(_mtx);
+
+            if(! s_on.load(memory_order_relaxed))
+            {
+                return;
+            }
+
+            s_on.store(false, memory_order_release);
+            _stopping = true;
+        }
+
+        _cv.notify_all();
+        _flusher.join();
+
+        flush(); // events recorded while flusher exiting
+
+        std::fputs("\n]}\n", _out);
+        std::fclose(_out);
+        _out = nullptr;
+    }
+
+    // events dropped due to full ring buffers in current or last session.
+    size_t dropped() const noexcept { return _dropped.load(memory_order_relaxed); }
+
+    void record(trace_event_e ev, void const* id) noexcept
+    {
+        if(! s_on.load(memory_order_relaxed))
+        {
+            return;
+        }
+
+        thread_buffer* b = tl_slot.b.get();
+
+        if(! b || tl_slot.gen != s_gen.load(memory_order_relaxed)) [[unlikely]]
+        {
+            if(! (b = register_thread()))
+            {
+                return;
+            }
+        }
+
+        if(! b->q.try_push(trace_record{trace_clock_now(), id, ev}))
+        {
+            _dropped.fetch_add(1, memory_order_relaxed);
+        }
+    }
+};
+
+
+// Record an event if tracing is compiled in and a session is active, otherwise a no-op.
+inline void trace(trace_event_e ev, void const* id) noexcept
+{
+    if constexpr(tracing_enabled)
+    {
+        tracer::instance().record(ev, id);
+    }
+}
+
+
+// Trace suspend/resume of coroutine p, by wrapping awaiter A at its suspend points.
+// Resume is only recorded if suspended, as await_suspend() isn't called when await_ready() is true.
+template<class A, bool TraceSuspend = true>
+struct [[nodiscard]] trace_awaiter
+{
+    void const* p;
+    A           a;
+    bool        suspended = false;
+
+    constexpr bool await_ready() noexcept(noexcept(a.await_ready()))
+    {
+        return a.await_ready();
+    }
+
+    constexpr decltype(auto) await_suspend(auto h) noexcept(noexcept(a.await_suspend(h)))
+    {
+        // a.await_suspend() may resume or destroy this coroutine on other thread.
+        suspended = true;
+
+        if constexpr(TraceSuspend)
+        {
+            trace(trace_coro_suspend, p);
+        }
+
+        return a.await_suspend(h);
+    }
+
+    constexpr decltype(auto) await_resume() noexcept(noexcept(a.await_resume()))
+    {
+        if(suspended)
+        {
+            trace(trace_coro_resume, p);
+        }
+
+        return a.await_resume();
+    }
+};
+
+
+} // namespace dsk
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <dsk/async_op.hpp>
+#include <dsk/start_on.hpp>
 #include <dsk/util/ct.hpp>
 #include <dsk/util/debug.hpp>
 #include <dsk/util/tuple.hpp>
 #include <dsk/util/atomic.hpp>
 #include <dsk/util/vector.hpp>
+#include <dsk/util/function.hpp>
+#include <algorithm>
+#include <optional>
 
 
 namespace dsk{
@@ -58,16 +62,16 @@ struct [[nodiscard]] until_all_done_op
 
             _cont = DSK_FORWARD(cont);
 
-            uforeach(_ops, [&](auto& op)
+            manual_initiate_each(_ops, ctx, [this](auto&, size_t)
             {
-                manual_initiate(op, ctx, [this/*, ctx*/]() mutable
+                return [this/*, ctx*/]() mutable
                 {
                     if(atomic_ref(_n).fetch_sub(1, memory_order_acq_rel) == 1)
                     {
                         //resume(mut_move(_cont), ctx);
                         mut_move(_cont)();
                     }
-                });
+                };
             });
         }
 
@@ -170,7 +174,7 @@ struct [[nodiscard]] until_if_op
     DSK_DEF_MEMBER_IF(nElm > 0,                    int) _firstIdx = -1;
     DSK_DEF_MEMBER_IF(nElm > 1,                    int) _n = std::size(_ops); // atomic_ref, as _n is only used after this op is on its final address, while atomic is not movable. 
     DSK_DEF_MEMBER_IF(nElm > 1,           continuation) _cont;
-    DSK_DEF_MEMBER_IF(nElm > 1,       std::stop_source) _opSs{std::nostopstate};
+    DSK_DEF_MEMBER_IF(nElm > 1,    inplace_stop_source) _opSs;
     DSK_DEF_MEMBER_IF(nElm > 1, optional_stop_callback) _scb; // must be last defined
 
     void set_err_from_first_idx()
@@ -240,7 +244,7 @@ struct [[nodiscard]] until_if_op
             }
 
             _cont = DSK_FORWARD(cont);
-            _opSs = std::stop_source();
+            _opSs.reset();
 
             // _cont may be immediately resumed in manual_initiate,
             // which destroy this object, so must prepare everything ahead.
@@ -253,11 +257,10 @@ struct [[nodiscard]] until_if_op
             }
 
             auto ssCtx = make_async_ctx(ctx, std::ref(_opSs));
-            int idx = 0;
 
-            uforeach(_ops, [&](auto& op)
+            manual_initiate_each(_ops, ssCtx, [this](auto& op, size_t i)
             {
-                manual_initiate(op, ssCtx, [this, &op, idx = idx++/*, ssCtx*/]() mutable
+                return [this, &op, idx = static_cast<int>(i)/*, ssCtx*/]() mutable
                 {
                     if(_cancelCond(op))
                     {
@@ -275,7 +278,7 @@ struct [[nodiscard]] until_if_op
                         //resume(mut_move(_cont), ssCtx);
                         mut_move(_cont)();
                     }
-                });
+                };
             });
         }
 
@@ -512,6 +515,263 @@ auto until_all_succeeded(size_t n, _nullary_callable_ auto&& genOp)
 }
 
 
+enum bounded_until_e
+{
+    bounded_until_all_done,
+    bounded_until_all_succeeded_ordered,
+    bounded_until_all_succeeded_unordered,
+};
+
+// Generate an op by genOp(item) for each item of Items, with at most _maxInFlight ops running at the same time.
+// Each of _maxInFlight slots starts the next item as its op finishes,
+// so only _maxInFlight ops are alive at any time, no matter how many items there are.
+template<bounded_until_e Cat, std::ranges::random_access_range Items, class GenOp>
+struct [[nodiscard]] bounded_until_op
+{
+    using op_type     = decltype(std::declval<GenOp&>()(*std::ranges::begin(std::declval<Items&>())));
+    using result_type = DSK_CONDITIONAL_T(Cat == bounded_until_all_done,
+                                          decltype(dsk::take_result      <voidness_as_void>(std::declval<op_type&>())),
+                                          decltype(dsk::take_result_value<voidness_as_void>(std::declval<op_type&>())));
+
+    // The next op of a slot is started from the continuation of the previous one,
+    // which may be stored in and invoked in place by the previous op, e.g. res_queue waiters,
+    // so the previous op can't be destroyed there. Two storages are used in turn:
+    // ops[cur] is the running one, ops[cur ^ 1] is the previous one or unused.
+    struct slot_t
+    {
+        std::optional<op_type> ops[2];
+        unsigned               cur = 0;
+        size_t                 idx = 0;
+        bool                   initDone = false; // atomic_ref
+
+        op_type& op() noexcept { return *ops[cur]; }
+    };
+
+                       Items                              _items;
+    DSK_NO_UNIQUE_ADDR GenOp                              _genOp;
+                       size_t                             _maxInFlight = 1;
+                       errc                               _err{};
+                       size_t                             _next  = 0; // atomic_ref, next item to start
+                       size_t                             _nDone = 0; // atomic_ref, for unordered results
+                       size_t                             _nSlot = 0; // atomic_ref, running slots
+                       bool                               _failed = false;
+                       vector<slot_t>                     _slots;
+                       vector<std::optional<result_type>> _rs;
+                       unique_function<void(slot_t&)>     _runSlot; // run_slot() with ctx stored in it.
+                       continuation                       _cont;
+                       inplace_stop_source                _opSs;
+                       optional_stop_callback             _scb; // must be last defined
+
+    size_t item_count() const noexcept
+    {
+        return static_cast<size_t>(std::ranges::size(_items));
+    }
+
+    // return item_count() if no more item should be started.
+    size_t claim_next() noexcept
+    {
+        if(_opSs.stop_requested())
+        {
+            return item_count();
+        }
+
+        return std::min(atomic_ref(_next).fetch_add(1, memory_order_relaxed), item_count());
+    }
+
+    void on_op_done(slot_t& s)
+    {
+        if constexpr(Cat != bounded_until_all_done)
+        {
+            if(dsk::is_failed(s.op()))
+            {
+                if(_opSs.request_stop())
+                {
+                    _failed = true;
+                }
+
+                return;
+            }
+        }
+
+        size_t i = s.idx;
+
+        if constexpr(Cat == bounded_until_all_succeeded_unordered)
+        {
+            i = atomic_ref(_nDone).fetch_add(1, memory_order_relaxed);
+        }
+
+        if constexpr(Cat == bounded_until_all_done) _rs[i].emplace(dsk::take_result      <voidness_as_void>(s.op()));
+        else                                        _rs[i].emplace(dsk::take_result_value<voidness_as_void>(s.op()));
+    }
+
+    void on_all_done()
+    {
+        if(_failed)
+        {
+            _err = errc::failed;
+        }
+        else if(std::ranges::any_of(_rs, [](auto& r){ return ! r.has_value(); })) // some items were not started
+        {
+            _err = errc::canceled;
+        }
+
+        //resume(mut_move(_cont), ssCtx);
+        mut_move(_cont)();
+    }
+
+    // Ops that complete inside manual_initiate() are looped here instead of recursing.
+    // They have returned from their continuations when looped, so can be replaced,
+    // while ops[s.cur] at entry may be the op whose continuation is calling this, so is kept.
+    void run_slot(slot_t& s, auto& ctx)
+    {
+        unsigned k = s.cur ^ 1;
+
+        for(;;)
+        {
+            size_t i = claim_next();
+
+            if(i == item_count())
+            {
+                if(atomic_ref(_nSlot).fetch_sub(1, memory_order_acq_rel) == 1)
+                {
+                    on_all_done();
+                }
+
+                return;
+            }
+
+            s.idx = i;
+            s.cur = k;
+            s.ops[k].emplace(_genOp(std::ranges::begin(_items)[i]));
+            atomic_ref(s.initDone).store(false, memory_order_relaxed);
+
+            // ctx isn't captured, as this continuation may be destroyed while running, see slot_t.
+            manual_initiate(s.op(), ctx, [this, &s]()
+            {
+                on_op_done(s);
+
+                // initiator has returned, so continue the slot here.
+                if(atomic_ref(s.initDone).exchange(true, memory_order_acq_rel))
+                {
+                    _runSlot(s);
+                }
+            });
+
+            // op not finished yet, the slot will be continued in its continuation.
+            if(! atomic_ref(s.initDone).exchange(true, memory_order_acq_rel))
+            {
+                return;
+            }
+        }
+    }
+
+    using is_async_op = void;
+
+    bool initiate(_async_ctx_ auto&& ctx, _continuation_ auto&& cont)
+    {
+        DSK_ASSERT(_maxInFlight > 0);
+
+        if(set_canceled_if_stop_requested(_err, ctx))
+        {
+            return false;
+        }
+
+        size_t n = item_count();
+
+        if(n == 0)
+        {
+            return false;
+        }
+
+        size_t k = std::min(_maxInFlight, n);
+
+        _rs.resize(n);
+        _slots = vector<slot_t>(k);
+        _nSlot = k;
+        _cont = DSK_FORWARD(cont);
+        _opSs.reset();
+
+        // _cont may be resumed in run_slot(), which destroy this object, so must prepare everything ahead.
+        if(stop_possible(ctx))
+        {
+            _scb.emplace(get_stop_token(ctx), [this]()
+            {
+                _opSs.request_stop();
+            });
+        }
+
+        // ctx is kept here rather than in continuations of slots, which are destroyed as slots move on.
+        _runSlot = [this, ssCtx = make_async_ctx(ctx, std::ref(_opSs))](slot_t& s) mutable
+        {
+            run_slot(s, ssCtx);
+        };
+
+        for(size_t i = 0; i < k; ++i)
+        {
+            _runSlot(_slots[i]);
+        }
+
+        return true;
+    }
+
+    constexpr bool is_failed() const noexcept
+    {
+        return has_err(_err);
+    }
+
+    // expected<vector<result_type>, errc>
+    constexpr auto take_result()
+    {
+        return gen_expected_if_no(_err, [this]()
+        {
+            vector<result_type> rs;
+            rs.reserve(_rs.size());
+
+            for(auto& r : _rs)
+            {
+                rs.emplace_back(mut_move(*r));
+            }
+
+            return rs;
+        });
+    }
+};
+
+
+// Like until_all_done(n, genOp), but the ops are generated by genOp(item) for each item of 'items',
+// and at most maxInFlight of them are running at the same time, the next one is started as one finishes.
+// If canceled, items not started yet are skipped and errc::canceled is returned.
+// If 'items' is an lvalue, it's referenced.
+// Result type: expected<vector<result_type_of_ops>, errc>, in order of 'items'.
+auto until_all_done_bounded(std::ranges::random_access_range auto&& items, size_t maxInFlight, auto&& genOp)
+{
+    return bounded_until_op<bounded_until_all_done, DSK_LREF_OR_VAL_T(items), DSK_DECAY_T(genOp)>
+    {
+        DSK_FORWARD(items), DSK_FORWARD(genOp), maxInFlight
+    };
+}
+
+// Like until_all_done_bounded(), but with until_all_succeeded() semantic:
+// if any op failed, no more op is started, unfinished ones are canceled and errc::failed is returned.
+// Result type: expected<vector<result_value_type_of_ops>, errc>, in order of 'items'.
+auto async_transform(std::ranges::random_access_range auto&& items, size_t maxInFlight, auto&& genOp)
+{
+    return bounded_until_op<bounded_until_all_succeeded_ordered, DSK_LREF_OR_VAL_T(items), DSK_DECAY_T(genOp)>
+    {
+        DSK_FORWARD(items), DSK_FORWARD(genOp), maxInFlight
+    };
+}
+
+// Same as async_transform(), but results are in order of completion.
+auto async_transform_unordered(std::ranges::random_access_range auto&& items, size_t maxInFlight, auto&& genOp)
+{
+    return bounded_until_op<bounded_until_all_succeeded_unordered, DSK_LREF_OR_VAL_T(items), DSK_DECAY_T(genOp)>
+    {
+        DSK_FORWARD(items), DSK_FORWARD(genOp), maxInFlight
+    };
+}
+
+
 // Until the op which cancelCond(op) is true, or the last op
 // R is the result type.
 // If R is blank_t, it will be deduced, so all op's results should be same. 
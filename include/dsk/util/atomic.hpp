@@ -1,5 +1,7 @@
 #pragma once
 
+#include <dsk/config.hpp>
+
 
 #if    !defined(DSK_USE_STD_ATOMIC)     \
     && !defined(DSK_USE_BOOST_ATOMIC)
@@ -62,3 +64,10 @@
     }
 
 #endif
+
+
+namespace dsk
+{
+    // std::hardware_destructive_interference_size is not reliable across compilers/flags.
+    inline constexpr size_t cache_line_size = 64;
+}
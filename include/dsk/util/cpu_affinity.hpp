@@ -0,0 +1,68 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <span>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <Windows.h>
+#elif defined(__linux__)
+    #include <sched.h>
+    #include <pthread.h>
+#endif
+
+
+namespace dsk{
+
+
+// Pin calling thread to the logical cpus.
+// Return false if failed or not supported on the platform.
+// NOTE: on windows, only cpus in the first processor group (cpu < 64) are supported.
+inline bool pin_this_thread_to_cpus(std::span<unsigned const> cpus) noexcept
+{
+    if(cpus.empty())
+        return false;
+
+#if defined(_WIN32)
+
+    DWORD_PTR mask = 0;
+
+    for(unsigned c : cpus)
+    {
+        if(c >= sizeof(DWORD_PTR) * 8)
+            return false;
+
+        mask |= DWORD_PTR(1) << c;
+    }
+
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+
+#elif defined(__linux__)
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for(unsigned c : cpus)
+    {
+        if(c >= CPU_SETSIZE)
+            return false;
+
+        CPU_SET(c, &set);
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+
+#else
+
+    return false;
+
+#endif
+}
+
+inline bool pin_this_thread_to_cpu(unsigned cpu) noexcept
+{
+    return pin_this_thread_to_cpus(std::span<unsigned const>(&cpu, 1));
+}
+
+
+} // namespace dsk
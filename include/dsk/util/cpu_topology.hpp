@@ -0,0 +1,248 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/vector.hpp>
+#include <dsk/util/thread.hpp>
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <filesystem>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <Windows.h>
+#elif defined(__linux__)
+    #include <sched.h>
+#endif
+
+
+namespace dsk{
+
+
+// Parse cpu list of linux sysfs, e.g. "0-3,8,10-11\n".
+// Return empty if malformed.
+inline vector<unsigned> parse_cpu_list(std::string_view s)
+{
+    vector<unsigned> cpus;
+
+    auto parseNum = [&](unsigned& n)
+    {
+        auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), n);
+
+        if(ec != std::errc())
+            return false;
+
+        s.remove_prefix(static_cast<size_t>(p - s.data()));
+        return true;
+    };
+
+    while(s.size() && s.back() <= ' ')
+    {
+        s.remove_suffix(1);
+    }
+
+    while(s.size())
+    {
+        unsigned b = 0, e = 0;
+
+        if(! parseNum(b))
+            return {};
+
+        e = b;
+
+        if(s.starts_with('-'))
+        {
+            s.remove_prefix(1);
+
+            if(! parseNum(e) || e < b)
+                return {};
+        }
+
+        for(unsigned c = b; c <= e; ++c)
+        {
+            cpus.emplace_back(c);
+        }
+
+        if(s.starts_with(','))
+        {
+            s.remove_prefix(1);
+        }
+        else if(s.size())
+        {
+            return {};
+        }
+    }
+
+    return cpus;
+}
+
+
+struct numa_node_info
+{
+    unsigned         id = 0; // os node id, may be not contiguous.
+    vector<unsigned> cpus;   // logical cpus of the node, sorted.
+};
+
+
+// NUMA nodes and their logical cpus.
+// Nodes are referred by index in nodes(), not by os id.
+// If topology can't be discovered, there is a single node with all cpus.
+class cpu_topology
+{
+    vector<numa_node_info> _nodes;
+    vector<unsigned>       _nodeOfCpu; // node index by cpu
+    vector<unsigned>       _cpusByNode;
+
+    static vector<unsigned> all_cpus()
+    {
+        vector<unsigned> cpus;
+
+#if defined(__linux__)
+        {
+            std::ifstream f("/sys/devices/system/cpu/online");
+            std::string   s;
+
+            if(std::getline(f, s))
+            {
+                cpus = parse_cpu_list(s);
+            }
+        }
+#endif
+
+        if(cpus.empty())
+        {
+            unsigned n = std::max(thread::hardware_concurrency(), 1u);
+
+            for(unsigned c = 0; c < n; ++c)
+            {
+                cpus.emplace_back(c);
+            }
+        }
+
+        return cpus;
+    }
+
+public:
+    // nodes with empty cpus are ignored.
+    explicit cpu_topology(vector<numa_node_info> nodes)
+    {
+        std::erase_if(nodes, [](auto& n){ return n.cpus.empty(); });
+        std::ranges::sort(nodes, {}, &numa_node_info::id);
+
+        if(nodes.empty())
+        {
+            nodes.emplace_back(0u, all_cpus());
+        }
+
+        _nodes = mut_move(nodes);
+
+        for(size_t i = 0; i < _nodes.size(); ++i)
+        {
+            auto& cpus = _nodes[i].cpus;
+
+            std::ranges::sort(cpus);
+
+            for(unsigned c : cpus)
+            {
+                if(c >= _nodeOfCpu.size())
+                {
+                    _nodeOfCpu.resize(c + 1, 0);
+                }
+
+                _nodeOfCpu[c] = static_cast<unsigned>(i);
+                _cpusByNode.emplace_back(c);
+            }
+        }
+    }
+
+    // Read nodes from /sys/devices/system/node on linux.
+    static cpu_topology discover()
+    {
+        vector<numa_node_info> nodes;
+
+#if defined(__linux__)
+        std::error_code ec;
+
+        for(auto& e : std::filesystem::directory_iterator("/sys/devices/system/node", ec))
+        {
+            std::string name = e.path().filename().string();
+            unsigned    id   = 0;
+
+            if(! name.starts_with("node"))
+                continue;
+
+            auto [p, err] = std::from_chars(name.data() + 4, name.data() + name.size(), id);
+
+            if(err != std::errc() || p != name.data() + name.size())
+                continue;
+
+            std::ifstream f(e.path() / "cpulist");
+            std::string   s;
+
+            if(std::getline(f, s))
+            {
+                nodes.emplace_back(id, parse_cpu_list(s));
+            }
+        }
+#endif
+
+        return cpu_topology(mut_move(nodes));
+    }
+
+    // Discovered once on first call.
+    static cpu_topology const& system()
+    {
+        static cpu_topology const t = discover();
+        return t;
+    }
+
+    size_t node_count() const noexcept { return _nodes.size(); }
+    size_t  cpu_count() const noexcept { return _cpusByNode.size(); }
+
+    auto const& nodes() const noexcept { return _nodes; }
+    auto const& node(size_t i) const noexcept { DSK_ASSERT(i < _nodes.size()); return _nodes[i]; }
+
+    // all cpus, grouped by node.
+    auto const& cpus_by_node() const noexcept { return _cpusByNode; }
+
+    // index of node cpu belongs to, 0 if unknown.
+    size_t node_of_cpu(unsigned cpu) const noexcept
+    {
+        return cpu < _nodeOfCpu.size() ? _nodeOfCpu[cpu] : 0;
+    }
+
+    // cpu calling thread is running on, -1 if not supported.
+    static int current_cpu() noexcept
+    {
+#if defined(_WIN32)
+        return static_cast<int>(GetCurrentProcessorNumber());
+#elif defined(__linux__)
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+    // index of node calling thread is running on, 0 if unknown.
+    size_t current_node() const noexcept
+    {
+        int c = current_cpu();
+        return c >= 0 ? node_of_cpu(static_cast<unsigned>(c)) : 0;
+    }
+
+    // Node of the i-th of n workers.
+    // Workers are split over nodes in proportion to their cpus, and workers of a node are contiguous.
+    size_t node_of_worker(size_t i, size_t n) const noexcept
+    {
+        DSK_ASSERT(i < n);
+
+        size_t c = (i * cpu_count()) / n; // i-th worker's share of cpus_by_node() starts here.
+        return node_of_cpu(_cpusByNode[c]);
+    }
+};
+
+
+} // namespace dsk
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/default_allocator.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/allocator.hpp>
+#include <new>
+#include <utility>
+
+
+namespace dsk{
+
+
+// Bump arena for coroutine frames of a structured call tree.
+//
+// Blocks are carved from one upfront allocated chunk and released in LIFO order.
+// A block freed out of order (e.g. children of until_all_xxx finishing in any order) is marked,
+// and reclaimed once blocks above it are all freed.
+//
+// The arena is reference counted by its owner, joined coroutines and live blocks,
+// so it stays valid even if a frame outlives the owner.
+//
+// Frames may be created and destroyed on different threads, the bump pointer is guarded by a spin lock,
+// which is mostly uncontended, as frames of a tree are usually created one after another.
+template<class Upstream = DSK_DEFAULT_ALLOCATOR<void>>
+class alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) frame_arena
+{
+public:
+    static constexpr size_t default_align    = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    static constexpr size_t default_capacity = 8 * 1024;
+
+private:
+    struct alignas(default_align) unit_t
+    {
+        unsigned char pad[default_align];
+    };
+
+    using unit_allocator = rebind_alloc<Upstream, unit_t>;
+
+    static_assert(is_stateless_allocator_v<unit_allocator>);
+
+    // trails each block, so the block below can be found when top is popped.
+    struct alignas(default_align) footer_t
+    {
+        size_t units; // of the block, including footer
+        bool   freed;
+    };
+
+    static_assert(sizeof(footer_t) == sizeof(unit_t));
+
+    atomic<size_t> _refs{1}; // owner + joined coroutines + live blocks
+    atomic<bool>   _locked{false};
+    size_t         _cap;     // in units
+    size_t         _top = 0; // in units
+
+    inline static thread_local frame_arena* tl_current = nullptr;
+
+    explicit frame_arena(size_t cap) noexcept
+        : _cap(cap)
+    {}
+
+    static constexpr size_t units_of(size_t bytes) noexcept
+    {
+        return (bytes + sizeof(unit_t) - 1) / sizeof(unit_t);
+    }
+
+    static constexpr size_t header_units() noexcept
+    {
+        return units_of(sizeof(frame_arena));
+    }
+
+    unit_t* data() noexcept
+    {
+        return reinterpret_cast<unit_t*>(this) + header_units();
+    }
+
+    footer_t* footer_below(size_t top) noexcept
+    {
+        return reinterpret_cast<footer_t*>(data() + top - 1);
+    }
+
+    void lock() noexcept
+    {
+        while(_locked.exchange(true, memory_order_acquire))
+        {
+            while(_locked.load(memory_order_relaxed))
+            {}
+        }
+    }
+
+    void unlock() noexcept
+    {
+        _locked.store(false, memory_order_release);
+    }
+
+public:
+    frame_arena(frame_arena const&) = delete;
+    frame_arena& operator=(frame_arena const&) = delete;
+
+    // The returned arena is owned by caller, who should call release() when done.
+    // return nullptr if allocation failed.
+    static frame_arena* create(size_t capacity = default_capacity) noexcept
+    {
+        size_t cap = units_of(capacity);
+
+        try{
+            void* m = unit_allocator().allocate(header_units() + cap);
+            return new (m) frame_arena(cap);
+        }
+        catch(...)
+        {
+            return nullptr;
+        }
+    }
+
+    // Arena that new frames of frame_arena_allocator<T, Upstream> are carved from on calling thread.
+    static frame_arena* current() noexcept
+    {
+        return tl_current;
+    }
+
+    static frame_arena* exchange_current(frame_arena* a) noexcept
+    {
+        return std::exchange(tl_current, a);
+    }
+
+    void add_ref() noexcept
+    {
+        _refs.fetch_add(1, memory_order_relaxed);
+    }
+
+    void release() noexcept
+    {
+        if(_refs.fetch_sub(1, memory_order_acq_rel) == 1)
+        {
+            DSK_ASSERT(_top == 0);
+
+            size_t n = header_units() + _cap;
+            this->~frame_arena();
+            unit_allocator().deallocate(reinterpret_cast<unit_t*>(this), n);
+        }
+    }
+
+    size_t capacity() const noexcept { return _cap * sizeof(unit_t); }
+
+    // bytes in use, including freed blocks not reclaimed yet.
+    size_t used() noexcept
+    {
+        lock();
+        size_t n = _top;
+        unlock();
+        return n * sizeof(unit_t);
+    }
+
+    // return nullptr if there is no enough space.
+    void* allocate(size_t bytes) noexcept
+    {
+        size_t n = units_of(bytes) + 1;
+
+        lock();
+
+        if(_cap - _top < n)
+        {
+            unlock();
+            return nullptr;
+        }
+
+        unit_t* p = data() + _top;
+        _top += n;
+        *footer_below(_top) = {n, false};
+
+        unlock();
+
+        add_ref();
+        return p;
+    }
+
+    void deallocate(void* p, size_t bytes) noexcept
+    {
+        size_t n = units_of(bytes) + 1;
+        size_t b = static_cast<size_t>(static_cast<unit_t*>(p) - data());
+
+        lock();
+
+        DSK_ASSERT(b + n <= _top);
+
+        footer_below(b + n)->freed = true;
+
+        if(b + n == _top)
+        {
+            while(_top && footer_below(_top)->freed)
+            {
+                _top -= footer_below(_top)->units;
+            }
+        }
+
+        unlock();
+
+        release();
+    }
+};
+
+
+// Stateless allocator, carves from frame_arena<Upstream>::current() if any, otherwise or if it's full, uses Upstream.
+// Mainly intended for coroutine frames, which are created and destroyed in LIFO order under structured concurrency:
+//      task<T, E, frame_arena_allocator<>>
+//      generator<T, E, frame_arena_allocator<>>
+// Each block is prefixed with the arena it's from, so it can be deallocated on any thread.
+template<class T = void, class Upstream = DSK_DEFAULT_ALLOCATOR<void>>
+struct frame_arena_allocator
+{
+    using frame_arena_type = frame_arena<Upstream>;
+
+    using value_type = T;
+
+    using is_always_equal = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+
+private:
+    static constexpr size_t header_size = frame_arena_type::default_align;
+
+    struct alignas(header_size) unit_t
+    {
+        unsigned char pad[header_size];
+    };
+
+    using unit_allocator = rebind_alloc<Upstream, unit_t>;
+
+    // units of upstream block of n T, including header.
+    static constexpr size_t block_units(size_t n) noexcept
+    {
+        return (n * sizeof(T) + header_size - 1) / header_size + 1;
+    }
+
+public:
+    constexpr frame_arena_allocator() = default;
+
+    template<class U>
+    constexpr frame_arena_allocator(frame_arena_allocator<U, Upstream> const&) noexcept
+    {}
+
+    template<class U>
+    constexpr bool operator==(frame_arena_allocator<U, Upstream> const&) const noexcept
+    {
+        return true;
+    }
+
+    [[nodiscard]] T* allocate(size_t n)
+    {
+        if(n > (static_cast<size_t>(-1) - 2 * header_size) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+
+        if constexpr(alignof(T) <= header_size) // over-aligned ones go directly to Upstream.
+        {
+            frame_arena_type* a = frame_arena_type::current();
+            void*             p = nullptr;
+
+            if(a)
+            {
+                p = a->allocate(header_size + n * sizeof(T));
+            }
+
+            if(! p)
+            {
+                a = nullptr;
+                p = unit_allocator().allocate(block_units(n));
+            }
+
+            *static_cast<frame_arena_type**>(p) = a;
+            return reinterpret_cast<T*>(static_cast<unsigned char*>(p) + header_size);
+        }
+        else
+        {
+            return rebind_alloc<Upstream, T>().allocate(n);
+        }
+    }
+
+    void deallocate(T* t, size_t n) noexcept
+    {
+        if constexpr(alignof(T) <= header_size)
+        {
+            void* p = reinterpret_cast<unsigned char*>(t) - header_size;
+
+            if(auto* a = *static_cast<frame_arena_type**>(p))
+            {
+                a->deallocate(p, header_size + n * sizeof(T));
+            }
+            else
+            {
+                unit_allocator().deallocate(static_cast<unit_t*>(p), block_units(n));
+            }
+        }
+        else
+        {
+            rebind_alloc<Upstream, T>().deallocate(t, n);
+        }
+    }
+};
+
+
+// Per coroutine state to make its arena current while it's running.
+// A coroutine joins the arena current at its creation, i.e. the one its parent runs with,
+// so frames of the whole call tree are carved from the same arena.
+template<class Arena>
+class frame_arena_scope
+{
+    Arena* _arena  = Arena::current();
+    Arena* _prev   = nullptr;
+    bool   _active = false;
+
+public:
+    frame_arena_scope() noexcept
+    {
+        if(_arena)
+        {
+            _arena->add_ref();
+        }
+    }
+
+    frame_arena_scope(frame_arena_scope const&) = delete;
+    frame_arena_scope& operator=(frame_arena_scope const&) = delete;
+
+    ~frame_arena_scope()
+    {
+        DSK_ASSERT(! _active);
+
+        if(_arena)
+        {
+            _arena->release();
+        }
+    }
+
+    Arena* arena() const noexcept { return _arena; }
+
+    // Take ownership of a, which becomes current if active.
+    void reset(Arena* a) noexcept
+    {
+        if(_arena)
+        {
+            _arena->release();
+        }
+
+        _arena = a;
+
+        if(_active)
+        {
+            Arena::exchange_current(a);
+        }
+    }
+
+    // on resume
+    void activate() noexcept
+    {
+        if(! _active)
+        {
+            _prev = Arena::exchange_current(_arena);
+            _active = true;
+        }
+    }
+
+    // on suspend
+    void deactivate() noexcept
+    {
+        if(_active)
+        {
+            Arena::exchange_current(_prev);
+            _active = false;
+        }
+    }
+};
+
+
+} // namespace dsk
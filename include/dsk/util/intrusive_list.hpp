@@ -0,0 +1,127 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/util/debug.hpp>
+
+
+namespace dsk{
+
+
+// Base of intrusive_list nodes.
+// A node knows whether it's linked, so it can be unlinked in O(1) without searching.
+// Copying/moving a node gives an unlinked one, so ops can be moved before they are linked.
+class intrusive_list_hook
+{
+    template<class> friend class intrusive_list;
+
+    intrusive_list_hook* _prev = nullptr;
+    intrusive_list_hook* _next = nullptr;
+
+public:
+    intrusive_list_hook() = default;
+
+    intrusive_list_hook(intrusive_list_hook const& o) noexcept
+    {
+        DSK_ASSERT(! o.is_linked());
+    }
+
+    intrusive_list_hook& operator=(intrusive_list_hook const& o) noexcept
+    {
+        DSK_ASSERT(! is_linked());
+        DSK_ASSERT(! o.is_linked());
+        return *this;
+    }
+
+    ~intrusive_list_hook()
+    {
+        DSK_ASSERT(! is_linked());
+    }
+
+    bool is_linked() const noexcept { return _prev != nullptr; }
+};
+
+
+// Circular doubly-linked list of T, which must be derived from intrusive_list_hook.
+// The list doesn't own nodes.
+template<class T>
+class intrusive_list
+{
+    intrusive_list_hook _head; // sentinel
+    size_t              _size = 0;
+
+    static T* to_node(intrusive_list_hook* h) noexcept
+    {
+        return static_cast<T*>(h);
+    }
+
+    void unlink(intrusive_list_hook* h) noexcept
+    {
+        h->_prev->_next = h->_next;
+        h->_next->_prev = h->_prev;
+        h->_prev = h->_next = nullptr;
+        --_size;
+    }
+
+public:
+    intrusive_list() noexcept
+    {
+        _head._prev = _head._next = &_head;
+    }
+
+    intrusive_list(intrusive_list const&) = delete;
+    intrusive_list& operator=(intrusive_list const&) = delete;
+
+    ~intrusive_list()
+    {
+        DSK_ASSERT(empty());
+        _head._prev = _head._next = nullptr;
+    }
+
+    size_t size() const noexcept { return _size; }
+    bool  empty() const noexcept { return _size == 0; }
+
+    void push_back(T* n) noexcept
+    {
+        intrusive_list_hook* h = n;
+
+        DSK_ASSERT(! h->is_linked());
+
+        h->_prev = _head._prev;
+        h->_next = &_head;
+        _head._prev->_next = h;
+        _head._prev = h;
+        ++_size;
+    }
+
+    T* front() const noexcept
+    {
+        return empty() ? nullptr : to_node(_head._next);
+    }
+
+    // return nullptr if empty
+    T* pop_front() noexcept
+    {
+        if(empty())
+            return nullptr;
+
+        intrusive_list_hook* h = _head._next;
+        unlink(h);
+        return to_node(h);
+    }
+
+    // n must be in this list, if linked.
+    // return false if n is not linked.
+    bool erase(T* n) noexcept
+    {
+        intrusive_list_hook* h = n;
+
+        if(! h->is_linked())
+            return false;
+
+        unlink(h);
+        return true;
+    }
+};
+
+
+} // namespace dsk
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/type_traits.hpp>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <optional>
+
+
+namespace dsk{
+
+
+// Bounded lock-free multi-producer multi-consumer queue.
+// Based on Dmitry Vyukov's bounded MPMC queue.
+// Capacity is rounded up to power of 2.
+// Cells are raw storage, elements are constructed on push and destroyed on pop,
+// so T doesn't need to be default constructible.
+template<class T>
+class bounded_mpmc_queue
+{
+    struct cell_t
+    {
+        atomic<size_t>       seq;
+        alignas(T) std::byte buf[sizeof(T)];
+
+        T& data() noexcept { return *std::launder(reinterpret_cast<T*>(buf)); }
+    };
+
+    size_t                    _mask;
+    std::unique_ptr<cell_t[]> _cells;
+
+    alignas(cache_line_size) atomic<size_t> _enqPos{0};
+    alignas(cache_line_size) atomic<size_t> _deqPos{0};
+
+    static size_t round_cap(size_t n) noexcept
+    {
+        size_t cap = 2;
+
+        while(cap < n)
+            cap *= 2;
+
+        return cap;
+    }
+
+public:
+    explicit bounded_mpmc_queue(size_t cap)
+        : _mask(round_cap(cap) - 1), _cells(new cell_t[_mask + 1])
+    {
+        for(size_t i = 0; i <= _mask; ++i)
+        {
+            _cells[i].seq.store(i, memory_order_relaxed);
+        }
+    }
+
+    // no concurrent access at this point, so all cells in [_deqPos, _enqPos) hold an element.
+    ~bounded_mpmc_queue()
+    {
+        size_t e = _enqPos.load(memory_order_relaxed);
+
+        for(size_t d = _deqPos.load(memory_order_relaxed); d != e; ++d)
+        {
+            std::destroy_at(&_cells[d & _mask].data());
+        }
+    }
+
+    bounded_mpmc_queue(bounded_mpmc_queue const&) = delete;
+    bounded_mpmc_queue& operator=(bounded_mpmc_queue const&) = delete;
+
+    size_t capacity() const noexcept { return _mask + 1; }
+
+    // return false if full, in which case v is untouched.
+    bool try_push(auto&& v)
+    {
+        size_t pos = _enqPos.load(memory_order_relaxed);
+
+        for(;;)
+        {
+            cell_t&  c   = _cells[pos & _mask];
+            size_t   seq = c.seq.load(memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if(dif == 0)
+            {
+                if(_enqPos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                {
+                    std::construct_at(reinterpret_cast<T*>(c.buf), DSK_FORWARD(v));
+                    c.seq.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            }
+            else if(dif < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = _enqPos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    std::optional<T> try_pop()
+    {
+        size_t pos = _deqPos.load(memory_order_relaxed);
+
+        for(;;)
+        {
+            cell_t&  c   = _cells[pos & _mask];
+            size_t   seq = c.seq.load(memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+            if(dif == 0)
+            {
+                if(_deqPos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                {
+                    std::optional<T> v(mut_move(c.data()));
+                    std::destroy_at(&c.data());
+                    c.seq.store(pos + _mask + 1, memory_order_release);
+                    return v;
+                }
+            }
+            else if(dif < 0)
+            {
+                return {};
+            }
+            else
+            {
+                pos = _deqPos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // approximate
+    size_t size() const noexcept
+    {
+        size_t e = _enqPos.load(memory_order_relaxed);
+        size_t d = _deqPos.load(memory_order_relaxed);
+        return e > d ? e - d : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+};
+
+
+} // namespace dsk
@@ -0,0 +1,410 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/default_allocator.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/mutex.hpp>
+#include <dsk/util/vector.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/allocator.hpp>
+#include <array>
+
+
+namespace dsk{
+
+
+struct frame_recycler_stats
+{
+    size_t allocTotal     = 0; // total allocate requests
+    size_t allocLocal     = 0; // served by thread local cache
+    size_t allocDepot     = 0; // served by shared depot, i.e. blocks freed on other threads
+    size_t deallocTotal   = 0; // total deallocate requests
+    size_t deallocRecycle = 0; // kept for recycling
+
+    constexpr void reset() noexcept { *this = {}; }
+
+    constexpr size_t alloc_hit () const noexcept { return allocLocal + allocDepot; }
+    constexpr size_t alloc_miss() const noexcept { return allocTotal - alloc_hit(); }
+
+    constexpr double hit_rate      () const noexcept { return static_cast<double>(alloc_hit()) / allocTotal; }
+    constexpr double local_hit_rate() const noexcept { return static_cast<double>(allocLocal) / allocTotal; }
+    constexpr double recycle_rate  () const noexcept { return static_cast<double>(deallocRecycle) / deallocTotal; }
+
+    constexpr frame_recycler_stats& operator+=(frame_recycler_stats const& o) noexcept
+    {
+        allocTotal     += o.allocTotal;
+        allocLocal     += o.allocLocal;
+        allocDepot     += o.allocDepot;
+        deallocTotal   += o.deallocTotal;
+        deallocRecycle += o.deallocRecycle;
+        return *this;
+    }
+};
+
+
+// Size class bucketed block recycler backed by a stateless Upstream allocator.
+//
+// Each thread has its own cache of freed blocks for each size class, no synchronization is needed.
+// When a thread's cache of a size class is full, half of it is moved to a shared depot as a batch,
+// where other threads can pick it up when their own cache is empty. This is the return path for
+// blocks allocated on one thread and freed on another, e.g. a coroutine frame created on one worker
+// and destroyed on another one.
+//
+// Blocks larger than max_size or over-aligned ones go directly to Upstream.
+template<class Upstream = DSK_DEFAULT_ALLOCATOR<void>>
+class frame_recycler
+{
+public:
+    static constexpr size_t granularity = 64;
+    static constexpr size_t max_size    = 4096;
+    static constexpr size_t class_count = max_size / granularity;
+    static constexpr size_t local_cap   = 64; // blocks per size class per thread
+    static constexpr size_t batch_size  = local_cap / 2;
+    static constexpr size_t depot_cap   = 64; // batches per size class
+
+    static constexpr size_t default_align = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+private:
+    struct alignas(default_align) unit_t
+    {
+        unsigned char pad[default_align];
+    };
+
+    static_assert(granularity % sizeof(unit_t) == 0);
+
+    using unit_allocator = rebind_alloc<Upstream, unit_t>;
+
+    static_assert(is_stateless_allocator_v<unit_allocator>);
+
+    struct node_t
+    {
+        node_t* next;
+    };
+
+    struct free_list_t
+    {
+        node_t* head = nullptr;
+        size_t  size = 0;
+
+        void push(node_t* n) noexcept
+        {
+            n->next = head;
+            head = n;
+            ++size;
+        }
+
+        node_t* pop() noexcept
+        {
+            node_t* n = head;
+            head = n->next;
+            --size;
+            return n;
+        }
+
+        // split off first n nodes
+        free_list_t split(size_t n) noexcept
+        {
+            DSK_ASSERT(0 < n && n <= size);
+
+            free_list_t r{head, n};
+
+            node_t* last = head;
+
+            for(size_t i = 1; i < n; ++i)
+                last = last->next;
+
+            head = last->next;
+            size -= n;
+            last->next = nullptr;
+            return r;
+        }
+    };
+
+    static constexpr size_t class_of(size_t size) noexcept
+    {
+        return (size - 1) / granularity;
+    }
+
+    static constexpr size_t units_of_class(size_t c) noexcept
+    {
+        return (c + 1) * granularity / sizeof(unit_t);
+    }
+
+    static void* upstream_allocate(size_t c)
+    {
+        return unit_allocator().allocate(units_of_class(c));
+    }
+
+    static void upstream_deallocate(free_list_t& l, size_t c) noexcept
+    {
+        while(l.head)
+            unit_allocator().deallocate(reinterpret_cast<unit_t*>(l.pop()), units_of_class(c));
+    }
+
+    class depot_t
+    {
+        struct class_depot_t
+        {
+            mutex               mtx;
+            vector<free_list_t> batches;
+        };
+
+        std::array<class_depot_t, class_count> _classes;
+
+    public:
+        ~depot_t()
+        {
+            for(size_t c = 0; c < class_count; ++c)
+            {
+                for(auto& b : _classes[c].batches)
+                    upstream_deallocate(b, c);
+            }
+        }
+
+        bool push(size_t c, free_list_t& b)
+        {
+            auto& d = _classes[c];
+            lock_guard lk(d.mtx);
+
+            if(d.batches.size() >= depot_cap)
+                return false;
+
+            d.batches.emplace_back(b);
+            b = {};
+            return true;
+        }
+
+        bool pop(size_t c, free_list_t& b)
+        {
+            auto& d = _classes[c];
+            lock_guard lk(d.mtx);
+
+            if(d.batches.empty())
+                return false;
+
+            b = d.batches.back();
+            d.batches.pop_back();
+            return true;
+        }
+    };
+
+    // owner thread writes, any thread may read.
+    class stats_counter
+    {
+        atomic<size_t> _n = 0;
+
+    public:
+        void   inc() noexcept { _n.store(_n.load(memory_order_relaxed) + 1, memory_order_relaxed); }
+        size_t get() const noexcept { return _n.load(memory_order_relaxed); }
+    };
+
+    class thread_cache
+    {
+        std::array<free_list_t, class_count> _lists;
+
+    public:
+        stats_counter allocTotal, allocLocal, allocDepot, deallocTotal, deallocRecycle;
+
+        thread_cache()
+        {
+            depot(); // make sure it outlives thread caches
+
+            auto& r = registry();
+            lock_guard lk(r.mtx);
+            r.caches.emplace_back(this);
+        }
+
+        ~thread_cache()
+        {
+            for(size_t c = 0; c < class_count; ++c)
+            {
+                auto& l = _lists[c];
+
+                while(l.size)
+                {
+                    auto b = l.split(std::min(l.size, batch_size));
+
+                    if(! depot().push(c, b))
+                        upstream_deallocate(b, c);
+                }
+            }
+
+            auto& r = registry();
+            lock_guard lk(r.mtx);
+            r.retired += stats();
+            std::erase(r.caches, this);
+        }
+
+        frame_recycler_stats stats() const noexcept
+        {
+            return {
+                .allocTotal     = allocTotal.get(),
+                .allocLocal     = allocLocal.get(),
+                .allocDepot     = allocDepot.get(),
+                .deallocTotal   = deallocTotal.get(),
+                .deallocRecycle = deallocRecycle.get()
+            };
+        }
+
+        void* allocate(size_t c)
+        {
+            allocTotal.inc();
+
+            auto& l = _lists[c];
+
+            if(l.size)
+            {
+                allocLocal.inc();
+                return l.pop();
+            }
+
+            if(depot().pop(c, l))
+            {
+                allocDepot.inc();
+                return l.pop();
+            }
+
+            return upstream_allocate(c);
+        }
+
+        void deallocate(void* p, size_t c)
+        {
+            deallocTotal.inc();
+
+            auto& l = _lists[c];
+
+            if(l.size >= local_cap)
+            {
+                auto b = l.split(batch_size);
+
+                if(! depot().push(c, b))
+                    upstream_deallocate(b, c);
+            }
+
+            l.push(static_cast<node_t*>(p));
+            deallocRecycle.inc();
+        }
+    };
+
+    struct registry_t
+    {
+        mutex                 mtx;
+        vector<thread_cache*> caches;
+        frame_recycler_stats  retired; // stats of exited threads
+    };
+
+    static registry_t& registry()
+    {
+        static registry_t r;
+        return r;
+    }
+
+    static depot_t& depot()
+    {
+        static depot_t d;
+        return d;
+    }
+
+    static thread_cache& local_cache()
+    {
+        thread_local thread_cache c;
+        return c;
+    }
+
+public:
+    static constexpr bool is_recyclable(size_t size, size_t align) noexcept
+    {
+        return 0 < size && size <= max_size && align <= default_align;
+    }
+
+    static void* allocate(size_t size)
+    {
+        DSK_ASSERT(is_recyclable(size, default_align));
+        return local_cache().allocate(class_of(size));
+    }
+
+    static void deallocate(void* p, size_t size)
+    {
+        DSK_ASSERT(is_recyclable(size, default_align));
+        local_cache().deallocate(p, class_of(size));
+    }
+
+    // aggregated stats of all threads, including exited ones.
+    static frame_recycler_stats stats()
+    {
+        auto& r = registry();
+        lock_guard lk(r.mtx);
+
+        frame_recycler_stats s = r.retired;
+
+        for(auto* c : r.caches)
+            s += c->stats();
+
+        return s;
+    }
+
+    // stats of calling thread
+    static frame_recycler_stats thread_stats()
+    {
+        return local_cache().stats();
+    }
+};
+
+
+// Stateless allocator using frame_recycler<Upstream>.
+// Mainly intended for coroutine frames, which are created and destroyed at high rates with a few recurring sizes:
+//      task<T, E, recycling_allocator<>>
+//      generator<T, E, recycling_allocator<>>
+template<class T = void, class Upstream = DSK_DEFAULT_ALLOCATOR<void>>
+struct recycling_allocator
+{
+    using recycler = frame_recycler<Upstream>;
+
+    using value_type = T;
+
+    using is_always_equal = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    constexpr recycling_allocator() = default;
+
+    template<class U>
+    constexpr recycling_allocator(recycling_allocator<U, Upstream> const&) noexcept
+    {}
+
+    template<class U>
+    constexpr bool operator==(recycling_allocator<U, Upstream> const&) const noexcept
+    {
+        return true;
+    }
+
+    [[nodiscard]] T* allocate(size_t n)
+    {
+        if(n > static_cast<size_t>(-1) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+
+        if(recycler::is_recyclable(n * sizeof(T), alignof(T)))
+        {
+            return static_cast<T*>(recycler::allocate(n * sizeof(T)));
+        }
+
+        return rebind_alloc<Upstream, T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        if(recycler::is_recyclable(n * sizeof(T), alignof(T)))
+        {
+            recycler::deallocate(p, n * sizeof(T));
+            return;
+        }
+
+        rebind_alloc<Upstream, T>().deallocate(p, n);
+    }
+
+    static frame_recycler_stats stats() { return recycler::stats(); }
+};
+
+
+} // namespace dsk
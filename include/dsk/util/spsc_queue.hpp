@@ -0,0 +1,132 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/type_traits.hpp>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <optional>
+
+
+namespace dsk{
+
+
+// Bounded lock-free single-producer single-consumer ring buffer.
+// Only one thread at a time may try_push(), and only one thread at a time may try_pop().
+// Each side caches the other side's index, so the shared index is only reloaded when
+// the cached one says the ring is full/empty.
+// Capacity is rounded up to power of 2.
+// Cells are raw storage, elements are constructed on push and destroyed on pop,
+// so T doesn't need to be default constructible.
+template<class T>
+class bounded_spsc_queue
+{
+    struct cell_t
+    {
+        alignas(T) std::byte buf[sizeof(T)];
+
+        T& get() noexcept { return *std::launder(reinterpret_cast<T*>(buf)); }
+    };
+
+    size_t                    _mask;
+    std::unique_ptr<cell_t[]> _cells;
+
+    struct alignas(cache_line_size) producer_t
+    {
+        atomic<size_t> pos{0};
+        size_t         cachedDeqPos = 0;
+    };
+
+    struct alignas(cache_line_size) consumer_t
+    {
+        atomic<size_t> pos{0};
+        size_t         cachedEnqPos = 0;
+    };
+
+    producer_t _enq;
+    consumer_t _deq;
+
+    static size_t round_cap(size_t n) noexcept
+    {
+        size_t cap = 2;
+
+        while(cap < n)
+            cap *= 2;
+
+        return cap;
+    }
+
+public:
+    explicit bounded_spsc_queue(size_t cap)
+        : _mask(round_cap(cap) - 1), _cells(new cell_t[_mask + 1])
+    {}
+
+    ~bounded_spsc_queue()
+    {
+        size_t e = _enq.pos.load(memory_order_relaxed);
+
+        for(size_t d = _deq.pos.load(memory_order_relaxed); d != e; ++d)
+        {
+            std::destroy_at(&_cells[d & _mask].get());
+        }
+    }
+
+    bounded_spsc_queue(bounded_spsc_queue const&) = delete;
+    bounded_spsc_queue& operator=(bounded_spsc_queue const&) = delete;
+
+    size_t capacity() const noexcept { return _mask + 1; }
+
+    // producer only
+    // return false if full, in which case v is untouched.
+    bool try_push(auto&& v)
+    {
+        size_t pos = _enq.pos.load(memory_order_relaxed);
+
+        if(pos - _enq.cachedDeqPos > _mask)
+        {
+            _enq.cachedDeqPos = _deq.pos.load(memory_order_acquire);
+
+            if(pos - _enq.cachedDeqPos > _mask)
+                return false;
+        }
+
+        std::construct_at(reinterpret_cast<T*>(_cells[pos & _mask].buf), DSK_FORWARD(v));
+        _enq.pos.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    std::optional<T> try_pop()
+    {
+        size_t pos = _deq.pos.load(memory_order_relaxed);
+
+        if(pos == _deq.cachedEnqPos)
+        {
+            _deq.cachedEnqPos = _enq.pos.load(memory_order_acquire);
+
+            if(pos == _deq.cachedEnqPos)
+                return {};
+        }
+
+        T& c = _cells[pos & _mask].get();
+        std::optional<T> v(mut_move(c));
+        std::destroy_at(&c);
+        _deq.pos.store(pos + 1, memory_order_release);
+        return v;
+    }
+
+    // approximate
+    size_t size() const noexcept
+    {
+        size_t e = _enq.pos.load(memory_order_relaxed);
+        size_t d = _deq.pos.load(memory_order_relaxed);
+        return e > d ? e - d : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+};
+
+
+} // namespace dsk
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/intrusive_list.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+
+namespace dsk{
+
+
+// Node of timing_wheel.
+// Copying/moving an entry gives an unlinked one, as intrusive_list_hook does.
+class timing_wheel_entry : public intrusive_list_hook
+{
+    template<size_t> friend class timing_wheel;
+
+    uint64_t _expiry = 0; // in ticks
+    uint8_t  _level  = 0; // where it's linked, used to find its slot in O(1).
+    uint8_t  _slot   = 0;
+
+public:
+    uint64_t expiry_tick() const noexcept { return _expiry; }
+};
+
+
+// Hierarchical timing wheel of Levels levels, each has 64 slots.
+// Level l covers ticks of 64^(l+1), entries beyond the top level are kept in an overflow list,
+// and are redistributed once per 64^Levels ticks.
+//
+// insert/erase are O(1), advance is O(1) amortized per tick plus expired entries.
+// Empty ticks are skipped with occupancy bitmaps, so an idle or sparse wheel costs nothing.
+//
+// Not thread safe.
+template<size_t Levels = 4>
+class timing_wheel
+{
+    static constexpr size_t   slot_bits       = 6;
+    static constexpr size_t   slots_per_level = size_t(1) << slot_bits;
+    static constexpr uint64_t slot_mask       = slots_per_level - 1;
+    static constexpr uint8_t  overflow_level  = Levels;
+
+    static_assert(0 < Levels && Levels * slot_bits < 64);
+
+    using list_type = intrusive_list<timing_wheel_entry>;
+
+    list_type _slots[Levels][slots_per_level];
+    uint64_t  _occupied[Levels] = {}; // bit i is set if _slots[l][i] is not empty.
+    list_type _overflow;
+    uint64_t  _now  = 0; // entries of expiry <= _now have been expired.
+    size_t    _size = 0;
+
+    static constexpr uint64_t digit(uint64_t t, size_t l) noexcept
+    {
+        return (t >> (l * slot_bits)) & slot_mask;
+    }
+
+    // bits of slots after d
+    static constexpr uint64_t after_mask(uint64_t d) noexcept
+    {
+        return d == slot_mask ? 0 : (~uint64_t(0) << (d + 1));
+    }
+
+    list_type& list_of(timing_wheel_entry* e) noexcept
+    {
+        return e->_level == overflow_level ? _overflow : _slots[e->_level][e->_slot];
+    }
+
+    // e->_expiry >= _now.
+    // Entry is placed at the lowest level on which it shares all higher digits with _now,
+    // so it's cascaded down exactly when _now enters its slot.
+    void place(timing_wheel_entry* e) noexcept
+    {
+        DSK_ASSERT(e->_expiry >= _now);
+
+        uint64_t x = e->_expiry ^ _now;
+        size_t   l = x ? (std::bit_width(x) - 1) / slot_bits : 0;
+
+        if(l >= Levels)
+        {
+            e->_level = overflow_level;
+            _overflow.push_back(e);
+            return;
+        }
+
+        uint64_t d = digit(e->_expiry, l);
+
+        e->_level = static_cast<uint8_t>(l);
+        e->_slot  = static_cast<uint8_t>(d);
+        _slots[l][d].push_back(e);
+        _occupied[l] |= uint64_t(1) << d;
+    }
+
+    void replace_all(list_type& lst) noexcept
+    {
+        while(auto* e = lst.pop_front())
+        {
+            place(e);
+        }
+    }
+
+    // advance _now by 1 tick.
+    void step(auto& onExpired)
+    {
+        ++_now;
+
+        if((_now & ((uint64_t(1) << (Levels * slot_bits)) - 1)) == 0)
+        {
+            // entries may go back to overflow, so detach them first.
+            list_type lst;
+
+            while(auto* e = _overflow.pop_front())
+            {
+                lst.push_back(e);
+            }
+
+            replace_all(lst);
+        }
+
+        // top-down, so entries cascaded from higher level can be cascaded further in same tick.
+        for(size_t l = Levels - 1; l > 0; --l)
+        {
+            if((_now & ((uint64_t(1) << (l * slot_bits)) - 1)) == 0)
+            {
+                uint64_t d = digit(_now, l);
+
+                if(_occupied[l] & (uint64_t(1) << d))
+                {
+                    _occupied[l] &= ~(uint64_t(1) << d);
+                    replace_all(_slots[l][d]);
+                }
+            }
+        }
+
+        uint64_t d = digit(_now, 0);
+
+        if(_occupied[0] & (uint64_t(1) << d))
+        {
+            _occupied[0] &= ~(uint64_t(1) << d);
+
+            auto& lst = _slots[0][d];
+
+            while(auto* e = lst.pop_front())
+            {
+                --_size;
+                onExpired(e); // may insert/erase other entries.
+            }
+        }
+    }
+
+public:
+    timing_wheel() = default;
+
+    timing_wheel(timing_wheel const&) = delete;
+    timing_wheel& operator=(timing_wheel const&) = delete;
+
+    ~timing_wheel()
+    {
+        DSK_ASSERT(empty());
+    }
+
+    uint64_t now_tick() const noexcept { return _now; }
+    size_t       size() const noexcept { return _size; }
+    bool        empty() const noexcept { return _size == 0; }
+
+    // Entry expired at or before now_tick() will be expired on next tick.
+    void insert(timing_wheel_entry* e, uint64_t expiryTick) noexcept
+    {
+        e->_expiry = std::max(expiryTick, _now + 1);
+        place(e);
+        ++_size;
+    }
+
+    // return false if e is not linked.
+    bool erase(timing_wheel_entry* e) noexcept
+    {
+        if(! e->is_linked())
+        {
+            return false;
+        }
+
+        auto& lst = list_of(e);
+
+        lst.erase(e);
+        --_size;
+
+        if(e->_level != overflow_level && lst.empty())
+        {
+            _occupied[e->_level] &= ~(uint64_t(1) << e->_slot);
+        }
+
+        return true;
+    }
+
+    // The earliest tick at which some entry may expire or be cascaded,
+    // never later than the real expiry of any entry.
+    // return UINT64_MAX if empty.
+    uint64_t next_event_tick() const noexcept
+    {
+        if(empty())
+        {
+            return UINT64_MAX;
+        }
+
+        for(size_t l = 0; l < Levels; ++l)
+        {
+            // slots at or before current digit are empty on each level.
+            if(uint64_t m = _occupied[l] & after_mask(digit(_now, l)))
+            {
+                uint64_t base = (_now >> ((l + 1) * slot_bits)) << ((l + 1) * slot_bits);
+                return base | (uint64_t(std::countr_zero(m)) << (l * slot_bits));
+            }
+        }
+
+        DSK_ASSERT(! _overflow.empty());
+
+        return ((_now >> (Levels * slot_bits)) + 1) << (Levels * slot_bits);
+    }
+
+    // Expire all entries of expiry <= toTick, in expiry order.
+    // onExpired(timing_wheel_entry*) is called with the unlinked entry.
+    // return number of expired entries.
+    size_t advance(uint64_t toTick, auto&& onExpired)
+    {
+        size_t n = 0;
+
+        auto counted = [&](timing_wheel_entry* e)
+        {
+            ++n;
+            onExpired(e);
+        };
+
+        while(_now < toTick)
+        {
+            uint64_t t = next_event_tick();
+
+            if(t > toTick)
+            {
+                _now = toTick; // no slot to cascade or expire in (_now, toTick].
+                break;
+            }
+
+            _now = t - 1;
+            step(counted);
+        }
+
+        return n;
+    }
+
+    // Unlink all entries without expiring them, onRemoved(timing_wheel_entry*) is called for each.
+    void clear(auto&& onRemoved)
+    {
+        auto removeAll = [&](list_type& lst)
+        {
+            while(auto* e = lst.pop_front())
+            {
+                --_size;
+                onRemoved(e);
+            }
+        };
+
+        for(size_t l = 0; l < Levels; ++l)
+        {
+            for(auto& lst : _slots[l])
+            {
+                removeAll(lst);
+            }
+
+            _occupied[l] = 0;
+        }
+
+        removeAll(_overflow);
+    }
+};
+
+
+} // namespace dsk
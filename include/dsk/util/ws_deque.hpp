@@ -0,0 +1,154 @@
+#pragma once
+
+#include <dsk/config.hpp>
+#include <dsk/util/debug.hpp>
+#include <dsk/util/vector.hpp>
+#include <dsk/util/atomic.hpp>
+#include <dsk/util/allocate_unique.hpp>
+#include <optional>
+#include <type_traits>
+
+
+namespace dsk{
+
+
+// Chase-Lev work stealing deque.
+// Based on: "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al. 2013).
+//
+// Only the owner thread may push()/pop(), which work on the bottom end (LIFO).
+// Any thread may steal(), which works on the top end (FIFO).
+// T is stored in atomic<T>, so it should be small and trivially copyable, typically a pointer.
+template<class T>
+class ws_deque
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    struct ring_t
+    {
+        int64_t           mask;
+        vector<atomic<T>> buf;
+
+        explicit ring_t(int64_t cap)
+            : mask(cap - 1), buf(static_cast<size_t>(cap))
+        {
+            DSK_ASSERT(cap > 0 && (cap & mask) == 0);
+        }
+
+        int64_t capacity() const noexcept { return mask + 1; }
+
+        void put(int64_t i, T v) noexcept { buf[static_cast<size_t>(i & mask)].store(v, memory_order_relaxed); }
+        T    get(int64_t i) const noexcept { return buf[static_cast<size_t>(i & mask)].load(memory_order_relaxed); }
+    };
+
+    using ring_ptr = default_allocated_unique_ptr<ring_t>;
+
+    alignas(cache_line_size) atomic<int64_t> _top{0};
+    alignas(cache_line_size) atomic<int64_t> _bottom{0};
+    atomic<ring_t*>  _ring{nullptr};
+    vector<ring_ptr> _rings; // current and retired rings, retired ones may still be read by thieves,
+                             // so they are only released when the deque is destroyed.
+
+    ring_t* grow(ring_t* r, int64_t t, int64_t b)
+    {
+        auto& nr = _rings.emplace_back(default_allocate_unique<ring_t>(r->capacity() * 2));
+
+        for(int64_t i = t; i < b; ++i)
+        {
+            nr->put(i, r->get(i));
+        }
+
+        _ring.store(nr.get(), memory_order_release);
+        return nr.get();
+    }
+
+public:
+    explicit ws_deque(size_t initCap = 256)
+    {
+        size_t cap = 2;
+
+        while(cap < initCap)
+            cap *= 2;
+
+        _ring.store(_rings.emplace_back(default_allocate_unique<ring_t>(static_cast<int64_t>(cap))).get(),
+                    memory_order_relaxed);
+    }
+
+    ws_deque(ws_deque const&) = delete;
+    ws_deque& operator=(ws_deque const&) = delete;
+
+    // owner only
+    void push(T v)
+    {
+        int64_t b = _bottom.load(memory_order_relaxed);
+        int64_t t = _top.load(memory_order_acquire);
+        ring_t* r = _ring.load(memory_order_relaxed);
+
+        if(b - t > r->capacity() - 1)
+            r = grow(r, t, b);
+
+        r->put(b, v);
+        atomic_thread_fence(memory_order_release);
+        _bottom.store(b + 1, memory_order_relaxed);
+    }
+
+    // owner only
+    std::optional<T> pop() noexcept
+    {
+        int64_t b = _bottom.load(memory_order_relaxed) - 1;
+        ring_t* r = _ring.load(memory_order_relaxed);
+        _bottom.store(b, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t t = _top.load(memory_order_relaxed);
+
+        if(t > b) // empty
+        {
+            _bottom.store(b + 1, memory_order_relaxed);
+            return {};
+        }
+
+        T v = r->get(b);
+
+        if(t == b) // last one, race with thieves
+        {
+            bool won = _top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+            _bottom.store(b + 1, memory_order_relaxed);
+
+            if(! won)
+                return {};
+        }
+
+        return v;
+    }
+
+    // any thread
+    // NOTE: may fail spuriously when racing with other thieves or owner.
+    std::optional<T> steal() noexcept
+    {
+        int64_t t = _top.load(memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t b = _bottom.load(memory_order_acquire);
+
+        if(t >= b)
+            return {};
+
+        T v = _ring.load(memory_order_acquire)->get(t);
+
+        if(! _top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+            return {};
+
+        return v;
+    }
+
+    // any thread, approximate
+    size_t size() const noexcept
+    {
+        int64_t b = _bottom.load(memory_order_relaxed);
+        int64_t t = _top.load(memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+};
+
+
+} // namespace dsk
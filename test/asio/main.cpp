@@ -5,7 +5,10 @@
 #include <dsk/task.hpp>
 #include <dsk/until.hpp>
 #include <dsk/sync_wait.hpp>
+#include <dsk/resume_on.hpp>
+#include <dsk/asio/thread_pool.hpp>
 #include <dsk/asio/timer.hpp>
+#include <dsk/asio/timing_wheel.hpp>
 #include <dsk/asio/ip.hpp>
 #include <dsk/asio/tcp.hpp>
 #include <dsk/asio/udp.hpp>
@@ -15,8 +18,18 @@
 #include <dsk/asio/read.hpp>
 #include <dsk/asio/read_at.hpp>
 #include <dsk/asio/connect.hpp>
+#include <dsk/asio/transfer.hpp>
 #ifdef BOOST_ASIO_HAS_FILE
 #include <dsk/asio/file.hpp>
+#include <dsk/asio/send_file.hpp>
+#include <dsk/asio/recv_file.hpp>
+#include <fstream>
+#include <filesystem>
+#endif
+#ifdef BOOST_ASIO_HAS_IO_URING
+#include <dsk/asio/io_uring_fixed.hpp>
+#include <dsk/asio/io_uring_stream.hpp>
+#include <cstring>
 #endif
 
 
@@ -90,6 +103,83 @@ TEST_CASE("asio")
     }// SUBCASE("timed_op")
 
 
+    SUBCASE("sharded_inline_resume")
+    {
+        asio_sharded_io_thread_pool pool(2, start_now);
+
+        auto r = sync_wait
+        (
+            [&]() -> task<>
+            {
+                DSK_TRY resume_on(pool);
+
+                ptrdiff_t shard = pool.current_shard();
+                CHECK(shard >= 0);
+
+                // completion on calling shard's io_context is resumed inline, rather than posted to the same shard.
+                bool resumed = false;
+                resume([&](){ resumed = true; }, pool, pool.shard_context(static_cast<size_t>(shard)));
+                CHECK(resumed);
+
+                auto thrd = this_thread::get_id();
+                DSK_TRY wait_for(milliseconds(1), pool.shard_context(static_cast<size_t>(shard)));
+                CHECK(this_thread::get_id() == thrd);
+
+                DSK_RETURN();
+            }()
+        );
+
+        CHECK(! has_err(r));
+
+        // pinning result is recorded per shard.
+        asio_sharded_io_thread_pool unpinned(1);
+        unpinned.set_cpu_pinning(false);
+        unpinned.start();
+
+        auto rp = sync_wait(resume_on(unpinned)); // shard thread has started
+        CHECK(! has_err(rp));
+        CHECK(! unpinned.shard_pinned(0));
+    }// SUBCASE("sharded_inline_resume")
+
+
+    SUBCASE("wheel_timer")
+    {
+        auto r = sync_wait
+        (
+            [&]() -> task<>
+            {
+                constexpr auto expiryDur = milliseconds(26);
+
+                using timer_type = wheel_timer;
+
+                auto t = timer_type::now();
+                DSK_TRY wait_for<timer_type>(expiryDur);
+                auto dur = timer_type::now() - t;
+                CHECK(expiryDur <= dur);
+
+                t = timer_type::now();
+                auto r = DSK_WAIT wait_for<timer_type>(expiryDur, wait_for<timer_type>(milliseconds(266)));
+                CHECK(is_err(r, errc::timeout));
+                dur = timer_type::now() - t;
+                CHECK(expiryDur <= dur);
+
+                // timeouts canceled before expiry
+                for(int i = 0; i < 26; ++i)
+                {
+                    r = DSK_WAIT wait_for<timer_type>(milliseconds(266 + i), wait_for<timer_type>(milliseconds(1)));
+                    CHECK(! has_err(r));
+                }
+
+                CHECK(get_timing_wheel_service().pending_count() == 0);
+
+                DSK_RETURN();
+            }()
+        );
+
+        CHECK(! has_err(r));
+    }// SUBCASE("wheel_timer")
+
+
     SUBCASE("tcp")
     {
         constexpr int nCall = 26;
@@ -157,6 +247,74 @@ TEST_CASE("asio")
     }// SUBCASE("tcp")
 
 
+    SUBCASE("pipelined_transfer")
+    {
+        string data(1024*1024 + 123, '\0');
+
+        for(size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = static_cast<char>(i * 7);
+        }
+
+        auto r = sync_wait(until_all_succeeded
+        (
+            // echo server
+            [&]() -> task<>
+            {
+                tcp_acceptor acceptor(tcp_endpoint(tcp_v4(), 6263));
+                auto socket = DSK_TRY acceptor.accept();
+
+                size_t n = DSK_TRY pipelined_transfer(socket, socket, {.bufCount = 3, .minBufSize = 1024, .maxBufSize = 64*1024});
+                CHECK(n == data.size());
+
+                DSK_TRY_SYNC socket.shutdown(tcp_socket::shutdown_send);
+
+                DSK_RETURN();
+            }(),
+            // client
+            [&]() -> task<>
+            {
+                DSK_TRY wait_for(milliseconds(500));
+
+                tcp_socket socket;
+                DSK_TRY socket.connect(ip_addr_v4({127,0,0,1}), 6263);
+
+                string echo(data.size(), '\0');
+
+                DSK_TRY until_all_succeeded
+                (
+                    [&]() -> task<>
+                    {
+                        size_t n = DSK_TRY socket.write(data);
+                        CHECK(n == data.size());
+
+                        DSK_TRY_SYNC socket.shutdown(tcp_socket::shutdown_send);
+
+                        DSK_RETURN();
+                    }(),
+                    [&]() -> task<>
+                    {
+                        size_t n = DSK_TRY socket.read(echo);
+                        CHECK(n == data.size());
+                        CHECK(echo == data);
+
+                        char c;
+                        auto eof = DSK_WAIT socket.read_some(as_buf_of<char>(c));
+                        CHECK(is_err(eof, asio::error::eof));
+
+                        DSK_RETURN();
+                    }()
+                );
+
+                DSK_RETURN();
+            }()
+        ));
+
+        CHECK(! has_err(r));
+
+    }// SUBCASE("pipelined_transfer")
+
+
     SUBCASE("udp")
     {
         constexpr int nCall = 26;
@@ -221,6 +379,111 @@ TEST_CASE("asio")
     }// SUBCASE("udp")
 
 
+    SUBCASE("udp_batch")
+    {
+        constexpr int nMsg = 100; // more than udp_batch_max
+        udp_endpoint srvEndpoint(ip_addr_v4({127,0,0,1}), 2627);
+
+        auto r = sync_wait(until_all_succeeded
+        (
+            // server
+            [&]() -> task<>
+            {
+                udp_socket socket(srvEndpoint);
+
+                int vals[nMsg] = {};
+                udp_msg msgs[16];
+                int nRecv = 0;
+
+                while(nRecv < nMsg)
+                {
+                    int nAsk = std::min(16, nMsg - nRecv);
+
+                    for(int i = 0; i < nAsk; ++i)
+                    {
+                        msgs[i].buf = as_writable_bytes(std::span(vals + nRecv + i, 1));
+                    }
+
+                    size_t n = DSK_TRY socket.receive_batch(std::span(msgs, nAsk));
+                    CHECK(n >= 1);
+
+                    for(size_t i = 0; i < n; ++i)
+                    {
+                        CHECK(msgs[i].size == sizeof(int));
+                        CHECK(! msgs[i].truncated);
+                        CHECK(msgs[i].peer.address() == ip_addr_v4({127,0,0,1}));
+                    }
+
+                    nRecv += static_cast<int>(n);
+                }
+
+                for(int i = 0; i < nMsg; ++i)
+                {
+                    CHECK(vals[i] == i);
+                }
+
+                // 3 segments sent as one msg
+                std::byte seg[3 * 26];
+                udp_msg segMsgs[3];
+
+                for(auto& m : segMsgs)
+                {
+                    m.buf = std::span(seg);
+                }
+
+                int nSeg = 0;
+
+                while(nSeg < 3)
+                {
+                    size_t n = DSK_TRY socket.receive_batch(std::span(segMsgs, 3 - nSeg));
+
+                    for(size_t i = 0; i < n; ++i)
+                    {
+                        CHECK(segMsgs[i].size == 26);
+                    }
+
+                    nSeg += static_cast<int>(n);
+                }
+
+                DSK_RETURN();
+            }(),
+            // client
+            [&]() -> task<>
+            {
+                DSK_TRY wait_for(milliseconds(500));
+
+                udp_socket socket;
+                DSK_TRY_SYNC socket.open(srvEndpoint.protocol());
+
+                int vals[nMsg];
+                udp_msg msgs[nMsg];
+
+                for(int i = 0; i < nMsg; ++i)
+                {
+                    vals[i] = i;
+                    msgs[i].buf  = as_writable_bytes(std::span(vals + i, 1));
+                    msgs[i].peer = srvEndpoint;
+                }
+
+                size_t n = DSK_TRY socket.send_batch(msgs);
+                CHECK(n == nMsg);
+
+                std::byte seg[3 * 26] = {};
+                udp_msg segMsg{.buf = std::span(seg), .peer = srvEndpoint, .segSize = 26};
+
+                n = DSK_TRY socket.send_batch(std::span(&segMsg, 1));
+                CHECK(n == 1);
+                CHECK(segMsg.size == sizeof(seg));
+
+                DSK_RETURN();
+            }()
+        ));
+
+        CHECK(! has_err(r));
+
+    }// SUBCASE("udp_batch")
+
+
     SUBCASE("ssl")
     {
         auto r = sync_wait
@@ -312,6 +575,209 @@ TEST_CASE("asio")
         CHECK(! has_err(r));
     }// SUBCASE("file")
 
+
+    SUBCASE("send_file")
+    {
+        constexpr char const* srcPath = "test_asio_send_file.bin";
+        constexpr char const* dstPath = "test_asio_recv_file.bin";
+        constexpr size_t      offset  = 100;
+
+        string data(300*1024 + 7, '\0');
+
+        for(size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = static_cast<char>(i * 13);
+        }
+
+        auto r = sync_wait(until_all_succeeded
+        (
+            // receiver
+            [&]() -> task<>
+            {
+                tcp_acceptor acceptor(tcp_endpoint(tcp_v4(), 6264));
+                auto socket = DSK_TRY acceptor.accept();
+
+                size_t n = DSK_TRY recv_file(socket, dstPath, {.flags = file_base::create | file_base::truncate});
+                CHECK(n == data.size() - offset);
+
+                DSK_RETURN();
+            }(),
+            // sender
+            [&]() -> task<>
+            {
+                {
+                    stream_file file;
+                    DSK_TRY_SYNC file.open(srcPath, file_base::write_only | file_base::create | file_base::truncate);
+                    DSK_TRY file.write(data);
+                }
+
+                DSK_TRY wait_for(milliseconds(500));
+
+                tcp_socket socket;
+                DSK_TRY socket.connect(ip_addr_v4({127,0,0,1}), 6264);
+
+                size_t n = DSK_TRY send_file(socket, srcPath, {.offset = offset});
+                CHECK(n == data.size() - offset);
+
+                DSK_TRY_SYNC socket.shutdown(tcp_socket::shutdown_send);
+
+                DSK_RETURN();
+            }()
+        ));
+
+        CHECK(! has_err(r));
+
+        {
+            std::ifstream f(dstPath, std::ios::binary);
+            string received((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+            CHECK(received == std::string_view(data).substr(offset));
+        }
+
+        std::filesystem::remove(srcPath);
+        std::filesystem::remove(dstPath);
+
+    }// SUBCASE("send_file")
+
+
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_HAS_FILE)
+    SUBCASE("io_uring_fixed")
+    {
+        auto& svc = get_io_uring_fixed_service();
+
+        if(! svc.initialized())
+        {
+            CHECK(! svc.init({.bufCount = 4, .bufSize = 4096, .fileCount = 4}));
+        }
+
+        auto r = sync_wait
+        (
+            [&]() -> task<>
+            {
+                constexpr char const* path = "test_asio_io_uring_fixed.bin";
+                constexpr std::string_view data = "io_uring registered buffer";
+
+                random_access_file file;
+                DSK_TRY_SYNC file.open(path, file_base::read_write | file_base::create | file_base::truncate);
+
+                auto wb = DSK_TRY svc.acquire_buf();
+                CHECK(wb->size == 4096);
+                std::memcpy(wb->data, data.data(), data.size());
+
+                size_t n = DSK_TRY write_some_fixed_at(file, 0, *wb, data.size());
+                CHECK(n == data.size());
+
+                auto ff = DSK_TRY_SYNC svc.register_file(file.native_handle());
+                auto rb = DSK_TRY_SYNC svc.try_acquire_buf();
+                CHECK(rb->index != wb->index);
+
+                n = DSK_TRY svc.read_fixed(ff, 0, *rb);
+                CHECK(n == data.size());
+                CHECK(std::string_view(reinterpret_cast<char const*>(rb->data), n) == data);
+
+                // both are queued in the same turn, so submitted as one batch.
+                auto[n1, n2] = DSK_TRY until_all_succeeded(read_some_fixed_at(file, 0, *wb),
+                                                           svc.read_fixed(ff, 9, *rb));
+                CHECK(n1 == data.size());
+                CHECK(n2 == data.size() - 9);
+                CHECK(std::string_view(reinterpret_cast<char const*>(rb->data), n2) == data.substr(9));
+
+                // position of stream_file is tracked by asio, fixed ops would bypass it.
+                static_assert(! requires(stream_file& f, io_uring_fixed_buf const& b){ read_some_fixed(f, b); });
+                static_assert(! requires(stream_file& f, io_uring_fixed_buf const& b){ read_some_fixed_at(f, 0, b); });
+
+                DSK_TRY_SYNC svc.unregister_file(ff);
+                DSK_TRY_SYNC file.close();
+                std::filesystem::remove(path);
+
+                DSK_RETURN();
+            }()
+        );
+
+        CHECK(! has_err(r));
+    }// SUBCASE("io_uring_fixed")
+#endif
+
+#ifdef BOOST_ASIO_HAS_IO_URING
+    SUBCASE("io_uring_stream")
+    {
+        auto& svc = get_io_uring_fixed_service();
+
+        if(! svc.initialized())
+        {
+            CHECK(! svc.init({.bufCount = 4, .bufSize = 4096, .fileCount = 4}));
+        }
+
+        if(! svc.recv_buf_count())
+        {
+            CHECK(! svc.init_recv_bufs(4, 4096)); // less than data, so some recv get -ENOBUFS.
+        }
+
+        string data(64*1024 + 26, '\0');
+
+        for(size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = static_cast<char>(i * 7);
+        }
+
+        auto r = sync_wait(until_all_succeeded
+        (
+            // server
+            [&]() -> task<>
+            {
+                tcp_acceptor acceptor(tcp_endpoint(tcp_v4(), 6265));
+                auto sockets = accept_stream(acceptor);
+
+                auto s0 = DSK_TRY sockets.next();
+                auto s1 = DSK_TRY sockets.next();
+                CHECK(s0);
+                CHECK(s1);
+
+                auto recv_all = [&](tcp_socket& s) -> task<>
+                {
+                    auto bufs = recv_stream(s);
+                    string got;
+
+                    while(auto b = DSK_TRY bufs.next())
+                    {
+                        CHECK(b->size() <= svc.recv_buf_size());
+                        got.append(reinterpret_cast<char const*>(b->data()), b->size());
+                    }
+
+                    CHECK(got == data);
+                    DSK_RETURN();
+                };
+
+                DSK_TRY until_all_succeeded(recv_all(*s0), recv_all(*s1));
+
+                DSK_RETURN();
+            }(),
+            // clients
+            [&]() -> task<>
+            {
+                DSK_TRY wait_for(milliseconds(500));
+
+                auto send_all = [&]() -> task<>
+                {
+                    tcp_socket socket;
+                    DSK_TRY socket.connect(ip_addr_v4({127,0,0,1}), 6265);
+
+                    size_t n = DSK_TRY socket.write(data);
+                    CHECK(n == data.size());
+
+                    DSK_TRY_SYNC socket.shutdown(tcp_socket::shutdown_send);
+                    DSK_RETURN();
+                };
+
+                DSK_TRY until_all_succeeded(send_all(), send_all());
+
+                DSK_RETURN();
+            }()
+        ));
+
+        CHECK(! has_err(r));
+    }// SUBCASE("io_uring_stream")
+#endif
+
 #endif // BOOST_ASIO_HAS_FILE
 
 } // TEST_CASE("asio")
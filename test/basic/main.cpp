@@ -4,17 +4,30 @@
 
 #include <dsk/task.hpp>
 #include <dsk/generator.hpp>
+#include <dsk/generator_stages.hpp>
 #include <dsk/until.hpp>
+#include <dsk/async_op_group.hpp>
 #include <dsk/sync_wait.hpp>
 #include <dsk/start_on.hpp>
 #include <dsk/resume_on.hpp>
+#include <dsk/prio_scheduler.hpp>
 #include <dsk/res_pool.hpp>
 #include <dsk/res_queue.hpp>
+#include <dsk/lf_res_queue.hpp>
+#include <dsk/async_mutex.hpp>
+#include <dsk/async_semaphore.hpp>
+#include <dsk/async_event.hpp>
 #include <dsk/asio/timer.hpp>
 #include <dsk/util/atomic.hpp>
+#include <dsk/util/recycling_allocator.hpp>
+#include <dsk/util/frame_arena.hpp>
 #include <dsk/tbb/thread_pool.hpp>
 #include <dsk/asio/thread_pool.hpp>
 #include <dsk/simple_thread_pool.hpp>
+#include <dsk/trace.hpp>
+#include <numeric>
+#include <fstream>
+#include <filesystem>
 #ifdef BOOST_WINDOWS
     #include <dsk/win/thread_pool.hpp>
 #endif
@@ -53,11 +66,32 @@ void test_fib(char const* name, int n = 6)
 
     CHECK(! has_err(r));
     CHECK(get_val(r) == fib_sync(n));
+
+    if constexpr(scheduler_stats_enabled && requires{ sh.stats(); })
+    {
+        auto s = sh.stats();
+        CHECK(s.posted() > 0);
+        CHECK(s.postToRun.count() > 0);
+    }
 }
 
 #define _FIB_TEST(sh) test_fib<sh>(#sh)
 
 
+// spin until pred() is true or timeout, return pred().
+bool wait_until_true(auto&& pred, std::chrono::steady_clock::duration timeout = std::chrono::seconds(5))
+{
+    auto end = std::chrono::steady_clock::now() + timeout;
+
+    while(! pred() && std::chrono::steady_clock::now() < end)
+    {
+        this_thread::yield();
+    }
+
+    return pred();
+}
+
+
 TEST_CASE("basic")
 {
     SUBCASE("scheduler_fib")
@@ -66,7 +100,9 @@ TEST_CASE("basic")
         _FIB_TEST(tbb_thread_pool);
         _FIB_TEST(asio_thread_pool);
         _FIB_TEST(asio_io_thread_pool);
+        _FIB_TEST(asio_sharded_io_thread_pool);
         _FIB_TEST(simple_thread_pool);
+        _FIB_TEST(lock_free_thread_pool);
         _FIB_TEST(naive_thread_pool);
     #ifdef BOOST_WINDOWS
         _FIB_TEST(win_thread_pool);
@@ -147,6 +183,437 @@ TEST_CASE("basic")
     } // SUBCASE("resumer")
 
 
+    SUBCASE("post_bulk")
+    {
+        auto test = [](auto& sch)
+        {
+            atomic<int> n = 0;
+
+            auto r = sync_wait(until_all_done(1000, [&]()
+            {
+                return start_on(sch, [&]() -> task<>
+                {
+                    ++n;
+                    DSK_RETURN();
+                }());
+            }));
+
+            CHECK(! has_err(r));
+            CHECK(n == 1000);
+
+            vector<continuation> conts;
+
+            for(int i = 0; i < 1000; ++i)
+            {
+                conts.emplace_back([&](){ ++n; });
+            }
+
+            any_resumer(sch).post_bulk(conts);
+
+            while(n < 2000)
+            {
+                this_thread::yield();
+            }
+        };
+
+        simple_thread_pool    sch1(start_now);
+        lock_free_thread_pool sch2(start_now);
+        naive_thread_pool     sch3(start_now);
+
+        test(sch1);
+        test(sch2);
+        test(sch3);
+
+    } // SUBCASE("post_bulk")
+
+
+    SUBCASE("bulk_start_order")
+    {
+        // start_on() ops collected for post_bulk() are posted before a following op is started,
+        // so on a single FIFO worker jobs run in order of ops.
+        simple_thread_pool sch(1, start_now);
+        vector<int>        order; // only accessed on the single worker
+
+        auto r = sync_wait(until_all_done
+        (
+            start_on(sch, [&]() -> task<> { order.emplace_back(0); DSK_RETURN(); }()),
+            start_on(sch, [&]() -> task<> { order.emplace_back(1); DSK_RETURN(); }()),
+            [&]() -> task<> // not bulk startable, posts on initiation
+            {
+                DSK_TRY resume_on(sch);
+                order.emplace_back(2);
+                DSK_RETURN();
+            }(),
+            start_on(sch, [&]() -> task<> { order.emplace_back(3); DSK_RETURN(); }())
+        ));
+
+        CHECK(! has_err(r));
+        CHECK(order == vector<int>{0, 1, 2, 3});
+
+    } // SUBCASE("bulk_start_order")
+
+
+    SUBCASE("simple_thread_pool_next_slot")
+    {
+        auto test = [&]<class Pool>(std::type_identity<Pool>)
+        {
+            constexpr bool lockFree = std::is_same_v<Pool, lock_free_thread_pool>;
+            constexpr auto timeout  = std::chrono::seconds(5);
+
+            // a job posted from a worker runs on the same worker.
+            {
+                Pool        pool(4, start_now);
+                atomic<int> nSame = 0;
+                atomic<int> nDone = 0;
+
+                for(int i = 0; i < 100; ++i)
+                {
+                    pool.post([&]()
+                    {
+                        pool.post([&, id = this_thread::get_id()]()
+                        {
+                            if(this_thread::get_id() == id)
+                                ++nSame;
+
+                            ++nDone;
+                        });
+                    });
+                }
+
+                CHECK(wait_until_true([&](){ return nDone == 100; }, timeout));
+                CHECK(nSame == 100);
+            }
+
+            // a job reposting itself, like a ping-pong pair, runs from next slot at most next_max_runs times
+            // in a row, so a job queued before it still runs.
+            {
+                Pool         pool(1, start_now);
+                atomic<bool> xRan = false;
+                atomic<int>  pings = 0;
+                atomic<int>  pingsBeforeX = -1;
+
+                pool.post([&]()
+                {
+                    // moved out of next slot into queue by the ping below.
+                    pool.post([&](){ pingsBeforeX = pings.load(); xRan = true; });
+
+                    pool.post([&](this auto&& self) -> void
+                    {
+                        if(! xRan && ++pings < 1000)
+                            pool.post(self);
+                    });
+                });
+
+                CHECK(wait_until_true([&](){ return xRan.load(); }, timeout));
+                CHECK(pingsBeforeX >= 0);
+                CHECK(pingsBeforeX <= 8);
+            }
+
+            // with next slot disabled, posts from a worker are queued like others.
+            if constexpr(lockFree)
+            {
+                // it goes to the worker's deque, where an idle worker can steal it,
+                // while it would be stuck in next slot of the blocked worker.
+                Pool pool(2);
+                pool.set_next_slot_enabled(false);
+                pool.start();
+
+                atomic<bool> childRan = false;
+                atomic<bool> parentSawChild = false;
+
+                pool.post([&]()
+                {
+                    pool.post([&](){ childRan = true; });
+                    parentSawChild = wait_until_true([&](){ return childRan.load(); }, timeout);
+                });
+
+                CHECK(wait_until_true([&](){ return parentSawChild.load(); }, 2 * timeout));
+            }
+            else
+            {
+                // FIFO on a single worker, rather than the last posted first.
+                Pool pool(1);
+                pool.set_next_slot_enabled(false);
+                pool.start();
+
+                vector<int>  order; // only accessed on the single worker
+                atomic<bool> done = false;
+
+                pool.post([&]()
+                {
+                    pool.post([&](){ order.emplace_back(1); });
+                    pool.post([&](){ order.emplace_back(2); done = true; });
+                });
+
+                CHECK(wait_until_true([&](){ return done.load(); }, timeout));
+                CHECK(order == vector<int>{1, 2});
+            }
+        };
+
+        test(std::type_identity<simple_thread_pool>());
+        test(std::type_identity<lock_free_thread_pool>());
+
+    } // SUBCASE("simple_thread_pool_next_slot")
+
+
+    SUBCASE("lock_free_thread_pool")
+    {
+        // external posts beyond capacity of the bounded injection queue go to the overflow queue.
+        {
+            lock_free_thread_pool pool(1, start_now);
+
+            atomic<bool> release = false;
+            atomic<int>  n = 0;
+            int const    total = 10000; // > lf_inject_cap
+
+            pool.post([&](){ wait_until_true([&](){ return release.load(); }); }); // keep the worker busy
+
+            for(int i = 0; i < total; ++i)
+            {
+                pool.post([&](){ ++n; });
+            }
+
+            release = true;
+
+            CHECK(wait_until_true([&](){ return n == total; }));
+        }
+
+        // jobs in the deque of a blocked worker are stolen by idle ones.
+        {
+            lock_free_thread_pool pool(4, start_now);
+
+            atomic<int>  nStolen = 0;
+            atomic<int>  nDone = 0;
+            atomic<bool> allDone = false;
+
+            pool.post([&]()
+            {
+                vector<continuation> conts;
+
+                for(int i = 0; i < 100; ++i)
+                {
+                    conts.emplace_back([&, id = this_thread::get_id()]()
+                    {
+                        if(this_thread::get_id() != id)
+                            ++nStolen;
+
+                        ++nDone;
+                    });
+                }
+
+                pool.post_bulk(conts); // to own deque
+
+                allDone = wait_until_true([&](){ return nDone == 100; });
+            });
+
+            CHECK(wait_until_true([&](){ return allDone.load(); }, std::chrono::seconds(10)));
+            CHECK(nStolen == 100);
+        }
+
+        // parked workers are woken up by later posts.
+        {
+            lock_free_thread_pool pool(2, start_now);
+
+            atomic<int> n = 0;
+
+            for(int i = 1; i <= 20; ++i)
+            {
+                // give workers time to run out of jobs and park.
+                auto idleEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(5);
+                wait_until_true([&](){ return std::chrono::steady_clock::now() >= idleEnd; });
+
+                pool.post([&](){ ++n; });
+
+                REQUIRE(wait_until_true([&](){ return n == i; }));
+            }
+        }
+
+        // stop_and_join() with jobs still queued frees them without running,
+        // and the pool can be started again.
+        {
+            lock_free_thread_pool pool(1, start_now);
+
+            atomic<bool> release = false;
+            atomic<int>  nRan = 0;
+            auto         token = std::make_shared<int>(0); // captured by each job
+
+            pool.post([&](){ wait_until_true([&](){ return release.load(); }); });
+
+            for(int i = 0; i < 1000; ++i)
+            {
+                pool.post([&, token](){ ++nRan; });
+            }
+
+            thread stopper([&](){ pool.stop_and_join(); });
+
+            // stop() is done by stopper before the busy job ends, unless it's scheduled very late,
+            // in which case some jobs may run, either way none should be leaked.
+            auto stopEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+            wait_until_true([&](){ return std::chrono::steady_clock::now() >= stopEnd; });
+            release = true;
+
+            stopper.join();
+
+            CHECK(! pool.started());
+            CHECK(token.use_count() == 1);
+
+            pool.start();
+
+            atomic<bool> ran = false;
+            pool.post([&](){ ran = true; });
+            CHECK(wait_until_true([&](){ return ran.load(); }));
+        }
+
+    } // SUBCASE("lock_free_thread_pool")
+
+
+    SUBCASE("prio_scheduler")
+    {
+        simple_thread_pool pool(1); // not started, so all jobs below are queued before any runs.
+        prio_scheduler     ps(pool);
+        vector<int>        order;   // only accessed on the single worker
+
+        for(int i = 0; i < 4; ++i) ps.post(prio_low , [&, i](){ order.emplace_back(100 + i); });
+        for(int i = 0; i < 4; ++i) ps.post(prio_high, [&, i](){ order.emplace_back(i); });
+
+        pool.start();
+
+        auto r = sync_wait
+        (
+            [&]() -> task<>
+            {
+                DSK_TRY resume_on(prio_resumer(ps, prio_low));
+                CHECK(order == vector<int>{0, 1, 2, 3, 100, 101, 102, 103});
+
+                DSK_TRY run_on(prio_resumer(ps, prio_high), [&]() -> task<>
+                {
+                    CHECK(DSK_WAIT get_resumer() == prio_resumer(ps, prio_high));
+                    CHECK(DSK_WAIT get_resumer() != prio_resumer(ps, prio_low));
+                    DSK_RETURN();
+                }());
+
+                DSK_RETURN();
+            }()
+        );
+
+        CHECK(! has_err(r));
+
+        // low lane is run after being skipped maxSkips times.
+        simple_thread_pool pool2(1);
+        prio_scheduler     ps2(pool2, 2);
+        vector<int>        order2;
+
+        ps2.post(prio_low, [&](){ order2.emplace_back(100); });
+        for(int i = 0; i < 4; ++i) ps2.post(prio_high, [&, i](){ order2.emplace_back(i); });
+
+        pool2.start();
+
+        while(ps2.size(prio_high) || ps2.size(prio_low))
+        {
+            this_thread::yield();
+        }
+
+        pool2.stop_and_join();
+        CHECK(order2 == vector<int>{0, 1, 100, 2, 3});
+
+    } // SUBCASE("prio_scheduler")
+
+
+    SUBCASE("numa_topology")
+    {
+        CHECK(parse_cpu_list("0-2,5,8-9\n") == vector<unsigned>{0, 1, 2, 5, 8, 9});
+        CHECK(parse_cpu_list("3-1").empty());
+
+        vector<numa_node_info> nodes;
+        nodes.emplace_back(1u, parse_cpu_list("1,3"));
+        nodes.emplace_back(0u, parse_cpu_list("0,2"));
+        nodes.emplace_back(2u, vector<unsigned>()); // ignored
+
+        cpu_topology topo(mut_move(nodes));
+
+        CHECK(topo.node_count() == 2);
+        CHECK(topo.cpus_by_node() == vector<unsigned>{0, 2, 1, 3});
+        CHECK(topo.node_of_cpu(3) == 1);
+        CHECK(topo.node_of_worker(1, 4) == 0);
+        CHECK(topo.node_of_worker(2, 4) == 1);
+
+        auto test = [&](auto& pool)
+        {
+            pool.set_cpu_topology(&topo);
+            pool.start();
+
+            CHECK(pool.node_count() == 2);
+            CHECK(pool.current_node() == -1);
+
+            auto r = sync_wait
+            (
+                [&]() -> task<>
+                {
+                    for(size_t k = 0; k < 2; ++k)
+                    {
+                        DSK_TRY resume_on(scheudler_resumer(pool.node_scheduler(k)));
+
+                        // scheduled on node k first, but may be stolen by other node,
+                        // only checks it's on the pool.
+                        CHECK(pool.current_node() >= 0);
+                    }
+
+                    DSK_RETURN();
+                }()
+            );
+
+            CHECK(! has_err(r));
+            pool.stop_and_join();
+        };
+
+        simple_thread_pool    sch1(4);
+        lock_free_thread_pool sch2(4);
+
+        test(sch1);
+        test(sch2);
+
+    } // SUBCASE("numa_topology")
+
+
+    SUBCASE("trace")
+    {
+        auto path = (std::filesystem::temp_directory_path() / "dsk_test.trace.json").string();
+
+        CHECK(tracer::instance().start(path.c_str(), std::chrono::milliseconds(1)));
+        CHECK(! tracer::instance().start(path.c_str()));
+
+        simple_thread_pool pool(2, start_now);
+
+        auto r = sync_wait
+        (
+            [&]() -> task<>
+            {
+                DSK_TRY resume_on(pool);
+                DSK_TRY resume_on(pool);
+                DSK_RETURN();
+            }()
+        );
+
+        CHECK(! has_err(r));
+        tracer::instance().stop();
+
+        std::ifstream f(path);
+        std::string   s((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+        CHECK(s.starts_with(R"({"displayTimeUnit":"ns","traceEvents":[)"));
+        CHECK(s.ends_with("]}\n"));
+
+        if constexpr(tracing_enabled)
+        {
+            CHECK(s.find(R"("name":"run")") != std::string::npos);
+            CHECK(s.find(R"("name":"job")") != std::string::npos);
+        }
+
+        std::filesystem::remove(path);
+
+    } // SUBCASE("trace")
+
+
     SUBCASE("res_pool")
     {
         auto creator = [i = 0](auto emplace) mutable { emplace(++i); };
@@ -186,6 +653,37 @@ TEST_CASE("basic")
     } // SUBCASE("res_pool")
 
 
+    SUBCASE("res_pool_cancel")
+    {
+        res_pool<> pool(1);
+
+        auto r = sync_wait([&]() -> task<>
+        {
+            auto v = DSK_TRY_SYNC pool.try_acquire();
+
+            auto rs = DSK_TRY until_all_done(100, [&]()
+            {
+                return wait_for(std::chrono::milliseconds(10), pool.acquire());
+            });
+
+            for(auto& r : rs)
+            {
+                CHECK(is_err(r, errc::timeout));
+            }
+
+            v.recycle(); // no waiter left
+
+            auto v2 = DSK_TRY_SYNC pool.try_acquire();
+            CHECK(v2.valid());
+
+            DSK_RETURN();
+        }());
+
+        CHECK(! has_err(r));
+
+    } // SUBCASE("res_pool_cancel")
+
+
     SUBCASE("res_pool_map")
     {
         atomic<int> i;
@@ -291,6 +789,238 @@ TEST_CASE("basic")
     } // SUBCASE("res_queue")
 
 
+    SUBCASE("res_queue_bulk")
+    {
+        res_queue<int> queue(3);
+
+        auto r = sync_wait(until_all_done
+        (
+            run_on(DSK_DEFAULT_IO_SCHEDULER, [&]() -> task<>
+            {
+                vector<int> vs{1, 2, 3, 4, 5, 6, 7, 8};
+                DSK_TRY queue.enqueue_bulk(vs);
+
+                DSK_TRY wait_for(std::chrono::milliseconds(500));
+                queue.mark_end();
+
+                DSK_RETURN();
+            }()),
+            run_on(DSK_DEFAULT_IO_SCHEDULER, [&]() -> task<>
+            {
+                vector<int> vs;
+
+                for(;;)
+                {
+                    auto n = DSK_WAIT queue.dequeue_up_to(2, vs);
+
+                    if(is_err(n, errc::end_reached))
+                        break;
+
+                    CHECK(get_val(n) > 0);
+                    CHECK(get_val(n) <= 2);
+                }
+
+                CHECK(vs == vector<int>{1, 2, 3, 4, 5, 6, 7, 8});
+                CHECK(queue.stats().enqueueItems == 8);
+                CHECK(queue.stats().dequeueItems == 8);
+
+                DSK_RETURN();
+            }())
+        ));
+
+        CHECK(! has_err(r));
+        CHECK(! has_err(get_elm<0>(get_val(r))));
+        CHECK(! has_err(get_elm<1>(get_val(r))));
+
+    } // SUBCASE("res_queue_bulk")
+
+
+    SUBCASE("lf_res_queue")
+    {
+        auto test = [](auto& queue, int nProducer, int nConsumer)
+        {
+            int const n = 10000;
+            atomic<long long> sum = 0;
+
+            auto r = sync_wait(until_all_done
+            (
+                [&]() -> task<>
+                {
+                    DSK_TRY until_all_done(nProducer, [&]()
+                    {
+                        return run_on(DSK_DEFAULT_IO_SCHEDULER, [](auto& queue, int n) -> task<>
+                        {
+                            for(int i = 1; i <= n; ++i)
+                            {
+                                DSK_TRY queue.enqueue(i);
+                            }
+
+                            DSK_RETURN();
+                        }(queue, n));
+                    });
+
+                    queue.mark_end();
+                    DSK_RETURN();
+                }(),
+                until_all_done(nConsumer, [&]()
+                {
+                    return run_on(DSK_DEFAULT_IO_SCHEDULER, [](auto& queue, auto& sum) -> task<>
+                    {
+                        for(;;)
+                        {
+                            auto v = DSK_WAIT queue.dequeue();
+
+                            if(is_err(v, errc::end_reached))
+                                break;
+
+                            CHECK(! has_err(v));
+                            sum += get_val(v);
+                        }
+
+                        DSK_RETURN();
+                    }(queue, sum));
+                })
+            ));
+
+            CHECK(! has_err(r));
+            CHECK(sum == nProducer * (n * (n + 1ll) / 2));
+            CHECK(queue.stats().enqueueItems == size_t(nProducer * n));
+            CHECK(queue.stats().dequeueItems == size_t(nProducer * n));
+            CHECK(is_err(queue.try_enqueue(1), errc::end_reached));
+            CHECK(is_err(queue.try_dequeue(), errc::end_reached));
+        };
+
+        res_queue_spsc<int> spsc(8);
+        res_queue_mpmc<int> mpmc(8);
+
+        test(spsc, 1, 1);
+        test(mpmc, 4, 4);
+
+        // rings construct elements on push and destroy them on pop or at destruction,
+        // T needn't be default constructible.
+        struct elem_t
+        {
+            int* alive;
+            int  v;
+
+            elem_t(int* a, int x) : alive(a), v(x) { ++*alive; }
+            elem_t(elem_t&& r) noexcept : alive(r.alive), v(r.v) { ++*alive; }
+            ~elem_t() { --*alive; }
+        };
+
+        static_assert(! std::is_default_constructible_v<elem_t>);
+
+        auto testRing = [](auto& ring, int& alive)
+        {
+            for(int i = 0; i < 4; ++i)
+                CHECK(ring.try_push(elem_t(&alive, i)));
+
+            CHECK(! ring.try_push(elem_t(&alive, 4)));
+            CHECK(alive == 4);
+
+            auto e = ring.try_pop();
+            REQUIRE(e);
+            CHECK(e->v == 0);
+            e.reset();
+            CHECK(alive == 3);
+        };
+
+        int alive = 0;
+        {
+            bounded_spsc_queue<elem_t> ring(4);
+            testRing(ring, alive);
+        }
+        CHECK(alive == 0);
+        {
+            bounded_mpmc_queue<elem_t> ring(4);
+            testRing(ring, alive);
+        }
+        CHECK(alive == 0);
+
+    } // SUBCASE("lf_res_queue")
+
+
+    SUBCASE("async_sync")
+    {
+        async_mutex        mtx;
+        async_shared_mutex smtx;
+        async_semaphore    sem(3);
+        async_event        ev;
+
+        int n = 0;
+        atomic<int> nInSem = 0;
+        atomic<int> nReader = 0;
+
+        auto r = sync_wait(until_all_done
+        (
+            until_all_done(100, [&]()
+            {
+                return run_on(DSK_DEFAULT_IO_SCHEDULER, [](auto& mtx, auto& smtx, auto& sem, auto& ev,
+                                                           int& n, auto& nInSem, auto& nReader) -> task<>
+                {
+                    DSK_TRY ev.wait();
+
+                    {
+                        auto lk = DSK_TRY mtx.scoped_lock();
+                        ++n;
+                    }
+
+                    {
+                        auto g = DSK_TRY sem.scoped_acquire();
+                        CHECK(++nInSem <= 3);
+                        DSK_TRY wait_for(std::chrono::milliseconds(1));
+                        --nInSem;
+                    }
+
+                    {
+                        auto lk = DSK_TRY smtx.scoped_lock_shared();
+                        ++nReader;
+                        DSK_TRY wait_for(std::chrono::milliseconds(1));
+                        --nReader;
+                    }
+
+                    {
+                        auto lk = DSK_TRY smtx.scoped_lock();
+                        CHECK(nReader == 0);
+                    }
+
+                    DSK_RETURN();
+                }(mtx, smtx, sem, ev, n, nInSem, nReader));
+            }),
+            [&]() -> task<>
+            {
+                DSK_TRY wait_for(std::chrono::milliseconds(100));
+                ev.set();
+                DSK_RETURN();
+            }()
+        ));
+
+        CHECK(! has_err(r));
+        CHECK(n == 100);
+        CHECK(sem.available() == 3);
+        CHECK(mtx.try_lock());
+        mtx.unlock();
+
+        // canceled waiter doesn't block others
+        auto r2 = sync_wait([&]() -> task<>
+        {
+            DSK_TRY mtx.lock();
+
+            auto r = DSK_WAIT wait_for(std::chrono::milliseconds(10), mtx.lock());
+            CHECK(is_err(r, errc::timeout));
+
+            mtx.unlock();
+            CHECK(mtx.try_lock());
+            mtx.unlock();
+
+            DSK_RETURN();
+        }());
+
+        CHECK(! has_err(r2));
+
+    } // SUBCASE("async_sync")
+
+
     SUBCASE("cleanup_scopes")
     {
         auto r = sync_wait
@@ -341,6 +1071,148 @@ TEST_CASE("basic")
     } // SUBCASE("cleanup_scopes")
 
 
+    SUBCASE("until_all_done_bounded")
+    {
+        vector<int> items(200);
+        std::iota(items.begin(), items.end(), 0);
+
+        atomic<int> inFlight = 0;
+        atomic<int> maxInFlight = 0;
+
+        auto gen = [&](int i)
+        {
+            return run_on(DSK_DEFAULT_IO_SCHEDULER, [](int i, auto& inFlight, auto& maxInFlight) -> task<int>
+            {
+                int n = ++inFlight;
+                int m = maxInFlight;
+                while(n > m && ! maxInFlight.compare_exchange_weak(m, n));
+
+                DSK_TRY wait_for(std::chrono::milliseconds(1));
+                --inFlight;
+
+                if(i == 150)
+                    DSK_THROW(errc::not_found);
+
+                DSK_RETURN(i * 2);
+            }(i, inFlight, maxInFlight));
+        };
+
+        auto r = sync_wait(until_all_done_bounded(items, 8, gen));
+        CHECK(! has_err(r));
+        CHECK(get_val(r).size() == items.size());
+        CHECK(maxInFlight <= 8);
+
+        for(int i = 0; i < 200; ++i)
+        {
+            if(i == 150) CHECK(is_err(get_val(r)[i], errc::not_found));
+            else         CHECK(get_val(get_val(r)[i]) == i * 2);
+        }
+
+        auto r2 = sync_wait(async_transform(items, 8, gen));
+        CHECK(is_err(r2, errc::failed));
+
+        vector<int> items2(items.begin(), items.begin() + 100);
+        auto r3 = sync_wait(async_transform_unordered(mut_move(items2), 4, gen));
+        CHECK(! has_err(r3));
+        CHECK(std::accumulate(get_val(r3).begin(), get_val(r3).end(), 0) == 99 * 100);
+        CHECK(maxInFlight <= 8);
+
+        // ops invoking their continuations in place, which start the next ops of their slots.
+        res_queue<int> q(items.size());
+
+        auto r4 = sync_wait(until_all_done
+        (
+            until_all_done_bounded(items, 4, [&](int){ return q.dequeue(); }),
+            [&]() -> task<>
+            {
+                for(int i : items)
+                {
+                    DSK_TRY q.enqueue(i);
+                }
+
+                DSK_RETURN();
+            }()
+        ));
+
+        CHECK(! has_err(r4));
+        CHECK(! has_err(get_elm<1>(get_val(r4))));
+
+        auto& popped = get_elm<0>(get_val(r4));
+        CHECK(! has_err(popped));
+        CHECK(get_val(popped).size() == items.size());
+
+        int popSum = 0;
+
+        for(auto& v : get_val(popped))
+        {
+            popSum += get_val(v);
+        }
+
+        CHECK(popSum == 199 * 200 / 2);
+
+        auto r5 = sync_wait(until_all_done_bounded(items, 8, [](int)
+        {
+            return wait_for(std::chrono::milliseconds(1));
+        }));
+
+        CHECK(! has_err(r5));
+        CHECK(get_val(r5).size() == items.size());
+
+        for(auto& v : get_val(r5))
+        {
+            CHECK(! has_err(v));
+        }
+
+    } // SUBCASE("until_all_done_bounded")
+
+
+    SUBCASE("inplace_stop_source")
+    {
+        inplace_stop_source s;
+        int                 n = 0;
+
+        {
+            inplace_stop_callback  cb(s.get_token(), [&](){ ++n; });
+            optional_stop_callback ocb;
+
+            ocb.emplace(s, [&](){ n += 10; });
+
+            CHECK(s.request_stop());
+            CHECK(! s.request_stop());
+        }
+
+        CHECK(n == 11);
+
+        inplace_stop_callback cb2(s.get_token(), [&](){ n += 100; }); // already requested, invoked immediately
+        CHECK(n == 111);
+
+        inplace_stop_source s2;
+
+        auto r = sync_wait
+        (
+            [&]() -> task<>
+            {
+                auto ss = DSK_WAIT get_stop_source();
+                CHECK(ss.is_inplace());
+
+                std_stop_token_bridge br(ss);
+                CHECK(! br.get_token().stop_requested());
+
+                DSK_WAIT request_stop();
+                CHECK(s2.stop_requested());
+                CHECK(br.get_token().stop_requested());
+
+                DSK_TRY wait_for(std::chrono::milliseconds(1000));
+                DSK_RETURN();
+            }(),
+            std::ref(s2)
+        );
+
+        CHECK(is_err(r, errc::canceled));
+
+    } // SUBCASE("inplace_stop_source")
+
+
     SUBCASE("generator")
     {
         auto r = sync_wait
@@ -396,4 +1268,270 @@ TEST_CASE("basic")
 
     } // SUBCASE("generator")
 
+
+    SUBCASE("generator_stages")
+    {
+        simple_thread_pool sch(2, start_now);
+
+        auto r = sync_wait
+        (
+            [&]() -> task<>
+            {
+                auto iota = [](int n) -> generator<int>
+                {
+                    for(int i = 0; i < n; ++i)
+                    {
+                        DSK_YIELD i;
+                    }
+
+                    DSK_RETURN();
+                };
+
+                {
+                    auto g = buffered(iota(100), 8, sch);
+                    int  n = 0;
+
+                    while(auto v = DSK_TRY g.next())
+                    {
+                        CHECK(*v == n++);
+                    }
+
+                    CHECK(n == 100);
+                }
+                {
+                    auto g = map_on(iota(100), sch, [](int i){ return i * 2; }, 4);
+                    int  n = 0;
+
+                    while(auto v = DSK_TRY g.next())
+                    {
+                        CHECK(*v == 2 * n++);
+                    }
+
+                    CHECK(n == 100);
+                }
+                {
+                    auto g = batch(iota(10), 4);
+                    vector<size_t> sizes;
+
+                    while(auto v = DSK_TRY g.next())
+                    {
+                        sizes.emplace_back(v->size());
+                    }
+
+                    CHECK(sizes == vector<size_t>{4, 4, 2});
+                }
+                {
+                    auto g = merge(iota(10), iota(20), iota(30));
+                    int  n = 0, sum = 0;
+
+                    while(auto v = DSK_TRY g.next())
+                    {
+                        ++n;
+                        sum += *v;
+                    }
+
+                    CHECK(n == 60);
+                    CHECK(sum == 45 + 190 + 435);
+                }
+                {
+                    // the first error stops the rest, of which errors caused by the stop are not reported.
+                    auto endless = []() -> generator<int>
+                    {
+                        for(int i = 0;; ++i)
+                        {
+                            DSK_TRY wait_for(std::chrono::milliseconds(1));
+                            DSK_YIELD i;
+                        }
+                    };
+
+                    auto failing = []() -> generator<int>
+                    {
+                        DSK_YIELD -1;
+                        DSK_TRY wait_for(std::chrono::milliseconds(10));
+                        DSK_THROW(errc::failed);
+                    };
+
+                    auto g = merge(endless(), failing());
+                    bool failed = false;
+
+                    for(;;)
+                    {
+                        auto v = DSK_WAIT g.next();
+
+                        if(has_err(v))
+                        {
+                            failed = is_err(v, errc::failed);
+                            break;
+                        }
+
+                        REQUIRE(get_val(v));
+                    }
+
+                    CHECK(failed);
+                }
+
+                // abandoned before end, pump is stopped on cleanup.
+                DSK_CLEANUP_SCOPE
+                (
+                    auto g = buffered(iota(1000), 4, sch);
+                    CHECK(DSK_TRY g.next() == optional(0));
+                );
+
+                DSK_RETURN();
+            }()
+        );
+
+        CHECK(! has_err(r));
+
+    } // SUBCASE("generator_stages")
+
+
+    SUBCASE("recycling_allocator")
+    {
+        using alloc_t = recycling_allocator<>;
+
+        auto before = alloc_t::stats();
+
+        auto r = sync_wait([](this auto&& self, int n) -> task<int, error_code, alloc_t>
+        {
+            if(n < 2)
+                DSK_RETURN(n);
+
+            DSK_RETURN(DSK_TRY self(n - 1) + DSK_TRY self(n - 2));
+        }(10));
+
+        CHECK(! has_err(r));
+        CHECK(get_val(r) == fib_sync(10));
+
+        auto after = alloc_t::stats();
+
+        CHECK(after.allocTotal > before.allocTotal);
+        CHECK(after.alloc_hit() > before.alloc_hit()); // sibling frames reuse freed ones
+
+    } // SUBCASE("recycling_allocator")
+
+
+    SUBCASE("frame_arena")
+    {
+        using arena_t = frame_arena<>;
+        using alloc_t = frame_arena_allocator<>;
+
+        auto r = sync_wait([]() -> task<int, error_code, alloc_t>
+        {
+            CHECK(! arena_t::current());
+
+            DSK_WAIT use_frame_arena(4096);
+
+            auto* a = arena_t::current();
+            CHECK(a);
+            CHECK(a->used() == 0);
+
+            auto fib = [a](this auto&& self, int n) -> task<int, error_code, alloc_t>
+            {
+                CHECK(arena_t::current() == a);
+                CHECK(a->used() > 0); // own frame
+
+                if(n < 2)
+                    DSK_RETURN(n);
+
+                DSK_RETURN(DSK_TRY self(n - 1) + DSK_TRY self(n - 2));
+            };
+
+            int v = DSK_TRY fib(10);
+            CHECK(v == fib_sync(10));
+            CHECK(a->used() == 0); // all child frames released
+
+            // children finish in any order
+            auto vs = DSK_TRY until_all_done(fib(5), fib(6), fib(7));
+            CHECK(get_val(std::get<0>(vs)) == fib_sync(5));
+            CHECK(get_val(std::get<1>(vs)) == fib_sync(6));
+            CHECK(get_val(std::get<2>(vs)) == fib_sync(7));
+            CHECK(a->used() == 0);
+
+            // overflow to heap
+            auto deep = [](this auto&& self, int n) -> task<int, error_code, alloc_t>
+            {
+                if(n == 0)
+                    DSK_RETURN(0);
+
+                DSK_RETURN(DSK_TRY self(n - 1) + 1);
+            };
+
+            v = DSK_TRY deep(200);
+            CHECK(v == 200);
+            CHECK(a->used() == 0);
+
+            DSK_RETURN(v);
+        }());
+
+        CHECK(! has_err(r));
+        CHECK(! arena_t::current());
+
+    } // SUBCASE("frame_arena")
+
+
+    SUBCASE("pooled_async_op_group")
+    {
+        simple_thread_pool sch(start_now);
+
+        atomic<int> nDone = 0;
+
+        auto r = sync_wait([&]() -> task<>
+        {
+            auto grp = DSK_WAIT make_pooled_async_op_group([&](auto&){ ++nDone; });
+
+            for(int i = 0; i < 1000; ++i)
+            {
+                grp.add_and_initiate(start_on(sch, [](auto& sch, int i) -> task<>
+                {
+                    if(i % 100 == 0)
+                        DSK_TRY resume_on(sch);
+
+                    DSK_RETURN();
+                }(sch, i)));
+            }
+
+            DSK_TRY grp.until_all_done();
+            CHECK(grp.size() == 0);
+
+            // reusable after until_all_done() finished
+            for(int i = 0; i < 10; ++i)
+            {
+                grp.add_and_initiate(start_on(sch, [](auto& sch) -> task<>
+                {
+                    DSK_TRY resume_on(sch);
+                    DSK_RETURN();
+                }(sch)));
+            }
+
+            DSK_TRY grp.until_all_done();
+            CHECK(grp.size() == 0);
+
+            DSK_RETURN();
+        }());
+
+        CHECK(! has_err(r));
+        CHECK(nDone == 1010);
+
+        // on early exit, pending ops are still waited by cleanup scope.
+        nDone = 0;
+
+        r = sync_wait([&]() -> task<>
+        {
+            auto grp = DSK_WAIT make_pooled_async_op_group([&](auto&){ ++nDone; });
+
+            for(int i = 0; i < 4; ++i)
+            {
+                grp.add_and_initiate(wait_for(std::chrono::milliseconds(50)));
+            }
+
+            DSK_THROW(errc::failed);
+            DSK_RETURN();
+        }());
+
+        CHECK(is_err(r, errc::failed));
+        CHECK(nDone == 4);
+
+    } // SUBCASE("pooled_async_op_group")
+
 } // TEST_CASE("basic")